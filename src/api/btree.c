@@ -34,6 +34,13 @@ BTreeUNode* createBTreeU() {
     return new_node;
 }
 
+void destroyBTreeU(BTreeUNode* tree) {
+    if (tree->type == PARENT)
+        for (size_t i = 0; i < tree->object.parent.num_children; i++)
+            destroyBTreeU(tree->object.parent.children[i]);
+    free(tree);
+}
+
 bool insertValueParentU(BTreeUParent* parent, int value, int index);
 bool insertValueLeafU(BTreeULeaf* leaf, int value, int index);
 
@@ -195,6 +202,8 @@ void insertValueU(BTreeUNode** tree, int value, int index) {
                 // allocate a new root and a new parent
                 BTreeUNode* new_root = malloc(sizeof(BTreeUNode));
                 BTreeUNode* new_parent = malloc(sizeof(BTreeUNode));
+                new_root->type = PARENT;
+                new_parent->type = PARENT;
                 createBTreeUParent(&(new_root->object.parent));
                 createBTreeUParent(&(new_parent->object.parent));
                 BTreeUNode* old_root = root;
@@ -242,6 +251,7 @@ void insertValueU(BTreeUNode** tree, int value, int index) {
                 BTreeUNode* new_root = malloc(sizeof(BTreeUNode));
                 BTreeUNode* new_leaf = malloc(sizeof(BTreeUNode));
                 new_leaf->type = LEAF;
+                new_root->type = PARENT;
                 createBTreeUParent(&(new_root->object.parent));
                 createBTreeULeaf(&(new_leaf->object.leaf));
                 BTreeUNode* old_leaf = *tree;
@@ -702,6 +712,13 @@ BTreeCNode* createBTreeC() {
     return new_node;
 }
 
+void destroyBTreeC(BTreeCNode* tree) {
+    if (tree->type == PARENT)
+        for (size_t i = 0; i < tree->object.parent.num_children; i++)
+            destroyBTreeC(tree->object.parent.children[i]);
+    free(tree);
+}
+
 int insertValueParentC(BTreeCParent* parent, int value);
 int insertValueLeafC(BTreeCLeaf* leaf, int value);
 
@@ -866,6 +883,8 @@ size_t insertValueC(BTreeCNode** tree, int value) {
                 // allocate a new root and a new parent
                 BTreeCNode* new_root = malloc(sizeof(BTreeCNode));
                 BTreeCNode* new_parent = malloc(sizeof(BTreeCNode));
+                new_root->type = PARENT;
+                new_parent->type = PARENT;
                 createBTreeCParent(&(new_root->object.parent));
                 createBTreeCParent(&(new_parent->object.parent));
                 BTreeCNode* old_root = root;
@@ -912,6 +931,7 @@ size_t insertValueC(BTreeCNode** tree, int value) {
                 BTreeCNode* new_root = malloc(sizeof(BTreeCNode));
                 BTreeCNode* new_leaf = malloc(sizeof(BTreeCNode));
                 new_leaf->type = LEAF;
+                new_root->type = PARENT;
                 createBTreeCParent(&(new_root->object.parent));
                 createBTreeCLeaf(&(new_leaf->object.leaf));
                 BTreeCNode* old_leaf = *tree;
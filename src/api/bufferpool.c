@@ -0,0 +1,174 @@
+#define _XOPEN_SOURCE 600
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "api/bufferpool.h"
+#include "api/column.h"
+#include "util/log.h"
+
+#define POOL_BUCKETS (2 * BUFFER_POOL_PAGES)
+
+typedef struct Frame {
+    Column* column;
+    size_t page_no;
+    int pin_count;
+    // CLOCK reference bit
+    bool referenced;
+    // next frame in the same hash bucket, or -1
+    int next;
+    void* data;
+} Frame;
+
+static Frame frames[BUFFER_POOL_PAGES];
+static int buckets[POOL_BUCKETS];
+static size_t frames_used = 0;
+static size_t clock_hand = 0;
+static bool pool_ready = false;
+// loader threads read paged tables while the main thread runs queries
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void initPool() {
+    for (size_t i = 0; i < POOL_BUCKETS; i++)
+        buckets[i] = -1;
+    pool_ready = true;
+}
+
+static size_t bucketOf(Column* column, size_t page_no) {
+    uint64_t key = (uint64_t) (uintptr_t) column ^ ((uint64_t) page_no * 0x9E3779B97F4A7C15ULL);
+    return (size_t) ((key ^ (key >> 29)) % POOL_BUCKETS);
+}
+
+static int findFrame(Column* column, size_t page_no) {
+    for (int i = buckets[bucketOf(column, page_no)]; i >= 0; i = frames[i].next)
+        if (frames[i].column == column && frames[i].page_no == page_no)
+            return i;
+    return -1;
+}
+
+static void unlinkFrame(int frame) {
+    int* link = &buckets[bucketOf(frames[frame].column, frames[frame].page_no)];
+    while (*link != frame)
+        link = &frames[*link].next;
+    *link = frames[frame].next;
+    frames[frame].column = NULL;
+}
+
+// picks a frame to reuse: an unused one while there are any, otherwise the
+// first unpinned frame the clock hand finds without its reference bit
+static int victimFrame() {
+    if (frames_used < BUFFER_POOL_PAGES) {
+        Frame* frame = &frames[frames_used];
+        frame->data = malloc(POOL_PAGE_SIZE);
+        if (frame->data == NULL)
+            return -1;
+        frame->column = NULL;
+        return frames_used++;
+    }
+    // two sweeps clear every reference bit, so a third finds nothing new
+    for (size_t i = 0; i < 3 * BUFFER_POOL_PAGES; i++) {
+        Frame* frame = &frames[clock_hand];
+        int current = clock_hand;
+        clock_hand = (clock_hand + 1) % BUFFER_POOL_PAGES;
+        if (frame->pin_count > 0)
+            continue;
+        if (frame->referenced) {
+            frame->referenced = false;
+            continue;
+        }
+        if (frame->column != NULL)
+            unlinkFrame(current);
+        return current;
+    }
+    return -1;
+}
+
+size_t pageRows(Column* column) {
+    return POOL_PAGE_SIZE / typeWidth(column->type);
+}
+
+bool pageColumn(Column* column, const char* path, size_t num_rows) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    free(column->data);
+    column->data = NULL;
+    column->page_fd = fd;
+    column->paged_rows = num_rows;
+    column->paged = true;
+    return true;
+}
+
+const void* pinPage(Column* column, size_t page_no) {
+    pthread_mutex_lock(&pool_lock);
+    if (!pool_ready)
+        initPool();
+    int frame = findFrame(column, page_no);
+    if (frame < 0) {
+        frame = victimFrame();
+        if (frame < 0) {
+            pthread_mutex_unlock(&pool_lock);
+            log_err("-- Buffer pool exhausted; every page is pinned.\n");
+            return NULL;
+        }
+
+        // the last page of a column may be partial
+        size_t width = typeWidth(column->type);
+        size_t first_row = page_no * pageRows(column);
+        size_t num_rows = column->paged_rows - first_row;
+        if (num_rows > pageRows(column))
+            num_rows = pageRows(column);
+        ssize_t bytes = pread(column->page_fd, frames[frame].data, num_rows * width, first_row * width);
+        if (bytes < (ssize_t) (num_rows * width)) {
+            pthread_mutex_unlock(&pool_lock);
+            log_err("-- Unable to read page %zu of column %s.\n", page_no, column->name);
+            return NULL;
+        }
+
+        size_t bucket = bucketOf(column, page_no);
+        frames[frame].column = column;
+        frames[frame].page_no = page_no;
+        frames[frame].pin_count = 0;
+        frames[frame].next = buckets[bucket];
+        buckets[bucket] = frame;
+    }
+    frames[frame].pin_count++;
+    frames[frame].referenced = true;
+    const void* data = frames[frame].data;
+    pthread_mutex_unlock(&pool_lock);
+    return data;
+}
+
+void unpinPage(Column* column, size_t page_no) {
+    pthread_mutex_lock(&pool_lock);
+    int frame = findFrame(column, page_no);
+    if (frame >= 0 && frames[frame].pin_count > 0)
+        frames[frame].pin_count--;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void prefetchPages(Column* column, size_t page_no) {
+    size_t page_bytes = pageRows(column) * typeWidth(column->type);
+    posix_fadvise(column->page_fd, (page_no + 1) * page_bytes, PREFETCH_PAGES * page_bytes, POSIX_FADV_WILLNEED);
+}
+
+void evictColumn(Column* column) {
+    if (!column->paged)
+        return;
+    pthread_mutex_lock(&pool_lock);
+    for (size_t i = 0; i < frames_used; i++) {
+        if (frames[i].column == column) {
+            unlinkFrame(i);
+            frames[i].pin_count = 0;
+            frames[i].referenced = false;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+    close(column->page_fd);
+    column->page_fd = -1;
+    column->paged = false;
+    column->paged_rows = 0;
+}
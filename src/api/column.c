@@ -0,0 +1,255 @@
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "api/column.h"
+#include "api/bufferpool.h"
+
+size_t typeWidth(DataType type) {
+    switch (type) {
+        case BYTE:
+            return sizeof(int8_t);
+        case SHORT:
+            return sizeof(int16_t);
+        case INT:
+            return sizeof(int);
+        case LONG:
+            return sizeof(long);
+        case FLOAT:
+            return sizeof(float);
+        case DOUBLE:
+            return sizeof(double);
+    }
+    return sizeof(int);
+}
+
+bool parseDataType(const char* name, DataType* type) {
+    if (strcmp(name, "byte") == 0)
+        *type = BYTE;
+    else if (strcmp(name, "short") == 0)
+        *type = SHORT;
+    else if (strcmp(name, "int") == 0)
+        *type = INT;
+    else if (strcmp(name, "long") == 0)
+        *type = LONG;
+    else
+        return false;
+    return true;
+}
+
+const char* dataTypeName(DataType type) {
+    switch (type) {
+        case BYTE:
+            return "byte";
+        case SHORT:
+            return "short";
+        case INT:
+            return "int";
+        case LONG:
+            return "long";
+        case FLOAT:
+            return "float";
+        case DOUBLE:
+            return "double";
+    }
+    return "int";
+}
+
+bool isIntegerType(DataType type) {
+    return type == BYTE || type == SHORT || type == INT || type == LONG;
+}
+
+bool fitsType(DataType type, long value) {
+    switch (type) {
+        case BYTE:
+            return value >= INT8_MIN && value <= INT8_MAX;
+        case SHORT:
+            return value >= INT16_MIN && value <= INT16_MAX;
+        case INT:
+            return value >= INT32_MIN && value <= INT32_MAX;
+        default:
+            return true;
+    }
+}
+
+// reads a value of a paged column that lives in the column file; fails if
+// its page can't be pinned
+static bool getPagedValue(Column* column, size_t row, long* value) {
+    size_t page_no = row / pageRows(column);
+    const void* page = pinPage(column, page_no);
+    if (page == NULL)
+        return false;
+    Column view = { .type = column->type, .data = (void*) page };
+    *value = getValue(&view, row % pageRows(column));
+    unpinPage(column, page_no);
+    return true;
+}
+
+bool readValue(Column* column, size_t row, long* value) {
+    if (column->paged && row < column->paged_rows)
+        return getPagedValue(column, row, value);
+    *value = getValue(column, row);
+    return true;
+}
+
+long getValue(Column* column, size_t row) {
+    if (column->paged) {
+        // paged rows may fail to be read, so only readValue() reads them
+        assert(row >= column->paged_rows);
+        row -= column->paged_rows;
+    }
+    switch (column->type) {
+        case BYTE:
+            return ((int8_t*) column->data)[row];
+        case SHORT:
+            return ((int16_t*) column->data)[row];
+        case LONG:
+            return ((long*) column->data)[row];
+        default:
+            return ((int*) column->data)[row];
+    }
+}
+
+void setValue(Column* column, size_t row, long value) {
+    // paged rows are never written; see unpageColumn()
+    if (column->paged)
+        row -= column->paged_rows;
+    switch (column->type) {
+        case BYTE:
+            ((int8_t*) column->data)[row] = (int8_t) value;
+            break;
+        case SHORT:
+            ((int16_t*) column->data)[row] = (int16_t) value;
+            break;
+        case LONG:
+            ((long*) column->data)[row] = value;
+            break;
+        default:
+            ((int*) column->data)[row] = (int) value;
+            break;
+    }
+}
+
+bool resizeColumn(Column* column, size_t capacity) {
+    if (column->paged)
+        capacity -= column->paged_rows;
+    void* new_data = realloc(column->data, capacity * typeWidth(column->type));
+    if (new_data == NULL)
+        return false;
+    column->data = new_data;
+    return true;
+}
+
+void shiftColumn(Column* column, size_t from, size_t num_rows) {
+    if (column->paged) {
+        from -= column->paged_rows;
+        num_rows -= column->paged_rows;
+    }
+    if (from >= num_rows)
+        return;
+    size_t width = typeWidth(column->type);
+    char* data = (char*) column->data;
+    memmove(data + (from + 1) * width, data + from * width, (num_rows - from) * width);
+}
+
+bool lowerBound(Column* column, size_t num_rows, long value, size_t* row) {
+    size_t low = 0;
+    size_t high = num_rows;
+    while (low < high) {
+        size_t current = (low + high) / 2;
+        long current_value;
+        if (!readValue(column, current, &current_value))
+            return false;
+        if (current_value < value)
+            low = current + 1;
+        else
+            high = current;
+    }
+    *row = low;
+    return true;
+}
+
+size_t insertSortedColumn(Column* column, long value, size_t num_rows) {
+    // the column is in memory, so the search can't fail
+    size_t index = 0;
+    lowerBound(column, num_rows, value, &index);
+    shiftColumn(column, index, num_rows);
+    setValue(column, index, value);
+    return index;
+}
+
+bool getChunk(Column* column, size_t row, size_t num_rows, ColumnChunk* chunk) {
+    size_t width = typeWidth(column->type);
+    chunk->pinned = false;
+    if (!column->paged || row >= column->paged_rows) {
+        // the rest of the rows are contiguous in memory
+        size_t offset = column->paged ? column->paged_rows : 0;
+        chunk->data = (char*) column->data + (row - offset) * width;
+        chunk->first_row = row;
+        chunk->num_rows = num_rows - row;
+        return true;
+    }
+    size_t rows_per_page = pageRows(column);
+    chunk->page_no = row / rows_per_page;
+    chunk->first_row = chunk->page_no * rows_per_page;
+    const void* page = pinPage(column, chunk->page_no);
+    if (page == NULL)
+        return false;
+    chunk->pinned = true;
+    // a scan entering a page at its start is likely to want the next ones
+    if (row == chunk->first_row)
+        prefetchPages(column, chunk->page_no);
+    chunk->data = (const char*) page + (row - chunk->first_row) * width;
+    chunk->num_rows = rows_per_page - (row - chunk->first_row);
+    if (chunk->first_row + rows_per_page > column->paged_rows)
+        chunk->num_rows = column->paged_rows - row;
+    if (row + chunk->num_rows > num_rows)
+        chunk->num_rows = num_rows - row;
+    chunk->first_row = row;
+    return true;
+}
+
+void releaseChunk(Column* column, ColumnChunk* chunk) {
+    if (chunk->pinned)
+        unpinPage(column, chunk->page_no);
+    chunk->pinned = false;
+}
+
+bool readRows(Column* column, size_t from, size_t num_rows, void* out) {
+    size_t width = typeWidth(column->type);
+    size_t end = from + num_rows;
+    ColumnChunk chunk;
+    for (size_t row = from; row < end; row += chunk.num_rows) {
+        if (!getChunk(column, row, end, &chunk))
+            return false;
+        memcpy((char*) out + (row - from) * width, chunk.data, chunk.num_rows * width);
+        releaseChunk(column, &chunk);
+    }
+    return true;
+}
+
+bool unpageColumn(Column* column, size_t capacity) {
+    if (!column->paged)
+        return true;
+    size_t width = typeWidth(column->type);
+    size_t paged_rows = column->paged_rows;
+    void* data = malloc(capacity * width);
+    if (data == NULL || !readRows(column, 0, paged_rows, data)) {
+        free(data);
+        return false;
+    }
+    // the in-memory tail follows the rows that were paged
+    if (column->data != NULL)
+        memcpy((char*) data + paged_rows * width, column->data, (capacity - paged_rows) * width);
+    evictColumn(column);
+    free(column->data);
+    column->data = data;
+    return true;
+}
+
+bool unpageTable(Table* table) {
+    for (size_t i = 0; i < table->col_count; i++)
+        if (!unpageColumn(table->columns[i], table->capacity))
+            return false;
+    return true;
+}
@@ -0,0 +1,167 @@
+#include <string.h>
+
+#include "api/column.h"
+#include "api/composite.h"
+
+bool resizeColumnIndex(Index* index, size_t capacity) {
+    ColumnIndex* cindex = index->object->column;
+    if (cindex->values != NULL && capacity <= cindex->capacity)
+        return true;
+    int* new_values = realloc(cindex->values, sizeof(int) * capacity);
+    if (new_values == NULL)
+        return false;
+    cindex->values = new_values;
+    int* new_indexes = realloc(cindex->indexes, sizeof(int) * capacity);
+    if (new_indexes == NULL)
+        return false;
+    cindex->indexes = new_indexes;
+
+    // copies are stored like the columns they come from
+    if (cindex->keys == NULL && index->num_keys > 0) {
+        if ((cindex->keys = calloc(index->num_keys, sizeof(Column))) == NULL)
+            return false;
+        for (size_t k = 0; k < index->num_keys; k++)
+            cindex->keys[k].type = index->keys[k]->type;
+    }
+    if (cindex->payloads == NULL && index->num_included > 0) {
+        if ((cindex->payloads = calloc(index->num_included, sizeof(Column))) == NULL)
+            return false;
+        for (size_t k = 0; k < index->num_included; k++)
+            cindex->payloads[k].type = index->included[k]->type;
+    }
+    for (size_t k = 0; k < index->num_keys; k++)
+        if (!resizeColumn(&cindex->keys[k], capacity))
+            return false;
+    for (size_t k = 0; k < index->num_included; k++)
+        if (!resizeColumn(&cindex->payloads[k], capacity))
+            return false;
+    cindex->capacity = capacity;
+    return true;
+}
+
+// compares the key of an entry with the key of a row; rows are inserted
+// into the index once they're in memory
+static int compareEntry(Index* index, size_t entry, size_t row) {
+    ColumnIndex* cindex = index->object->column;
+    long a = cindex->values[entry];
+    long b = getValue(index->column, row);
+    for (size_t k = 0; a == b && k < index->num_keys; k++) {
+        a = getValue(&cindex->keys[k], entry);
+        b = getValue(index->keys[k], row);
+    }
+    return (a > b) - (a < b);
+}
+
+// the index whose rows buildColumnIndex() is sorting; qsort takes no context
+static __thread Index* sort_index;
+// set when a row of a paged column couldn't be read during a build
+static __thread bool read_failed;
+
+// reads a row of an indexed column, noting a failure for the build
+static long readRow(Column* column, size_t row) {
+    long value = 0;
+    if (!readValue(column, row, &value))
+        read_failed = true;
+    return value;
+}
+
+// orders rows by key, then by position
+static int compareRows(const void* a, const void* b) {
+    size_t x = *(const int*) a;
+    size_t y = *(const int*) b;
+    long value_x = readRow(sort_index->column, x);
+    long value_y = readRow(sort_index->column, y);
+    for (size_t k = 0; value_x == value_y && k < sort_index->num_keys; k++) {
+        value_x = readRow(sort_index->keys[k], x);
+        value_y = readRow(sort_index->keys[k], y);
+    }
+    if (value_x != value_y)
+        return (value_x > value_y) - (value_x < value_y);
+    return (x > y) - (x < y);
+}
+
+bool buildColumnIndex(Index* index, size_t num_rows, size_t capacity) {
+    if (capacity < num_rows)
+        capacity = num_rows;
+    if (capacity == 0)
+        capacity = 1;
+    if (!resizeColumnIndex(index, capacity))
+        return false;
+
+    // sort the rows once rather than inserting them one by one
+    ColumnIndex* cindex = index->object->column;
+    for (size_t i = 0; i < num_rows; i++)
+        cindex->indexes[i] = (int) i;
+    sort_index = index;
+    read_failed = false;
+    qsort(cindex->indexes, num_rows, sizeof(int), compareRows);
+    for (size_t i = 0; i < num_rows; i++) {
+        size_t row = cindex->indexes[i];
+        cindex->values[i] = (int) readRow(index->column, row);
+        for (size_t k = 0; k < index->num_keys; k++)
+            setValue(&cindex->keys[k], i, readRow(index->keys[k], row));
+        for (size_t k = 0; k < index->num_included; k++)
+            setValue(&cindex->payloads[k], i, readRow(index->included[k], row));
+    }
+    cindex->version++;
+    return !read_failed;
+}
+
+void insertIndexRow(Index* index, size_t row, size_t total) {
+    ColumnIndex* cindex = index->object->column;
+    size_t low = 0;
+    size_t high = total;
+    while (high > low) {
+        size_t current = (low + high) / 2;
+        if (compareEntry(index, current, row) < 0)
+            low = current + 1;
+        else
+            high = current;
+    }
+
+    // low is the first entry whose key is >= the row's
+    memmove(cindex->values + low + 1, cindex->values + low, sizeof(int) * (total - low));
+    memmove(cindex->indexes + low + 1, cindex->indexes + low, sizeof(int) * (total - low));
+    cindex->values[low] = (int) getValue(index->column, row);
+    cindex->indexes[low] = (int) row;
+    for (size_t k = 0; k < index->num_keys; k++) {
+        shiftColumn(&cindex->keys[k], low, total);
+        setValue(&cindex->keys[k], low, getValue(index->keys[k], row));
+    }
+    for (size_t k = 0; k < index->num_included; k++) {
+        shiftColumn(&cindex->payloads[k], low, total);
+        setValue(&cindex->payloads[k], low, getValue(index->included[k], row));
+    }
+    cindex->version++;
+}
+
+// the copy of the column the index keeps, NULL for its first key column
+static Column* findCopy(Index* index, Column* column) {
+    ColumnIndex* cindex = index->object->column;
+    for (size_t k = 0; k < index->num_keys; k++)
+        if (index->keys[k] == column)
+            return &cindex->keys[k];
+    for (size_t k = 0; k < index->num_included; k++)
+        if (index->included[k] == column)
+            return &cindex->payloads[k];
+    return NULL;
+}
+
+bool indexCovers(Index* index, Column* column) {
+    if (index->type != SORTED || index->clustered)
+        return false;
+    return index->column == column || findCopy(index, column) != NULL;
+}
+
+void readCovered(Index* index, Column* column, size_t from, size_t count, void* out) {
+    ColumnIndex* cindex = index->object->column;
+    Column* copy = findCopy(index, column);
+    if (copy != NULL) {
+        size_t width = typeWidth(column->type);
+        memcpy(out, (char*) copy->data + from * width, count * width);
+        return;
+    }
+    Column view = { .type = column->type, .data = out };
+    for (size_t i = 0; i < count; i++)
+        setValue(&view, i, cindex->values[from + i]);
+}
@@ -82,3 +82,30 @@ void destroyColumnHandle(GeneralizedColumnHandle handle) {
             break;
     }
 }
+
+PreparedStatement* findStatement(ClientContext* context, char* name) {
+    for (int i = 0; i < context->statements_in_use; i++)
+        if (strcmp(context->statements[i].name, name) == 0)
+            return &(context->statements[i]);
+    return NULL;
+}
+
+// stores a prepared statement, replacing any earlier one with the same name
+bool addStatement(ClientContext* context, PreparedStatement* statement) {
+    PreparedStatement* existing = findStatement(context, statement->name);
+    if (existing != NULL) {
+        free(existing->memory);
+        *existing = *statement;
+        return true;
+    }
+    if (context->statements_in_use == context->statement_slots) {
+        int new_size = (context->statement_slots == 0) ? 1 : 2 * context->statement_slots;
+        PreparedStatement* new_statements = realloc(context->statements, new_size * sizeof(PreparedStatement));
+        if (new_statements == NULL)
+            return false;
+        context->statements = new_statements;
+        context->statement_slots = new_size;
+    }
+    context->statements[context->statements_in_use++] = *statement;
+    return true;
+}
@@ -0,0 +1,221 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/column.h"
+#include "api/cracker.h"
+
+bool shouldCrack(Table* table, Column* column) {
+    // the copy of a paged column wouldn't fit in memory either
+    if (column->paged || table->num_rows < CRACK_MIN_ROWS)
+        return false;
+    for (size_t i = 0; i < table->num_indexes; i++)
+        if (table->indexes[i]->column == column)
+            return false;
+    return true;
+}
+
+void freeCracker(CrackerColumn* cracker) {
+    if (cracker == NULL)
+        return;
+    free(cracker->values);
+    free(cracker->rows);
+    free(cracker->pivots);
+    free(cracker->positions);
+    free(cracker);
+}
+
+void dropCrackers(Table* table) {
+    for (size_t i = 0; i < table->col_count; i++) {
+        freeCracker(table->columns[i]->cracker);
+        table->columns[i]->cracker = NULL;
+    }
+}
+
+static bool growCracker(CrackerColumn* cracker, size_t capacity) {
+    if (capacity <= cracker->capacity)
+        return true;
+    long* values = realloc(cracker->values, sizeof(long) * capacity);
+    if (values == NULL)
+        return false;
+    cracker->values = values;
+    int* rows = realloc(cracker->rows, sizeof(int) * capacity);
+    if (rows == NULL)
+        return false;
+    cracker->rows = rows;
+    cracker->capacity = capacity;
+    return true;
+}
+
+// the number of pivots that are at most value, which is also the piece the
+// value belongs to
+static size_t upperPivot(CrackerColumn* cracker, long value) {
+    size_t low = 0;
+    size_t high = cracker->num_pivots;
+    while (low < high) {
+        size_t current = (low + high) / 2;
+        if (cracker->pivots[current] <= value)
+            low = current + 1;
+        else
+            high = current;
+    }
+    return low;
+}
+
+// adds the column's rows past the copy to it. Each one is rippled into its
+// piece: the first entry of every later piece moves to the end of that
+// piece, which opens a slot at the end of the right one.
+static bool rippleRows(CrackerColumn* cracker, Column* column, size_t num_rows) {
+    if (!growCracker(cracker, num_rows > 2 * cracker->capacity ? num_rows : 2 * cracker->capacity))
+        return false;
+    for (size_t row = cracker->num_rows; row < num_rows; row++) {
+        long value;
+        if (!readValue(column, row, &value))
+            return false;
+        size_t piece = upperPivot(cracker, value);
+        size_t hole = cracker->num_rows;
+        for (size_t p = cracker->num_pivots; p > piece; p--) {
+            size_t first = cracker->positions[p - 1];
+            cracker->values[hole] = cracker->values[first];
+            cracker->rows[hole] = cracker->rows[first];
+            cracker->positions[p - 1]++;
+            hole = first;
+        }
+        cracker->values[hole] = value;
+        cracker->rows[hole] = (int) row;
+        cracker->num_rows++;
+    }
+    return true;
+}
+
+static CrackerColumn* createCracker(Column* column, size_t num_rows) {
+    CrackerColumn* cracker = calloc(1, sizeof(CrackerColumn));
+    if (cracker == NULL)
+        return NULL;
+    if (!growCracker(cracker, num_rows)) {
+        freeCracker(cracker);
+        return NULL;
+    }
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk)) {
+            freeCracker(cracker);
+            return NULL;
+        }
+        Column view = { .type = column->type, .data = (void*) chunk.data };
+        for (size_t i = 0; i < chunk.num_rows; i++) {
+            cracker->values[row + i] = getValue(&view, i);
+            cracker->rows[row + i] = (int) (row + i);
+        }
+        releaseChunk(column, &chunk);
+    }
+    cracker->num_rows = num_rows;
+    return cracker;
+}
+
+// partitions the piece holding value around it and records the split;
+// returns the first position whose value is >= value
+static bool crack(CrackerColumn* cracker, long value, size_t* position) {
+    size_t piece = upperPivot(cracker, value);
+    if (piece > 0 && cracker->pivots[piece - 1] == value) {
+        *position = cracker->positions[piece - 1];
+        return true;
+    }
+
+    size_t low = (piece > 0) ? cracker->positions[piece - 1] : 0;
+    size_t high = (piece < cracker->num_pivots) ? cracker->positions[piece] : cracker->num_rows;
+    while (low < high) {
+        if (cracker->values[low] < value) {
+            low++;
+            continue;
+        }
+        high--;
+        long tmp_value = cracker->values[low];
+        cracker->values[low] = cracker->values[high];
+        cracker->values[high] = tmp_value;
+        int tmp_row = cracker->rows[low];
+        cracker->rows[low] = cracker->rows[high];
+        cracker->rows[high] = tmp_row;
+    }
+
+    if (cracker->num_pivots == cracker->pivot_capacity) {
+        size_t new_capacity = (cracker->pivot_capacity == 0) ? 16 : 2 * cracker->pivot_capacity;
+        long* pivots = realloc(cracker->pivots, sizeof(long) * new_capacity);
+        if (pivots == NULL)
+            return false;
+        cracker->pivots = pivots;
+        size_t* positions = realloc(cracker->positions, sizeof(size_t) * new_capacity);
+        if (positions == NULL)
+            return false;
+        cracker->positions = positions;
+        cracker->pivot_capacity = new_capacity;
+    }
+    size_t moved = cracker->num_pivots - piece;
+    memmove(cracker->pivots + piece + 1, cracker->pivots + piece, sizeof(long) * moved);
+    memmove(cracker->positions + piece + 1, cracker->positions + piece, sizeof(size_t) * moved);
+    cracker->pivots[piece] = value;
+    cracker->positions[piece] = low;
+    cracker->num_pivots++;
+    *position = low;
+    return true;
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+long crackSelect(Column* column, size_t num_rows, long minimum, long maximum, int** positions) {
+    CrackerColumn* cracker = column->cracker;
+    if (cracker != NULL && cracker->num_rows > num_rows) {
+        freeCracker(cracker);
+        cracker = column->cracker = NULL;
+    }
+    if (cracker == NULL && (cracker = column->cracker = createCracker(column, num_rows)) == NULL)
+        return -1;
+    if (cracker->num_rows < num_rows && !rippleRows(cracker, column, num_rows))
+        return -1;
+
+    *positions = NULL;
+    if (minimum >= maximum)
+        return 0;
+    size_t from;
+    size_t to;
+    if (!crack(cracker, minimum, &from) || !crack(cracker, maximum, &to))
+        return -1;
+    size_t count = to - from;
+    if (count == 0)
+        return 0;
+    int* result = malloc(sizeof(int) * count);
+    if (result == NULL)
+        return -1;
+
+    // fetches expect positions in row order, like a scan produces them. A
+    // few are sorted; many are put in order through a bitmap of the rows,
+    // which costs a bit per row rather than a sort.
+    if (count < num_rows / 64) {
+        memcpy(result, cracker->rows + from, sizeof(int) * count);
+        qsort(result, count, sizeof(int), compareInts);
+    } else {
+        size_t num_words = (num_rows + 63) / 64;
+        uint64_t* bitmap = calloc(num_words, sizeof(uint64_t));
+        if (bitmap == NULL) {
+            free(result);
+            return -1;
+        }
+        for (size_t i = from; i < to; i++)
+            bitmap[cracker->rows[i] / 64] |= (uint64_t) 1 << (cracker->rows[i] % 64);
+        size_t out = 0;
+        for (size_t word = 0; word < num_words; word++) {
+            uint64_t bits = bitmap[word];
+            while (bits != 0) {
+                result[out++] = (int) (word * 64 + __builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+        free(bitmap);
+    }
+    *positions = result;
+    return (long) count;
+}
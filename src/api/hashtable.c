@@ -1,8 +1,9 @@
 #include "api/hashtable.h"
 #include "util/log.h"
 
-size_t hash(HashTable* ht, int key) {
-    return (key + ht->tableSize) % ht->tableSize;
+size_t hash(HashTable* ht, long key) {
+    long index = key % ht->tableSize;
+    return (size_t) (index < 0 ? index + ht->tableSize : index);
 }
 
 int destroyNode(HashNode* n, int count) {
@@ -58,8 +59,16 @@ void init(HashTable** ht) {
     *ht = newTable;
 }
 
+// free the hashtable and everything in it
+void destroy(HashTable* ht) {
+    for (int i = 0; i < ht->tableSize; i++)
+        destroyNode(ht->buckets[i], 0);
+    free(ht->buckets);
+    free(ht);
+}
+
 // insert a key-value pair into the hash table
-void put(HashTable* ht, int key, int value) {
+void put(HashTable* ht, long key, int value) {
     if (ht->count > ht->tableSize * MAX_Q)
         resize(ht);
     size_t index = hash(ht, key);
@@ -73,7 +82,7 @@ void put(HashTable* ht, int key, int value) {
         HashNode* newNode = malloc(sizeof(HashNode));
         newNode->count = 1;
         
-        newNode->keys = malloc(ht->nodeSize * sizeof(int));
+        newNode->keys = malloc(ht->nodeSize * sizeof(long));
         newNode->keys[0] = key;
         
         newNode->values = malloc(ht->nodeSize * sizeof(int));
@@ -86,13 +95,15 @@ void put(HashTable* ht, int key, int value) {
 
 // get entries with a matching key and stores the
 // corresponding values in the values array.
-int get(HashTable* ht, int key, int *values, int num_values) {
+int get(HashTable* ht, long key, int *values, int num_values) {
     int count = 0;
     int index = hash(ht, key);
     HashNode* bucket = ht->buckets[index];
 
     while (bucket != NULL) {
         for (int i = 0; i < bucket->count; i++) {
+            if (bucket->keys[i] != key)
+                continue;
             if (count < num_values) {
                 values[count] = bucket->values[i];
             }
@@ -105,7 +116,7 @@ int get(HashTable* ht, int key, int *values, int num_values) {
 }
 
 // erase a key-value pair from the hash talbe
-void erase(HashTable* ht, int key) {
+void erase(HashTable* ht, long key) {
     int index = hash(ht, key);
     HashNode* bucket = ht->buckets[index];
     ht->count -= destroyNode(bucket, 0);
@@ -1,206 +1,434 @@
+#include <pthread.h>
 #include <stdio.h>
+#include <unistd.h>
 
+#include "api/column.h"
+#include "api/composite.h"
+#include "api/bufferpool.h"
 #include "api/sorted.h"
 #include "api/persist.h"
+#include "api/statistics.h"
 #include "api/db_io.h"
+#include "api/wal.h"
 #include "query/execute.h"
 #include "util/debug.h"
 
 extern Db* current_db;
 
-bool loadColumnData() {
-    char path[MAX_SIZE_NAME * 3 + DATA_PATH_LENGTH + 3];
-    char buf[1024];
-    // iterate over every column
-    for (size_t i = 0; i < current_db->num_tables; i++) {
-        Table* curr_table = current_db->tables[i];
-        
-        // load all columns
-        for (size_t j = 0; j < curr_table->col_count; j++) {
-            Column* curr_col = curr_table->columns[j];
-            sprintf(path, "%s%s/%s/%s", DATA_PATH, current_db->name, curr_table->name, curr_col->name);
-            log_info("-- Reading in column from path %s now...\n", path);
-        
-            // column data trackers
-            size_t data_count = 0;
-            size_t data_capacity = 0;
-            int* values = NULL;
+// guards the load state of every table
+static pthread_mutex_t load_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t load_done = PTHREAD_COND_INITIALIZER;
 
-            FILE* fp = fopen(path, "r");
-            if (fp == NULL)
-                return false;
+// set while a catalog from before the version line is being converted;
+// its column files hold one value per line as text
+static bool legacy_catalog = false;
 
-            // iterate over all data in file
-            while (fgets(buf, sizeof(buf), fp)) {
-                // remove \n if necessary
-                size_t len = strlen(buf);
-                if (buf[len - 1] == '\n')
-                    buf[len - 1] = '\0';
-                else
-                    buf[len] = '\0';
-                
-                // check capacity
-                if (data_count >= data_capacity) {
-                    size_t new_size = (data_capacity == 0) ? 1 : 2 * data_capacity;
-                    if (values == NULL) {
-                        values = malloc(sizeof(int) * new_size);
-                    } else {
-                        int* new_data = realloc(values, sizeof(int) * new_size);
-                        if (new_data == NULL)
-                            return false;
-                        values = new_data;
-                    }
-                    data_capacity = new_size;
-                }
+// tables the loader threads work through, warm-up tables first
+static Table** load_queue = NULL;
+static size_t load_queue_size = 0;
+static size_t load_queue_next = 0;
+// loader threads that haven't exited yet, guarded by load_lock
+static size_t active_loaders = 0;
 
-                // insert new int value
-                values[data_count++] = atoi(buf);
-            }
+// reads a column file of a legacy catalog, which also gives the table its
+// number of rows
+static bool readLegacyColumn(Table* table, Column* column, FILE* fp, bool first) {
+    char buf[64];
+    size_t num_rows = 0;
+    size_t capacity = 0;
+    while (fgets(buf, sizeof(buf), fp)) {
+        if (num_rows == capacity) {
+            capacity = (capacity == 0) ? COL_INITIAL_SIZE : 2 * capacity;
+            if (!resizeColumn(column, capacity))
+                return false;
+        }
+        setValue(column, num_rows++, atoi(buf));
+    }
+    // every column of a table must hold the same number of rows
+    if (!first && num_rows != table->num_rows)
+        return false;
+    table->num_rows = num_rows;
+    return true;
+}
+
+// reads a table's columns and indexes from disk
+static bool loadTableData(Table* curr_table) {
+    char path[MAX_SIZE_NAME * 3 + DATA_PATH_LENGTH + 3];
+    char buf[1024];
 
-            // store new data in column
-            curr_col->data = values;
-            curr_table->num_rows = data_count;
-            curr_table->capacity = data_capacity;
+    // load all columns; files hold num_rows values at the column's width,
+    // anything past that is left over from an uncommitted checkpoint
+    size_t num_rows = curr_table->num_rows;
+    size_t row_width = 0;
+    for (size_t j = 0; j < curr_table->col_count; j++)
+        row_width += typeWidth(curr_table->columns[j]->type);
+    // tables too large to keep in memory are read through the buffer pool
+    bool paged = num_rows * row_width > PAGED_TABLE_BYTES;
+    for (size_t j = 0; j < curr_table->col_count; j++) {
+        Column* curr_col = curr_table->columns[j];
+        sprintf(path, "%s%s/%s/%s", DATA_PATH, current_db->name, curr_table->name, curr_col->name);
+        log_info("-- Reading in column from path %s now...\n", path);
 
+        if (paged) {
+            if (!pageColumn(curr_col, path, num_rows))
+                return false;
+            continue;
+        }
+        FILE* fp = fopen(path, "r");
+        if (fp == NULL)
+            return false;
+        if (legacy_catalog) {
+            bool success = readLegacyColumn(curr_table, curr_col, fp, j == 0);
             fclose(fp);
+            if (!success)
+                return false;
+            num_rows = curr_table->num_rows;
+            continue;
+        }
+        if (num_rows > 0) {
+            bool success = resizeColumn(curr_col, num_rows)
+                && fread(curr_col->data, typeWidth(curr_col->type), num_rows, fp) == num_rows;
+            if (!success) {
+                fclose(fp);
+                return false;
+            }
         }
+        fclose(fp);
+    }
+    curr_table->capacity = num_rows;
+    curr_table->persisted_rows = num_rows;
 
-        // load all indexes
-        sprintf(path, "%s%s/%s/index", DATA_PATH, current_db->name, curr_table->name);
-        FILE* fp = fopen(path, "r");
+    // catalogs written before statistics existed don't carry them
+    for (size_t j = 0; j < curr_table->col_count; j++)
+        if (curr_table->columns[j]->stats == NULL && !analyzeColumn(curr_table->columns[j], num_rows))
+            return false;
 
-        // iterate over all data in file
-        Index* curr_index = NULL;
-        int curr_capacity = 0;
-        int curr_inserted = 0;
-        while (fgets(buf, sizeof(buf), fp)) {
-            // remove \n if necessary
-            size_t len = strlen(buf);
-            if (buf[len - 1] == '\n')
-                buf[len - 1] = '\0';
-            else
-                buf[len] = '\0';
-
-            // tokenize
-            char* token1 = buf;
-            char* token2 = buf;
-            while (*token2 != ' ')
-                token2++;
-            *token2 = '\0';
+    // composite and covering indexes are rebuilt from the columns
+    for (size_t j = 0; j < curr_table->num_indexes; j++) {
+        Index* index = curr_table->indexes[j];
+        if ((index->num_keys > 0 || index->num_included > 0) && !buildColumnIndex(index, num_rows, num_rows))
+            return false;
+    }
+
+    // load all other indexes
+    sprintf(path, "%s%s/%s/index", DATA_PATH, current_db->name, curr_table->name);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL)
+        return true;
+
+    // iterate over all data in file
+    Index* curr_index = NULL;
+    int curr_capacity = 0;
+    int curr_inserted = 0;
+    while (fgets(buf, sizeof(buf), fp)) {
+        // remove \n if necessary
+        size_t len = strlen(buf);
+        if (buf[len - 1] == '\n')
+            buf[len - 1] = '\0';
+        else
+            buf[len] = '\0';
+
+        // tokenize
+        char* token1 = buf;
+        char* token2 = buf;
+        while (*token2 != ' ')
             token2++;
-                        
-            char* token3 = token2;
-            while (*token3 != ' ' && *token3 != '\0')
-                token3++;
-            bool new_table = (*token3 == ' ');
-            *token3 = '\0';
-            if (new_table) {
-                // this is a new table
-                token3++;
-                char* col_name = token1;
-                IndexType type = strcmp(token2, "B") == 0 ? BTREE : SORTED;
-                bool clustered = strcmp(token3, "C") == 0;
-
-                // find this index
-                for (size_t j = 0; j < curr_table->num_indexes; j++)
-                    if (strcmp(curr_table->indexes[j]->column->name, col_name) == 0)
-                        if (curr_table->indexes[j]->type == type && curr_table->indexes[j]->clustered == clustered)
+        *token2 = '\0';
+        token2++;
+                    
+        char* token3 = token2;
+        while (*token3 != ' ' && *token3 != '\0')
+            token3++;
+        bool new_table = (*token3 == ' ');
+        *token3 = '\0';
+        if (new_table) {
+            // this is a new table
+            token3++;
+            char* col_name = token1;
+            IndexType type = strcmp(token2, "B") == 0 ? BTREE : SORTED;
+            bool clustered = strcmp(token3, "C") == 0;
+
+            // find this index
+            for (size_t j = 0; j < curr_table->num_indexes; j++)
+                if (strcmp(curr_table->indexes[j]->column->name, col_name) == 0)
+                    if (curr_table->indexes[j]->type == type && curr_table->indexes[j]->clustered == clustered)
+                        if (curr_table->indexes[j]->num_keys == 0 && curr_table->indexes[j]->num_included == 0)
                             curr_index = curr_table->indexes[j];
 
-                // now continue
-                curr_capacity = 0;
-                curr_inserted = 0;
-                continue;
-            } else {
-                // these tokens are two new values to insert
-                int value = atoi(token1);
-                int index = atoi(token2);
-                
-                // resize unclustered sorted column if necessary
-                if (curr_index->type == SORTED && !curr_index->clustered) {
-                    if (curr_inserted >= curr_capacity - 1) {
-                        int new_size = (curr_capacity == 0) ? 1 : 2 * curr_capacity;
-                        if (new_size == 1) {
-                            curr_index->object->column->values = malloc(sizeof(int));
-                            curr_index->object->column->indexes = malloc(sizeof(int));
+            // now continue
+            curr_capacity = 0;
+            curr_inserted = 0;
+            continue;
+        } else {
+            // these tokens are two new values to insert, into an index
+            // the catalog must have named
+            if (curr_index == NULL) {
+                fclose(fp);
+                return false;
+            }
+            int value = atoi(token1);
+            int index = atoi(token2);
+            
+            // resize unclustered sorted column if necessary
+            if (curr_index->type == SORTED && !curr_index->clustered) {
+                if (curr_inserted >= curr_capacity - 1) {
+                    int new_size = (curr_capacity == 0) ? 1 : 2 * curr_capacity;
+                    if (new_size == 1) {
+                        curr_index->object->column->values = malloc(sizeof(int));
+                        curr_index->object->column->indexes = malloc(sizeof(int));
+                    } else {
+                        int* new_array1 = realloc(curr_index->object->column->values, sizeof(int) * new_size);
+                        int* new_array2 = realloc(curr_index->object->column->indexes, sizeof(int) * new_size);
+                        if (new_array1 != NULL) {
+                            curr_index->object->column->values = new_array1;
                         } else {
-                            int* new_array1 = realloc(curr_index->object->column->values, sizeof(int) * new_size);
-                            int* new_array2 = realloc(curr_index->object->column->indexes, sizeof(int) * new_size);
-                            if (new_array1 != NULL) {
-                                curr_index->object->column->values = new_array1;
-                            } else {
-                                return false;
-                            }
-                            if (new_array2 != NULL) {
-                                curr_index->object->column->indexes = new_array2;
-                            } else {
-                                return false;
-                            }
+                            fclose(fp);
+                            return false;
                         }
-                        curr_capacity = new_size;
-                    }
-                }
-
-                // insert new value into index
-                switch (curr_index->type) {
-                    case BTREE:
-                        if (curr_index->clustered) {
-                            insertValueC(&(curr_index->object->btreec), value);
+                        if (new_array2 != NULL) {
+                            curr_index->object->column->indexes = new_array2;
                         } else {
-                            insertValueU(&(curr_index->object->btreeu), value, index);
-                        }
-                        break;
-                    case SORTED:
-                        if (!curr_index->clustered) {
-                            insertIndex(curr_index->object->column, value, index, curr_inserted);
+                            fclose(fp);
+                            return false;
                         }
-                        break;
+                    }
+                    curr_capacity = new_size;
+                    curr_index->object->column->capacity = new_size;
                 }
+            }
 
-                curr_inserted++;
+            // insert new value into index
+            switch (curr_index->type) {
+                case BTREE:
+                    if (curr_index->clustered) {
+                        insertValueC(&(curr_index->object->btreec), value);
+                    } else {
+                        insertValueU(&(curr_index->object->btreeu), value, index);
+                    }
+                    break;
+                case SORTED:
+                    if (!curr_index->clustered) {
+                        insertIndex(curr_index->object->column, value, index, curr_inserted);
+                    }
+                    break;
             }
+
+            curr_inserted++;
         }
     }
+    fclose(fp);
 
-    log_info("-- Loaded column data successfully.\n");
-    printDatabase(current_db);
-
+    log_info("-- Loaded table %s.\n", curr_table->name);
     return true;
 }
 
+bool ensureTableLoaded(Table* table) {
+    if (__atomic_load_n(&table->load_state, __ATOMIC_ACQUIRE) == LOADED)
+        return true;
+
+    // wait if another thread is loading the table, otherwise claim it
+    pthread_mutex_lock(&load_lock);
+    while (table->load_state == LOADING)
+        pthread_cond_wait(&load_done, &load_lock);
+    if (table->load_state == LOADED || table->load_state == LOAD_FAILED) {
+        bool loaded = table->load_state == LOADED;
+        pthread_mutex_unlock(&load_lock);
+        return loaded;
+    }
+    table->load_state = LOADING;
+    pthread_mutex_unlock(&load_lock);
+
+    bool success = loadTableData(table);
+    if (!success)
+        log_err("-- Unable to load table %s.\n", table->name);
+
+    pthread_mutex_lock(&load_lock);
+    __atomic_store_n(&table->load_state, success ? LOADED : LOAD_FAILED, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&load_done);
+    pthread_mutex_unlock(&load_lock);
+    return success;
+}
+
+void waitForLoads() {
+    if (current_db == NULL)
+        return;
+    for (size_t i = 0; i < current_db->num_tables; i++)
+        ensureTableLoaded(current_db->tables[i]);
+    // a loader may still be looking at a table it found loaded
+    pthread_mutex_lock(&load_lock);
+    while (active_loaders > 0)
+        pthread_cond_wait(&load_done, &load_lock);
+    pthread_mutex_unlock(&load_lock);
+}
+
+static void* loadWorker(void* arg) {
+    (void) arg;
+    size_t i;
+    while ((i = __atomic_fetch_add(&load_queue_next, 1, __ATOMIC_RELAXED)) < load_queue_size)
+        ensureTableLoaded(load_queue[i]);
+    pthread_mutex_lock(&load_lock);
+    active_loaders--;
+    pthread_cond_broadcast(&load_done);
+    pthread_mutex_unlock(&load_lock);
+    return NULL;
+}
+
+// queues a table for the loader threads unless it's already queued
+static void queueTable(Table* table) {
+    for (size_t i = 0; i < load_queue_size; i++)
+        if (load_queue[i] == table)
+            return;
+    load_queue[load_queue_size++] = table;
+}
+
+// starts loading every table in the background and returns once the
+// warm-up tables are in memory
+static void startLoaders() {
+    load_queue = malloc(sizeof(Table*) * (current_db->num_tables + 1));
+    load_queue_size = 0;
+
+    // warm-up tables go first, named as tbl or db.tbl
+    size_t num_warm = 0;
+    FILE* fp = fopen(WARMUP_PATH, "r");
+    if (fp != NULL) {
+        char buf[MAX_SIZE_NAME * 2 + 2];
+        while (fgets(buf, sizeof(buf), fp)) {
+            buf[strcspn(buf, " \r\n")] = '\0';
+            char* name = strrchr(buf, '.');
+            name = (name == NULL) ? buf : name + 1;
+            for (size_t i = 0; i < current_db->num_tables; i++)
+                if (strcmp(current_db->tables[i]->name, name) == 0)
+                    queueTable(current_db->tables[i]);
+        }
+        fclose(fp);
+        num_warm = load_queue_size;
+    }
+    for (size_t i = 0; i < current_db->num_tables; i++)
+        queueTable(current_db->tables[i]);
+
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads > MAX_LOADER_THREADS)
+        num_threads = MAX_LOADER_THREADS;
+    for (long i = 0; i < num_threads; i++) {
+        pthread_t thread;
+        pthread_mutex_lock(&load_lock);
+        active_loaders++;
+        pthread_mutex_unlock(&load_lock);
+        if (pthread_create(&thread, NULL, loadWorker, NULL) == 0) {
+            pthread_detach(thread);
+        } else {
+            pthread_mutex_lock(&load_lock);
+            active_loaders--;
+            pthread_mutex_unlock(&load_lock);
+        }
+    }
+
+    // wait for (or help with) the warm-up tables
+    for (size_t i = 0; i < num_warm; i++)
+        ensureTableLoaded(load_queue[i]);
+    log_info("-- Loaded %zu warm-up tables.\n", num_warm);
+}
+
+// flushes a file all the way to disk before closing it
+bool closeDurably(FILE* fp) {
+    bool success = fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    return fclose(fp) == 0 && success;
+}
+
+// moves the files of a checkpoint into place if its catalog was committed,
+// otherwise throws them away
+void finishCheckpoint(bool committed) {
+    char path[MAX_SIZE_NAME * 3 + DATA_PATH_LENGTH + 30];
+    char tmp_path[sizeof(path) + 4];
+    for (size_t i = 0; i < current_db->num_tables; i++) {
+        Table* curr_table = current_db->tables[i];
+        for (size_t j = 0; j <= curr_table->col_count; j++) {
+            // the last file of every table is its index file
+            char* name = (j < curr_table->col_count) ? curr_table->columns[j]->name : "index";
+            sprintf(path, "%s%s/%s/%s", DATA_PATH, current_db->name, curr_table->name, name);
+            sprintf(tmp_path, "%s.tmp", path);
+            if (committed)
+                rename(tmp_path, path);
+            else
+                unlink(tmp_path);
+        }
+    }
+}
+
+// writes the rows of a column that changed since the last checkpoint. Rows
+// appended past the persisted ones are written in place, segment by
+// segment, as loading ignores anything past the committed row count. A
+// column whose persisted rows moved is rewritten into a .tmp file that
+// finishCheckpoint() moves into place once the catalog is committed.
+bool writeColumn(Table* table, Column* column) {
+    char path[MAX_SIZE_NAME * 3 + DATA_PATH_LENGTH + 30];
+    char tmp_path[sizeof(path) + 4];
+    sprintf(path, "%s%s/%s/%s", DATA_PATH, current_db->name, table->name, column->name);
+    sprintf(tmp_path, "%s.tmp", path);
+
+    size_t from = 0;
+    FILE* fp = NULL;
+    if (column->dirty_from >= table->persisted_rows) {
+        // a leftover from a failed checkpoint must not replace this file
+        unlink(tmp_path);
+        from = column->dirty_from - column->dirty_from % CHECKPOINT_SEGMENT_ROWS;
+        fp = fopen(path, "r+");
+        if (fp == NULL)
+            fp = fopen(path, "w+");
+    } else {
+        fp = fopen(tmp_path, "w+");
+    }
+    if (fp == NULL)
+        return false;
+
+    size_t width = typeWidth(column->type);
+    if (fseek(fp, from * width, SEEK_SET) != 0)
+        return false;
+    // segments are staged in a buffer since paged rows aren't in memory
+    char segment[CHECKPOINT_SEGMENT_ROWS * sizeof(long)];
+    for (size_t row = from; row < table->num_rows; row += CHECKPOINT_SEGMENT_ROWS) {
+        size_t count = table->num_rows - row;
+        if (count > CHECKPOINT_SEGMENT_ROWS)
+            count = CHECKPOINT_SEGMENT_ROWS;
+        if (!readRows(column, row, count, segment) || fwrite(segment, width, count, fp) != count)
+            return false;
+    }
+    return closeDurably(fp);
+}
+
+// writes every column and index that changed since the last checkpoint
 bool writeColumnData() {
     char path[MAX_SIZE_NAME * 3 + DATA_PATH_LENGTH + 30];
     // iterate over every table
     for (size_t i = 0; i < current_db->num_tables; i++) {
         Table* curr_table = current_db->tables[i];
+        // a table that failed to load is never written; its files stay as
+        // they were for the next start
+        if (!curr_table->dirty || curr_table->load_state != LOADED)
+            continue;
         
-        // write each column to file
+        // write each changed column to file
+        bool indexes_dirty = false;
         for (size_t j = 0; j < curr_table->col_count; j++) {
-            Column* curr_col = curr_table->columns[j];
-            sprintf(path, "%s%s/%s/%s", DATA_PATH, current_db->name, curr_table->name, curr_col->name);
-
-            FILE* fp = fopen(path, "w+");
-            if (fp == NULL)
+            if (curr_table->columns[j]->dirty && !writeColumn(curr_table, curr_table->columns[j]))
                 return false;
-            
-            // iterate over all data in file
-            for (size_t k = 0; k < curr_table->num_rows; k++) {
-                if (fprintf(fp, "%i\n", curr_col->data[k]) < 0)
-                    return false;
-            }
-
-            // fclose(fp);
         }
+        for (size_t j = 0; j < curr_table->num_indexes; j++)
+            indexes_dirty |= curr_table->indexes[j]->dirty;
+        if (!indexes_dirty)
+            continue;
         
         // open index and write indexes to file
-        sprintf(path, "%s%s/%s/index", DATA_PATH, current_db->name, curr_table->name);
+        sprintf(path, "%s%s/%s/index.tmp", DATA_PATH, current_db->name, curr_table->name);
         FILE* fp = fopen(path, "w+");
         if (fp == NULL)
             return false;
         
-        // iterate over each index
+        // iterate over each index but the ones rebuilt on loading
         for (size_t j = 0; j < curr_table->num_indexes; j++) {
             Index* index = curr_table->indexes[j];
+            if (index->num_keys > 0 || index->num_included > 0)
+                continue;
             char type = index->clustered ? 'C' : 'U';
             switch (index->type) {
                 case BTREE:
@@ -235,7 +463,12 @@ bool writeColumnData() {
                     fprintf(fp, "%s S %c\n", index->column->name, type);
                     if (index->clustered) {
                         for (size_t k = 0; k < curr_table->num_rows; k++) {
-                            fprintf(fp, "%i %zu\n", index->column->data[k], k);
+                            long value;
+                            if (!readValue(index->column, k, &value)) {
+                                fclose(fp);
+                                return false;
+                            }
+                            fprintf(fp, "%ld %zu\n", value, k);
                         }
                     } else {
                         ColumnIndex* cindex = index->object->column;
@@ -246,18 +479,81 @@ bool writeColumnData() {
                     break;
             }
         }
+        if (!closeDurably(fp))
+            return false;
     }
     return true;
 }
 
+void markTableDirty(Table* table, size_t from_row) {
+    table->dirty = true;
+    for (size_t i = 0; i < table->col_count; i++) {
+        Column* column = table->columns[i];
+        if (!column->dirty || from_row < column->dirty_from)
+            column->dirty_from = from_row;
+        column->dirty = true;
+    }
+    for (size_t i = 0; i < table->num_indexes; i++)
+        table->indexes[i]->dirty = true;
+}
+
+void markCheckpointed() {
+    if (current_db == NULL)
+        return;
+    for (size_t i = 0; i < current_db->num_tables; i++) {
+        Table* table = current_db->tables[i];
+        table->dirty = false;
+        table->persisted_rows = table->num_rows;
+        for (size_t j = 0; j < table->col_count; j++)
+            table->columns[j]->dirty = false;
+        for (size_t j = 0; j < table->num_indexes; j++)
+            table->indexes[j]->dirty = false;
+    }
+}
+
+void markAllDirty() {
+    if (current_db == NULL)
+        return;
+    for (size_t i = 0; i < current_db->num_tables; i++) {
+        // tables that were never loaded still match their files
+        if (__atomic_load_n(&current_db->tables[i]->load_state, __ATOMIC_ACQUIRE) != LOADED)
+            continue;
+        // persisted_rows stays, so every file the committed catalog still
+        // refers to is rewritten into a .tmp file rather than in place
+        markTableDirty(current_db->tables[i], 0);
+    }
+}
+
+// reads every table of a catalog from before the version line and writes
+// it back in the current format; the old files stay in place until the
+// new catalog is committed
+static bool convertLegacyCatalog() {
+    log_info("-- Converting a catalog without a version.\n");
+    legacy_catalog = true;
+    bool success = true;
+    for (size_t i = 0; i < current_db->num_tables && success; i++) {
+        Table* table = current_db->tables[i];
+        success = ensureTableLoaded(table);
+        // every row moves to a new file
+        table->persisted_rows = table->num_rows;
+        markTableDirty(table, 0);
+    }
+    legacy_catalog = false;
+    if (!success || !writeDb())
+        return false;
+    markCheckpointed();
+    return true;
+}
+
 bool startupDb() {
     // open file for reading
     FILE* fp = fopen("./catalog", "r");
     if (fp == NULL)
-        return false;
+        return walReplay(0);
     
-    // reading buffer
-    char buf[MAX_SIZE_NAME + 20];
+    // reading buffer; statistics lines are long
+    char* buf = NULL;
+    size_t buf_size = 0;
     // initialize current_db
     current_db = calloc(1, sizeof(Db));
 
@@ -271,15 +567,30 @@ bool startupDb() {
     size_t col_capacity = 0;
     size_t index_count = 0;
     size_t index_capacity = 0;
+    size_t checkpoint_lsn = 0;
+    // catalogs from before the version line have none
+    size_t version = 1;
 
     // iterate through file until EOF
-    while (fgets(buf, sizeof(buf), fp)) {
+    while (getline(&buf, &buf_size, fp) > 0) {
         size_t len = strlen(buf);
         if (buf[len - 1] == '\n') {
             buf[len - 1] = '\0';
         } else {
             buf[len] = '\0';
         }
+        // check for the catalog format
+        if (strncmp(buf, "V", 1) == 0) {
+            version = strtoul(buf + 2, NULL, 10);
+            if (version > CATALOG_VERSION)
+                return false;
+            continue;
+        }
+        // check for the last logged statement the files contain
+        if (strncmp(buf, "L", 1) == 0) {
+            checkpoint_lsn = strtoul(buf + 2, NULL, 10);
+            continue;
+        }
         // check for db name
         if (strncmp(buf, "D", 1) == 0) {
             strcpy(current_db->name, (buf + 2));
@@ -314,13 +625,17 @@ bool startupDb() {
                 table_capacity = new_size;
             }
             // add new table object
+            // the number of rows follows the name
             Table* new_table = calloc(1, sizeof(Table));
+            char* num_rows = strchr(buf + 2, ' ');
+            if (num_rows != NULL)
+                *num_rows++ = '\0';
             strcpy(new_table->name, (buf + 2));
             new_table->columns = NULL;
             new_table->indexes = NULL;
             new_table->col_count = 0;
             new_table->num_indexes = 0;
-            new_table->num_rows = 0;
+            new_table->num_rows = (num_rows != NULL) ? strtoul(num_rows, NULL, 10) : 0;
             new_table->capacity = 0;
             tables[table_count++] = new_table;
             continue;
@@ -340,13 +655,26 @@ bool startupDb() {
                 }
                 col_capacity = new_size;
             }
-            // add new column object
+            // add new column object; the storage type follows the name
             Column* new_col = calloc(1, sizeof(Column));
+            char* col_type = strchr(buf + 2, ' ');
+            new_col->type = INT;
+            if (col_type != NULL) {
+                *col_type++ = '\0';
+                if (parseDataType(col_type, &new_col->type) == false)
+                    return false;
+            }
             strcpy(new_col->name, (buf + 2));
             new_col->data = NULL;
             columns[col_count++] = new_col;
             continue;
         }
+        // check for the statistics of the last column
+        if (strncmp(buf, "S", 1) == 0) {
+            if (col_count == 0 || (columns[col_count - 1]->stats = readColumnStats(buf + 2)) == NULL)
+                return false;
+            continue;
+        }
         // check for an index
         if (strncmp(buf, "I", 1) == 0) {
             // check for index capacity
@@ -362,16 +690,40 @@ bool startupDb() {
                 }
                 index_capacity = new_size;
             }
-            // add new index object
-            Index* new_index = malloc(sizeof(Index));
+            // add new index object; further key columns follow the first
+            // after a '+', included columns after a space
+            Index* new_index = calloc(1, sizeof(Index));
+            new_index->dirty = false;
             new_index->type = (buf[2] == 'B') ? BTREE : SORTED;
             new_index->clustered = (buf[4] == 'C');
-            char* col_name = buf + 6;
+            char* included_names = buf + 6;
+            char* key_names = strsep(&included_names, " ");
+            char* col_name = strsep(&key_names, "+");
+            for (char* c = key_names; c != NULL && *c != '\0'; c++)
+                new_index->num_keys += (*c == '+');
+            new_index->num_keys += (key_names != NULL);
+            for (char* c = included_names; c != NULL && *c != '\0'; c++)
+                new_index->num_included += (*c == ' ');
+            new_index->num_included += (included_names != NULL);
+            new_index->keys = calloc(new_index->num_keys + 1, sizeof(Column*));
+            new_index->included = calloc(new_index->num_included + 1, sizeof(Column*));
             for (size_t i = 0; i < col_count; i++) {
                 if (strcmp(columns[i]->name, col_name) == 0) {
                     new_index->column = columns[i];
                 }
             }
+            for (size_t k = 0; k < new_index->num_keys; k++) {
+                char* name = strsep(&key_names, "+");
+                for (size_t i = 0; i < col_count; i++)
+                    if (strcmp(columns[i]->name, name) == 0)
+                        new_index->keys[k] = columns[i];
+            }
+            for (size_t k = 0; k < new_index->num_included; k++) {
+                char* name = strsep(&included_names, " ");
+                for (size_t i = 0; i < col_count; i++)
+                    if (strcmp(columns[i]->name, name) == 0)
+                        new_index->included[k] = columns[i];
+            }
             new_index->object = malloc(sizeof(IndexObject));
             switch (new_index->type) {
                 case BTREE:
@@ -383,7 +735,7 @@ bool startupDb() {
                     break;
                 case SORTED:
                     if (!new_index->clustered) {
-                        new_index->object->column = malloc(sizeof(ColumnIndex));
+                        new_index->object->column = calloc(1, sizeof(ColumnIndex));
                     } else {
                         new_index->object->column = NULL;
                     }
@@ -405,10 +757,22 @@ bool startupDb() {
     current_db->tables = tables;
     current_db->num_tables = table_count;
     
+    free(buf);
     fclose(fp);
 
+    // the catalog is renamed into place last, so a leftover catalog.tmp
+    // means the last checkpoint never committed
+    bool committed = access("./catalog.tmp", F_OK) != 0;
+    finishCheckpoint(committed);
+    unlink("./catalog.tmp");
+
     log_info("-- Loaded db metadata.\n");
-    return loadColumnData();
+    if (version < CATALOG_VERSION && !convertLegacyCatalog())
+        return false;
+    if (!walReplay(checkpoint_lsn))
+        return false;
+    startLoaders();
+    return true;
 }
 
 bool writeDb() {
@@ -416,35 +780,68 @@ bool writeDb() {
 
     if (current_db == NULL)
         return true;
-    // open file
-    FILE* fp = fopen("./catalog", "w+");
+    // the catalog is only replaced once the data is on disk; until then a
+    // catalog.tmp tells startupDb() the checkpoint never committed
+    FILE* fp = fopen("./catalog.tmp", "w+");
     if (fp == NULL)
         return false;
-    
+    if (!writeColumnData()) {
+        fclose(fp);
+        return false;
+    }
+
+    // catalog format
+    if (fprintf(fp, "V %d\n", CATALOG_VERSION) < 0)
+        return false;
+
+    // last logged statement reflected in the files
+    if (fprintf(fp, "L %zu\n", walLastLsn()) < 0)
+        return false;
+
     // db name
     if (fprintf(fp, "D %s\n", current_db->name) < 0)
         return false;
     
     // table names
     for (size_t i = 0; i < current_db->num_tables; i++) {
-        if (fprintf(fp, "T %s\n", current_db->tables[i]->name) < 0)
+        if (fprintf(fp, "T %s %zu\n", current_db->tables[i]->name, current_db->tables[i]->num_rows) < 0)
             return false;
         
         // column names
         for (size_t j = 0; j < current_db->tables[i]->col_count; j++) {
-            if (fprintf(fp, "C %s\n", current_db->tables[i]->columns[j]->name) < 0)
+            Column* column = current_db->tables[i]->columns[j];
+            if (fprintf(fp, "C %s %s\n", column->name, dataTypeName(column->type)) < 0)
+                return false;
+            // tables that were never loaded keep the statistics they were read with
+            if (column->stats != NULL && (fprintf(fp, "S ") < 0 || !writeColumnStats(fp, column->stats)))
                 return false;
         }
 
-        // indexes
+        // indexes, with the further key columns of a composite index after
+        // a '+' and the included columns of a covering one after a space
         for (size_t j = 0; j < current_db->tables[i]->num_indexes; j++) {
-            if (fprintf(fp, "I %c %c %s\n", 
-                current_db->tables[i]->indexes[j]->type == BTREE ? 'B' : 'S',
-                current_db->tables[i]->indexes[j]->clustered ? 'C' : 'U',
-                current_db->tables[i]->indexes[j]->column->name) < 0)
+            Index* index = current_db->tables[i]->indexes[j];
+            if (fprintf(fp, "I %c %c %s", 
+                index->type == BTREE ? 'B' : 'S',
+                index->clustered ? 'C' : 'U',
+                index->column->name) < 0)
+                return false;
+            for (size_t k = 0; k < index->num_keys; k++)
+                if (fprintf(fp, "+%s", index->keys[k]->name) < 0)
+                    return false;
+            for (size_t k = 0; k < index->num_included; k++)
+                if (fprintf(fp, " %s", index->included[k]->name) < 0)
+                    return false;
+            if (fputc('\n', fp) == EOF)
                 return false;
         }
     }
-    // fclose(fp);
-    return writeColumnData();
+    if (!closeDurably(fp))
+        return false;
+
+    // renaming the catalog commits the checkpoint
+    if (rename("./catalog.tmp", "./catalog") != 0)
+        return false;
+    finishCheckpoint(true);
+    return true;
 }
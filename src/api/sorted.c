@@ -1,9 +1,10 @@
 #include "api/sorted.h"
 
 void initializeColumnIndex(ColumnIndex** cindex, size_t size) {
-    ColumnIndex* new_index = malloc(sizeof(ColumnIndex));
+    ColumnIndex* new_index = calloc(1, sizeof(ColumnIndex));
     new_index->values = calloc(1, size);
     new_index->indexes = calloc(1, size);
+    new_index->capacity = size / sizeof(int);
     *cindex = new_index;
 }
 
@@ -25,7 +26,7 @@ int insertSorted(int* data, int value, int total) {
             high = current;
     }
     // low and high now point to the smallest element greater than "value"
-    shiftValues(data, low, total, 0);
+    shiftValues(data, low, total - 1, 0);
     data[low] = value;
     return low;
 }
@@ -79,3 +80,16 @@ int findRangeS(int** data, ColumnIndex* column, int total_num, int minimum, int
     *data = results;
     return num_tuples;
 }
+
+size_t lowerBoundS(ColumnIndex* column, size_t total, long value) {
+    size_t low = 0;
+    size_t high = total;
+    while (high > low) {
+        size_t current = (low + high) / 2;
+        if (column->values[current] < value)
+            low = current + 1;
+        else
+            high = current;
+    }
+    return low;
+}
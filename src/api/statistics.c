@@ -0,0 +1,220 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/column.h"
+#include "api/statistics.h"
+
+ColumnStats* createColumnStats() {
+    return calloc(1, sizeof(ColumnStats));
+}
+
+// splitmix64 finalizer; spreads neighbouring values over the whole sketch
+static unsigned long long hashValue(long value) {
+    unsigned long long hash = (unsigned long long) value + 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+// the leading bits pick a register, which keeps the longest run of leading
+// zeros seen among the remaining bits
+static void addToSketch(ColumnStats* stats, long value) {
+    unsigned long long hash = hashValue(value);
+    size_t reg = hash >> (64 - STATS_SKETCH_BITS);
+    unsigned long long rest = hash << STATS_SKETCH_BITS;
+    unsigned char rank = (rest == 0) ? 64 - STATS_SKETCH_BITS + 1 : __builtin_clzll(rest) + 1;
+    if (rank > stats->sketch[reg])
+        stats->sketch[reg] = rank;
+}
+
+static int compareLongs(const void* a, const void* b) {
+    long x = *(const long*) a;
+    long y = *(const long*) b;
+    return (x > y) - (x < y);
+}
+
+bool analyzeColumn(Column* column, size_t num_rows) {
+    ColumnStats* stats = column->stats;
+    if (stats == NULL && (stats = column->stats = createColumnStats()) == NULL)
+        return false;
+    size_t sample_size = num_rows < STATS_SAMPLE_ROWS ? num_rows : STATS_SAMPLE_ROWS;
+    long* sample = malloc(sizeof(long) * (sample_size + 1));
+    if (sample == NULL)
+        return false;
+
+    // one pass over the column keeps the bounds and the sketch exact and
+    // draws a reservoir sample for the histogram; the generator is seeded
+    // the same way every time so analyzing a column is repeatable
+    memset(stats->sketch, 0, sizeof(stats->sketch));
+    long min = LONG_MAX;
+    long max = LONG_MIN;
+    unsigned long long state = 88172645463325252ULL;
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk)) {
+            free(sample);
+            return false;
+        }
+        Column view = { .type = column->type, .data = (void*) chunk.data };
+        for (size_t i = 0; i < chunk.num_rows; i++) {
+            long value = getValue(&view, i);
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+            addToSketch(stats, value);
+
+            size_t seen = row + i;
+            if (seen < sample_size) {
+                sample[seen] = value;
+                continue;
+            }
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            size_t slot = state % (seen + 1);
+            if (slot < sample_size)
+                sample[slot] = value;
+        }
+        releaseChunk(column, &chunk);
+    }
+
+    // equi-depth: every bucket starts at a quantile of the sample and holds
+    // an equal share of the rows
+    qsort(sample, sample_size, sizeof(long), compareLongs);
+    stats->num_rows = num_rows;
+    stats->analyzed_rows = num_rows;
+    stats->min = (num_rows > 0) ? min : 0;
+    stats->max = (num_rows > 0) ? max : 0;
+    for (size_t i = 0; i < STATS_HISTOGRAM_BUCKETS; i++) {
+        stats->bounds[i] = (sample_size > 0) ? sample[i * sample_size / STATS_HISTOGRAM_BUCKETS] : 0;
+        stats->counts[i] = (i + 1) * num_rows / STATS_HISTOGRAM_BUCKETS - i * num_rows / STATS_HISTOGRAM_BUCKETS;
+    }
+    stats->bounds[0] = stats->min;
+    stats->bounds[STATS_HISTOGRAM_BUCKETS] = stats->max;
+    free(sample);
+    return true;
+}
+
+bool analyzeTable(Table* table) {
+    for (size_t i = 0; i < table->col_count; i++)
+        if (!analyzeColumn(table->columns[i], table->num_rows))
+            return false;
+    return true;
+}
+
+// the first bucket whose upper bound is past value
+static size_t findBucket(const ColumnStats* stats, long value) {
+    size_t low = 0;
+    size_t high = STATS_HISTOGRAM_BUCKETS - 1;
+    while (low < high) {
+        size_t current = (low + high) / 2;
+        if (stats->bounds[current + 1] <= value)
+            low = current + 1;
+        else
+            high = current;
+    }
+    return low;
+}
+
+void updateColumnStats(Column* column, long value, size_t num_rows) {
+    ColumnStats* stats = column->stats;
+    if (stats == NULL || num_rows > stats->analyzed_rows * STATS_REANALYZE_FACTOR) {
+        analyzeColumn(column, num_rows);
+        return;
+    }
+
+    // the outer buckets stretch to take in new extremes
+    stats->num_rows = num_rows;
+    if (value < stats->min)
+        stats->min = stats->bounds[0] = value;
+    if (value > stats->max)
+        stats->max = stats->bounds[STATS_HISTOGRAM_BUCKETS] = value;
+    stats->counts[findBucket(stats, value)]++;
+    addToSketch(stats, value);
+}
+
+double estimateRangeRows(const ColumnStats* stats, long minimum, long maximum) {
+    if (stats->num_rows == 0 || minimum >= maximum || minimum > stats->max || maximum <= stats->min)
+        return 0;
+
+    // values are assumed to spread evenly over the integers of a bucket; a
+    // bucket without width holds a single frequent value
+    double rows = 0;
+    long last = maximum - 1;
+    for (size_t i = 0; i < STATS_HISTOGRAM_BUCKETS; i++) {
+        long low = stats->bounds[i];
+        long high = stats->bounds[i + 1];
+        if (i + 1 < STATS_HISTOGRAM_BUCKETS && high > low)
+            high--;
+        long from = minimum > low ? minimum : low;
+        long to = last < high ? last : high;
+        if (from > to)
+            continue;
+        double width = (double) high - (double) low + 1;
+        rows += stats->counts[i] * (((double) to - (double) from + 1) / width);
+    }
+    return rows < stats->num_rows ? rows : stats->num_rows;
+}
+
+size_t estimateDistinct(const ColumnStats* stats) {
+    if (stats->num_rows == 0)
+        return 0;
+    double registers = STATS_SKETCH_REGISTERS;
+    double sum = 0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < STATS_SKETCH_REGISTERS; i++) {
+        sum += ldexp(1.0, -stats->sketch[i]);
+        zeros += (stats->sketch[i] == 0);
+    }
+    double estimate = (0.7213 / (1 + 1.079 / registers)) * registers * registers / sum;
+    // few distinct values leave registers empty, which counts them better
+    if (estimate <= 2.5 * registers && zeros > 0)
+        estimate = registers * log(registers / zeros);
+    size_t distinct = (size_t) (estimate + 0.5);
+    return distinct < stats->num_rows ? distinct : stats->num_rows;
+}
+
+bool writeColumnStats(FILE* fp, const ColumnStats* stats) {
+    if (fprintf(fp, "%zu %zu %ld %ld", stats->num_rows, stats->analyzed_rows, stats->min, stats->max) < 0)
+        return false;
+    for (size_t i = 0; i <= STATS_HISTOGRAM_BUCKETS; i++)
+        if (fprintf(fp, " %ld", stats->bounds[i]) < 0)
+            return false;
+    for (size_t i = 0; i < STATS_HISTOGRAM_BUCKETS; i++)
+        if (fprintf(fp, " %zu", stats->counts[i]) < 0)
+            return false;
+    // registers are written as two hex digits each
+    if (fputc(' ', fp) == EOF)
+        return false;
+    for (size_t i = 0; i < STATS_SKETCH_REGISTERS; i++)
+        if (fprintf(fp, "%02x", stats->sketch[i]) < 0)
+            return false;
+    return fputc('\n', fp) != EOF;
+}
+
+ColumnStats* readColumnStats(const char* line) {
+    ColumnStats* stats = createColumnStats();
+    if (stats == NULL)
+        return NULL;
+    char* end;
+    stats->num_rows = strtoul(line, &end, 10);
+    stats->analyzed_rows = strtoul(end, &end, 10);
+    stats->min = strtol(end, &end, 10);
+    stats->max = strtol(end, &end, 10);
+    for (size_t i = 0; i <= STATS_HISTOGRAM_BUCKETS; i++)
+        stats->bounds[i] = strtol(end, &end, 10);
+    for (size_t i = 0; i < STATS_HISTOGRAM_BUCKETS; i++)
+        stats->counts[i] = strtoul(end, &end, 10);
+    while (*end == ' ')
+        end++;
+    if (strlen(end) != 2 * STATS_SKETCH_REGISTERS) {
+        free(stats);
+        return NULL;
+    }
+    for (size_t i = 0; i < STATS_SKETCH_REGISTERS; i++) {
+        char digits[3] = { end[2 * i], end[2 * i + 1], '\0' };
+        stats->sketch[i] = (unsigned char) strtoul(digits, NULL, 16);
+    }
+    return stats;
+}
@@ -0,0 +1,224 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "api/wal.h"
+#include "api/context.h"
+#include "api/persist.h"
+#include "parse/parse.h"
+#include "query/execute.h"
+#include "util/log.h"
+
+static FILE* wal_file = NULL;
+static size_t wal_lsn = 0;
+static bool wal_dirty = false;
+static size_t records_since_checkpoint = 0;
+static pid_t checkpoint_pid = -1;
+static pthread_mutex_t wal_lock = PTHREAD_MUTEX_INITIALIZER;
+
+bool walShouldLog(const char* statement) {
+    while (*statement == ' ' || *statement == '\t')
+        statement++;
+    // explain() runs the statement it wraps, and so does its replay
+    if (strncmp(statement, "explain(", 8) == 0)
+        statement += 8;
+    return strncmp(statement, "create", 6) == 0 ||
+        strncmp(statement, "relational_insert", 17) == 0;
+}
+
+// re-executes the records of one log file; returns the number replayed
+static size_t replayFile(const char* path, size_t checkpoint_lsn, ClientContext* context) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL)
+        return 0;
+
+    char* line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    size_t replayed = 0;
+    while ((len = getline(&line, &line_size, fp)) > 0) {
+        // a torn final record is the tail of an incomplete group commit
+        if (line[len - 1] != '\n')
+            break;
+        line[len - 1] = '\0';
+
+        char* statement = NULL;
+        size_t lsn = strtoul(line, &statement, 10);
+        if (statement == line || *statement != ' ')
+            break;
+        if (lsn <= checkpoint_lsn)
+            continue;
+
+        message response;
+        response.status = OK_DONE;
+        DbOperator* query = parse_command(statement + 1, &response, -1, context);
+        executeDbOperator(query, &response);
+        wal_lsn = lsn;
+        replayed++;
+    }
+    free(line);
+    fclose(fp);
+    return replayed;
+}
+
+bool walReplay(size_t checkpoint_lsn) {
+    wal_lsn = checkpoint_lsn;
+
+    // replayed statements run in a context of their own
+    ClientContext* context = calloc(1, sizeof(ClientContext));
+    context->client_fd = -1;
+    insertContext(context);
+
+    // a log rotated out by an unfinished checkpoint holds the older records
+    size_t replayed = replayFile(WAL_OLD_PATH, checkpoint_lsn, context);
+    replayed += replayFile(WAL_PATH, checkpoint_lsn, context);
+    records_since_checkpoint = replayed;
+
+    deleteContext(context);
+    free(context->chandle_table);
+    free(context);
+
+    log_info("-- Replayed %zu statements from the write-ahead log.\n", replayed);
+    return true;
+}
+
+// flushes the buffered records once per group-commit window
+static void* walCommitLoop(void* arg) {
+    (void) arg;
+    struct timespec interval = {
+        .tv_sec = 0,
+        .tv_nsec = WAL_COMMIT_INTERVAL_MS * 1000000L
+    };
+    while (true) {
+        nanosleep(&interval, NULL);
+        walFlush();
+    }
+    return NULL;
+}
+
+bool walStart() {
+    wal_file = fopen(WAL_PATH, "a");
+    if (wal_file == NULL)
+        return false;
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, walCommitLoop, NULL) != 0)
+        return false;
+    pthread_detach(thread);
+    return true;
+}
+
+bool walAppend(const char* statement) {
+    if (wal_file == NULL)
+        return false;
+    // one record per line, so drop the statement's own line break
+    int len = strcspn(statement, "\r\n");
+    pthread_mutex_lock(&wal_lock);
+    bool success = fprintf(wal_file, "%zu %.*s\n", ++wal_lsn, len, statement) >= 0;
+    wal_dirty = true;
+    records_since_checkpoint++;
+    pthread_mutex_unlock(&wal_lock);
+    return success;
+}
+
+bool walFlush() {
+    if (wal_file == NULL)
+        return false;
+    pthread_mutex_lock(&wal_lock);
+    bool success = true;
+    if (wal_dirty) {
+        success = fflush(wal_file) == 0 && fsync(fileno(wal_file)) == 0;
+        wal_dirty = false;
+    }
+    pthread_mutex_unlock(&wal_lock);
+    return success;
+}
+
+size_t walLastLsn() {
+    return wal_lsn;
+}
+
+// reaps a finished background checkpoint, blocking until it's done if wait
+// is set. A failed one leaves every change to be written by the next.
+static void reapCheckpoint(bool wait) {
+    if (checkpoint_pid < 0)
+        return;
+    int status;
+    pid_t pid = waitpid(checkpoint_pid, &status, wait ? 0 : WNOHANG);
+    if (pid == 0)
+        return;
+    checkpoint_pid = -1;
+    if (pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        unlink(WAL_OLD_PATH);
+    } else {
+        log_err("-- Background checkpoint failed.\n");
+        markAllDirty();
+    }
+}
+
+bool walCheckpoint() {
+    reapCheckpoint(true);
+    log_info("-- Checkpointing at lsn %zu.\n", wal_lsn);
+    waitForLoads();
+    walFlush();
+    if (!writeDb())
+        return false;
+    markCheckpointed();
+    records_since_checkpoint = 0;
+    unlink(WAL_OLD_PATH);
+    if (wal_file == NULL)
+        return true;
+
+    // everything up to wal_lsn is now in the catalog and column files
+    pthread_mutex_lock(&wal_lock);
+    fflush(wal_file);
+    bool success = ftruncate(fileno(wal_file), 0) == 0;
+    wal_dirty = false;
+    pthread_mutex_unlock(&wal_lock);
+    return success;
+}
+
+bool walCheckpointInBackground() {
+    reapCheckpoint(false);
+    if (checkpoint_pid >= 0 || wal_file == NULL)
+        return false;
+    log_info("-- Checkpointing at lsn %zu in the background.\n", wal_lsn);
+    // the child gets no loader threads, so a table half loaded when
+    // forking would be written out half loaded
+    waitForLoads();
+
+    pthread_mutex_lock(&wal_lock);
+    // start a new log, so the current one can be dropped once the snapshot
+    // is on disk; an older log still waiting on a checkpoint is kept as is
+    fflush(wal_file);
+    fsync(fileno(wal_file));
+    wal_dirty = false;
+    if (access(WAL_OLD_PATH, F_OK) != 0) {
+        fclose(wal_file);
+        rename(WAL_PATH, WAL_OLD_PATH);
+        wal_file = fopen(WAL_PATH, "a");
+    }
+
+    // the child writes out a copy-on-write snapshot of the database while
+    // this process keeps serving queries
+    pid_t pid = fork();
+    if (pid == 0)
+        _exit(writeDb() ? 0 : 1);
+    pthread_mutex_unlock(&wal_lock);
+    if (pid < 0)
+        return false;
+
+    checkpoint_pid = pid;
+    markCheckpointed();
+    records_since_checkpoint = 0;
+    return true;
+}
+
+void walCheckpointIfDue() {
+    reapCheckpoint(false);
+    if (records_since_checkpoint >= WAL_CHECKPOINT_RECORDS)
+        walCheckpointInBackground();
+}
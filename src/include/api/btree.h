@@ -37,6 +37,8 @@ typedef struct BTreeUNode {
 
 // unclustered btree functions
 BTreeUNode* createBTreeU();
+// frees every node of the tree
+void destroyBTreeU(BTreeUNode* tree);
 void insertValueU(BTreeUNode** tree, int value, int index);
 void deleteValueU(BTreeUNode** tree, int value, int index);
 void updateValueU(BTreeUNode** tree, int value, int index, int new_value);
@@ -71,6 +73,8 @@ typedef struct BTreeCNode {
 
 // clustered btree functions
 BTreeCNode* createBTreeC();
+// frees every node of the tree
+void destroyBTreeC(BTreeCNode* tree);
 // returns new index of inserted element
 size_t insertValueC(BTreeCNode** tree, int value);
 // delete an element at a specific index
@@ -0,0 +1,43 @@
+// Buffer pool for columns too large to keep in memory.
+//
+// A paged column leaves its first paged_rows values in its column file.
+// Those are read on demand in POOL_PAGE_SIZE pages into a fixed set of
+// BUFFER_POOL_PAGES frames, which are recycled with the CLOCK policy.
+// A page stays in its frame for as long as it's pinned; pages may be
+// pinned and unpinned from any thread. Rows appended after a column was
+// paged are kept in memory in the column's data.
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include "api/cs165.h"
+
+// both can be set at build time, e.g. to page small tables in tests
+#ifndef POOL_PAGE_SIZE
+#define POOL_PAGE_SIZE 65536
+#endif
+#ifndef BUFFER_POOL_PAGES
+#define BUFFER_POOL_PAGES 4096
+#endif
+// tables whose data exceeds this are paged instead of read into memory
+#define PAGED_TABLE_BYTES ((size_t) BUFFER_POOL_PAGES * POOL_PAGE_SIZE / 4)
+// pages a sequential scan asks the OS to read ahead
+#define PREFETCH_PAGES 8
+
+// number of values held by one page of the column
+size_t pageRows(Column* column);
+
+// serves the first num_rows values of the column from the file at path
+bool pageColumn(Column* column, const char* path, size_t num_rows);
+
+// returns the page's values, reading them in if necessary, and keeps the
+// page in memory until it's unpinned. Returns NULL if every frame is pinned.
+const void* pinPage(Column* column, size_t page_no);
+void unpinPage(Column* column, size_t page_no);
+
+// hints that a scan will read the pages following page_no next
+void prefetchPages(Column* column, size_t page_no);
+
+// drops every page of the column and stops paging it
+void evictColumn(Column* column);
+
+#endif
@@ -0,0 +1,69 @@
+// Width-aware access to column storage
+#ifndef COLUMN_H
+#define COLUMN_H
+
+#include "api/cs165.h"
+
+// returns the number of bytes used to store one value of the given type
+size_t typeWidth(DataType type);
+
+// parses a storage type name ("byte", "short", "int" or "long")
+bool parseDataType(const char* name, DataType* type);
+
+// returns the storage type name used by the DSL and the catalog
+const char* dataTypeName(DataType type);
+
+// true for the integer types a column can be stored as
+bool isIntegerType(DataType type);
+
+// true if the value can be stored in a column of the given type without
+// being truncated
+bool fitsType(DataType type, long value);
+
+// reads a single value held in memory, widened to a long; the paged rows
+// of a column are read with readValue()
+long getValue(Column* column, size_t row);
+
+// reads any single value, failing if the row's page can't be read
+bool readValue(Column* column, size_t row, long* value);
+
+// writes a single value, narrowed to the column's storage type; callers
+// check that it fits with fitsType() first
+void setValue(Column* column, size_t row, long value);
+
+// grows (or allocates) the column's storage to hold capacity values
+bool resizeColumn(Column* column, size_t capacity);
+
+// shifts the values in [from, num_rows) up by one slot
+void shiftColumn(Column* column, size_t from, size_t num_rows);
+
+// finds the first row in a sorted column whose value is >= value
+bool lowerBound(Column* column, size_t num_rows, long value, size_t* row);
+
+// inserts a value into a sorted column held in memory; assumes there's
+// enough space
+size_t insertSortedColumn(Column* column, long value, size_t num_rows);
+
+// a run of contiguous values of a column, from a pinned page or from memory
+typedef struct ColumnChunk {
+    const void* data;
+    size_t first_row;
+    size_t num_rows;
+    size_t page_no;
+    bool pinned;
+} ColumnChunk;
+
+// fetches the longest contiguous run of rows starting at row and ending at
+// most at num_rows. Pages are pinned until the chunk is released.
+bool getChunk(Column* column, size_t row, size_t num_rows, ColumnChunk* chunk);
+void releaseChunk(Column* column, ColumnChunk* chunk);
+
+// copies num_rows values starting at row from into out
+bool readRows(Column* column, size_t from, size_t num_rows, void* out);
+
+// reads a paged column back into memory, with room for capacity rows, so
+// that any of its rows can be written again
+bool unpageColumn(Column* column, size_t capacity);
+bool unpageTable(Table* table);
+
+#endif
@@ -0,0 +1,34 @@
+// Composite and covering indexes.
+//
+// A sorted unclustered index can be keyed on several columns: entries are
+// ordered by the first, ties by the next and so on, so any prefix of the
+// key is a contiguous run of entries. It can also include columns it
+// isn't keyed on. Every key column past the first and every included
+// column is copied into the index in entry order, so the values of the
+// rows a select found through the index can be read from it sequentially
+// instead of fetched one position at a time from the table.
+#ifndef COMPOSITE_H
+#define COMPOSITE_H
+
+#include "api/cs165.h"
+
+// grows a sorted unclustered index, with its key and payload copies, to
+// hold capacity entries
+bool resizeColumnIndex(Index* index, size_t capacity);
+
+// builds a sorted unclustered index over the first num_rows rows of its
+// columns, with room for capacity entries; fails if a row can't be read
+bool buildColumnIndex(Index* index, size_t num_rows, size_t capacity);
+
+// inserts a row of the index's columns into a sorted unclustered index;
+// assumes there's enough space
+void insertIndexRow(Index* index, size_t row, size_t total);
+
+// true if a sorted unclustered index keeps the values of the column
+bool indexCovers(Index* index, Column* column);
+
+// copies the column's values of count entries starting at from into out,
+// at the column's width
+void readCovered(Index* index, Column* column, size_t from, size_t count, void* out);
+
+#endif
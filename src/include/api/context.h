@@ -12,5 +12,7 @@ void insertContext(ClientContext* context);
 void deleteContext(ClientContext* context);
 bool checkContextSize(ClientContext* context);
 void destroyColumnHandle(GeneralizedColumnHandle handle);
+PreparedStatement* findStatement(ClientContext* context, char* name);
+bool addStatement(ClientContext* context, PreparedStatement* statement);
 
 #endif
@@ -0,0 +1,44 @@
+// Database cracking.
+//
+// A select on a column without an index cracks a copy of the column
+// instead of scanning it: the piece of the copy holding each bound is
+// partitioned around it, and the split is recorded in the cracker index.
+// The copy thus gets more sorted with every query, and a range whose bounds
+// were seen before costs two binary searches. Rows appended to the column
+// are rippled into their pieces on the next select; inserts that move rows
+// throw the copy away.
+#ifndef CRACKER_H
+#define CRACKER_H
+
+#include "api/cs165.h"
+
+// columns with fewer rows are scanned; copying them doesn't pay off
+#define CRACK_MIN_ROWS 1024
+
+typedef struct CrackerColumn {
+    // copy of the column's first num_rows values and the row each came from
+    long* values;
+    int* rows;
+    size_t num_rows;
+    size_t capacity;
+    // the cracker index: values before positions[i] are < pivots[i], the
+    // ones from it on are >= pivots[i]; sorted by pivot
+    long* pivots;
+    size_t* positions;
+    size_t num_pivots;
+    size_t pivot_capacity;
+} CrackerColumn;
+
+// true if selects on the column should go through its cracker
+bool shouldCrack(Table* table, Column* column);
+
+// the rows of the column in [minimum, maximum), in row order, cracking the
+// column on both bounds; returns the number of rows or -1 on failure.
+// *positions is allocated by the call.
+long crackSelect(Column* column, size_t num_rows, long minimum, long maximum, int** positions);
+
+// throws away the crackers of the table's columns
+void dropCrackers(Table* table);
+void freeCracker(CrackerColumn* cracker);
+
+#endif
@@ -11,9 +11,13 @@
 #define MAX_SIZE_NAME 64
 #define HANDLE_MAX_SIZE 64
 #define PAGE_SIZE sysconf(_SC_PAGESIZE)
+// Limits the number of placeholders in a prepared statement
+#define MAX_STATEMENT_PARAMS 8
 
 // ================ DATABASE ================
 typedef enum DataType {
+     BYTE,
+     SHORT,
      INT,
      LONG,
      FLOAT,
@@ -21,7 +25,22 @@ typedef enum DataType {
 } DataType;
 typedef struct Column {
     char name[MAX_SIZE_NAME + 1];
-    int* data;
+    // storage type of every value in data
+    DataType type;
+    void* data;
+    // set when rows from dirty_from onwards changed since the last checkpoint
+    bool dirty;
+    size_t dirty_from;
+    // a paged column serves its first paged_rows values from page_fd through
+    // the buffer pool; data then only holds the rows after those
+    bool paged;
+    size_t paged_rows;
+    int page_fd;
+    // bounds, histogram and distinct sketch, see api/statistics.h
+    struct ColumnStats* stats;
+    // cracked copy of the column, see api/cracker.h; NULL until a select
+    // cracks it
+    struct CrackerColumn* cracker;
 } Column;
 typedef enum IndexType {
     BTREE,
@@ -30,6 +49,14 @@ typedef enum IndexType {
 typedef struct ColumnIndex {
     int* values;
     int* indexes;
+    // entries the arrays have room for
+    size_t capacity;
+    // the further keys of a composite index and the columns a covering
+    // index includes, copied in entry order and stored like the column
+    Column* keys;
+    Column* payloads;
+    // bumped whenever entries move, which invalidates covered results
+    size_t version;
 } ColumnIndex;
 typedef union IndexObject {
     struct BTreeUNode* btreeu;
@@ -41,7 +68,23 @@ typedef struct Index {
     Column* column;
     IndexType type;
     bool clustered;
+    // set when the index changed since the last checkpoint
+    bool dirty;
+    // a composite index orders ties on column by these columns in turn; a
+    // covering index also keeps the values of the included columns. Both
+    // are sorted unclustered indexes.
+    Column** keys;
+    size_t num_keys;
+    Column** included;
+    size_t num_included;
 } Index;
+typedef enum LoadState {
+    UNLOADED,
+    LOADING,
+    LOADED,
+    // the table's files couldn't be read; it's left as it is on disk
+    LOAD_FAILED
+} LoadState;
 typedef struct Table {
     char name [MAX_SIZE_NAME + 1];
     Column** columns;
@@ -50,6 +93,12 @@ typedef struct Table {
     size_t num_rows;
     size_t capacity;
     size_t num_indexes;
+    // set when the table changed since the last checkpoint, which holds
+    // persisted_rows rows of it
+    bool dirty;
+    size_t persisted_rows;
+    // tables in the catalog are read from disk lazily
+    LoadState load_state;
 } Table;
 typedef struct Db {
     char name[MAX_SIZE_NAME + 1];
@@ -63,14 +112,37 @@ typedef struct Result {
     size_t num_tuples;
     DataType data_type;
     void *payload;
+    // dense selections keep their positions as a bitmap of bitmap_rows
+    // rows in 64-bit words instead; num_tuples is the number of bits set
+    bool is_bitmap;
+    size_t bitmap_rows;
+    // positions selected through a sorted unclustered index are the entries
+    // from cover_from on, so fetches of the columns it copies can read them
+    // from the index while it's still at cover_version
+    struct Index* covering;
+    size_t cover_from;
+    size_t cover_version;
 } Result;
-typedef struct BatchedQueries {
+// selects of a batch that share one scan of their column
+typedef struct ScanGroup {
     Table* table;
     Column* column;
-    int* minimum;
-    int* maximum;
+    long* minimum;
+    long* maximum;
     Result** results;
     int num_queries;
+} ScanGroup;
+// a statement sent between batch_queries() and batch_execute(), parsed
+// into memory along with a copy of its text
+typedef struct BatchedStatement {
+    struct DbOperator* statement;
+    char* text;
+    char* memory;
+} BatchedStatement;
+typedef struct BatchedQueries {
+    BatchedStatement* statements;
+    size_t num_statements;
+    size_t statement_slots;
 } BatchedQueries;
 
 typedef enum GeneralizedColumnType {
@@ -96,6 +168,10 @@ typedef struct ClientContext {
     int chandles_in_use;
     int chandle_slots;
     int client_fd;
+    // statements prepared by the client, by name
+    struct PreparedStatement* statements;
+    int statements_in_use;
+    int statement_slots;
 } ClientContext;
 
 // ================ STATUS ================
@@ -114,11 +190,19 @@ typedef enum OperatorType {
     OP_FETCH,
     OP_BATCH,
     OP_MATH,
-    OP_JOIN
+    OP_JOIN,
+    OP_AGGREGATE,
+    OP_GROUP_BY,
+    OP_PREPARE,
+    OP_EXECUTE,
+    OP_STATS,
+    OP_EXPLAIN,
+    OP_ANALYZE,
+    OP_COMBINE
 } OperatorType;
 typedef enum CreateType { CREATE_DB, CREATE_TBL, CREATE_COL, CREATE_IDX } CreateType;
 typedef enum MathType { AVG, SUM, MAX, MIN, ADD, SUB } MathType;
-typedef enum JoinType { HASH, NESTED } JoinType;
+typedef enum JoinType { HASH, NESTED, MERGE, INDEX } JoinType;
 typedef struct CreateOperator {
     CreateType type;
     char** params;
@@ -126,18 +210,38 @@ typedef struct CreateOperator {
 } CreateOperator;
 typedef struct InsertOperator {
     char* tbl_name;
-    int* values;
+    long* values;
     size_t num_values;
 } InsertOperator;
 typedef struct LoaderOperator {
     char* file_name;
 } LoaderOperator;
+// a range predicate on another column of the table a select reads
+typedef struct SelectPredicate {
+    char* col_name;
+    long minimum;
+    long maximum;
+    bool bind_minimum;
+    bool bind_maximum;
+    Column* column;
+} SelectPredicate;
 typedef struct SelectOperator {
     char** params;
     char* handle;
-    int minimum;
-    int maximum;
+    long minimum;
+    long maximum;
     bool src_is_var;
+    // set for bounds given as ? placeholders in a prepared statement
+    bool bind_minimum;
+    bool bind_maximum;
+    // the column being selected from, once resolved, and the catalog
+    // generation it was resolved in
+    Table* table;
+    Column* column;
+    size_t generation;
+    // further predicates on the same table that rows have to satisfy too
+    SelectPredicate* conjuncts;
+    size_t num_conjuncts;
 } SelectOperator;
 typedef struct FetchOperator {
     char* db_name;
@@ -158,6 +262,30 @@ typedef struct MathOperator {
     // marks whether the first argument is a variable or not
     bool is_var;
 } MathOperator;
+typedef struct AggregateOperator {
+    // one aggregate (AVG, SUM, MIN or MAX) and target handle per output
+    MathType* types;
+    char** handles;
+    size_t num_aggregates;
+    // source is either a variable or a db, table and column
+    char** params;
+    size_t num_params;
+    // optional positions to aggregate over when the source is a column
+    char* selection;
+    bool is_var;
+} AggregateOperator;
+typedef struct GroupByOperator {
+    // variable holding the grouping keys and the handle receiving each
+    // distinct key
+    char* keys;
+    char* key_handle;
+    // one value variable, aggregate and target handle per output
+    char** values;
+    MathType* types;
+    char** handles;
+    size_t num_aggregates;
+} GroupByOperator;
+
 typedef struct JoinOperator {
     JoinType type;
     char* fetch1;
@@ -166,10 +294,50 @@ typedef struct JoinOperator {
     char* select2;
     char* handle1;
     char* handle2;
+    // an index join reads its inner side from this db, table and column
+    // instead of fetch2 and select2
+    char** inner;
 } JoinOperator;
 typedef struct BatchOperator {
     bool start;
+    // set for a statement to queue in the current batch rather than for
+    // batch_queries() and batch_execute() themselves
+    BatchedStatement queued;
 } BatchOperator;
+typedef struct PrepareOperator {
+    char* name;
+    // the parsed statement, allocated in memory along with the text it
+    // points into
+    struct DbOperator* statement;
+    char* memory;
+} PrepareOperator;
+typedef struct StatsOperator {
+    // file to write the report to, or NULL to send it back
+    char* path;
+} StatsOperator;
+typedef struct ExplainOperator {
+    struct DbOperator* statement;
+    // time it took to parse the statement
+    unsigned long long parse_ns;
+    // set to report the plan without timings
+    bool plan_only;
+} ExplainOperator;
+typedef struct AnalyzeOperator {
+    char* db_name;
+    char* tbl_name;
+} AnalyzeOperator;
+typedef struct CombineOperator {
+    // and() keeps the positions in both selections, or() those in either
+    bool conjunctive;
+    char* left;
+    char* right;
+    char* handle;
+} CombineOperator;
+typedef struct ExecuteOperator {
+    char* name;
+    long args[MAX_STATEMENT_PARAMS];
+    size_t num_args;
+} ExecuteOperator;
 typedef union OperatorFields {
     CreateOperator create;
     InsertOperator insert;
@@ -180,6 +348,14 @@ typedef union OperatorFields {
     BatchOperator batch;
     MathOperator math;
     JoinOperator join;
+    AggregateOperator aggregate;
+    GroupByOperator group_by;
+    PrepareOperator prepare;
+    ExecuteOperator execute;
+    StatsOperator stats;
+    ExplainOperator explain;
+    AnalyzeOperator analyze;
+    CombineOperator combine;
 } OperatorFields;
 
 typedef struct DbOperator {
@@ -189,8 +365,21 @@ typedef struct DbOperator {
     ClientContext* context;
 } DbOperator;
 
+// a statement parsed and resolved once, then executed many times; params
+// point at the fields execute() binds its arguments to, in order
+typedef struct PreparedStatement {
+    char name[HANDLE_MAX_SIZE + 1];
+    DbOperator* query;
+    char* memory;
+    long* params[MAX_STATEMENT_PARAMS];
+    size_t num_params;
+} PreparedStatement;
+
 // =============== PUBLIC ===============
 extern Db *current_db;
+// changes whenever tables may have been freed, so pointers resolved
+// before then must be looked up again
+extern size_t catalog_generation;
 
 Status db_startup();
 Status sync_db(Db* db);
@@ -9,7 +9,7 @@
 
 typedef struct HashNode {
     int count;
-    int* keys;
+    long* keys;
     int* values;
     struct HashNode* next;
 } HashNode;
@@ -22,8 +22,9 @@ typedef struct HashTable {
 } HashTable;
 
 void init(HashTable** ht);
-void put(HashTable* ht, int key, int value);
-int get(HashTable* ht, int key, int *values, int num_values);
-void erase(HashTable* ht, int key);
+void destroy(HashTable* ht);
+void put(HashTable* ht, long key, int value);
+int get(HashTable* ht, long key, int *values, int num_values);
+void erase(HashTable* ht, long key);
 
 #endif
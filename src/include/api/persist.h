@@ -4,7 +4,33 @@
 #include "api/cs165.h"
 #include "db_io.h"
 
+// format of the catalog and column files; catalogs without a version line
+// hold their columns as text and are converted on startup
+#define CATALOG_VERSION 2
+// number of rows a checkpoint writes per call when appending in place
+#define CHECKPOINT_SEGMENT_ROWS 4096
+// tables named in this file, one per line, are loaded before startup ends
+#define WARMUP_PATH "./warmup"
+// upper bound on the threads loading tables in the background
+#define MAX_LOADER_THREADS 8
+
+// reads the catalog and replays the log; table data is loaded by
+// background threads, warm-up tables before this returns. Fails on a
+// catalog it can't parse, which must then be left untouched.
 bool startupDb();
+// makes sure a table is in memory, loading it now if no thread has yet
+bool ensureTableLoaded(Table* table);
+// returns once every table is loaded and the loader threads are gone
+void waitForLoads();
+// writes everything that changed since the last checkpoint; loads must be
+// finished first
 bool writeDb();
 
+// records that rows from from_row onwards, and the table's indexes, changed
+void markTableDirty(Table* table, size_t from_row);
+// clears every dirty flag once a checkpoint has captured the database
+void markCheckpointed();
+// makes the next checkpoint rewrite everything
+void markAllDirty();
+
 #endif
@@ -18,4 +18,7 @@ void insertIndex(ColumnIndex* column, int value, int index, int total);
 // returns the number of values selected
 int findRangeS(int** data, ColumnIndex* column, int total_num, int minimum, int maximum);
 
+// returns the first entry whose value is >= value
+size_t lowerBoundS(ColumnIndex* column, size_t total, long value);
+
 #endif
@@ -0,0 +1,69 @@
+// Column statistics.
+//
+// Every column keeps its minimum and maximum, an equi-depth histogram and a
+// HyperLogLog sketch of its distinct values. analyzeColumn() builds them
+// from the data in one pass; inserts then update them in place: the bounds
+// and the sketch stay exact, while the histogram only counts the new row in
+// its bucket and drifts from equal depths until the column is analyzed
+// again. The planner reads them to estimate how many rows a predicate
+// matches.
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <stdio.h>
+
+#include "api/cs165.h"
+
+// buckets of the equi-depth histogram
+#define STATS_HISTOGRAM_BUCKETS 32
+
+// rows sampled to place the histogram bounds; smaller columns are sorted
+// whole
+#define STATS_SAMPLE_ROWS 16384
+
+// the sketch keeps 2^STATS_SKETCH_BITS registers, for a standard error of
+// about 1.04 / sqrt(registers), 3% at 1024
+#define STATS_SKETCH_BITS 10
+#define STATS_SKETCH_REGISTERS (1 << STATS_SKETCH_BITS)
+
+// inserts re-analyze a column once it holds this many times the rows its
+// histogram was built from
+#define STATS_REANALYZE_FACTOR 2
+
+typedef struct ColumnStats {
+    // rows described, and the rows the histogram was last built from
+    size_t num_rows;
+    size_t analyzed_rows;
+    long min;
+    long max;
+    // bucket i holds counts[i] rows in [bounds[i], bounds[i + 1]), the last
+    // one up to and including max; they're built with equal counts
+    long bounds[STATS_HISTOGRAM_BUCKETS + 1];
+    size_t counts[STATS_HISTOGRAM_BUCKETS];
+    unsigned char sketch[STATS_SKETCH_REGISTERS];
+} ColumnStats;
+
+// allocates empty statistics for a column without rows
+ColumnStats* createColumnStats();
+
+// rebuilds the statistics of a column from its first num_rows rows
+bool analyzeColumn(Column* column, size_t num_rows);
+
+// rebuilds the statistics of every column of a table
+bool analyzeTable(Table* table);
+
+// accounts for a row inserted into the column, re-analyzing the column
+// once the histogram has fallen too far behind
+void updateColumnStats(Column* column, long value, size_t num_rows);
+
+// the expected number of rows in [minimum, maximum)
+double estimateRangeRows(const ColumnStats* stats, long minimum, long maximum);
+
+// the estimated number of distinct values
+size_t estimateDistinct(const ColumnStats* stats);
+
+// writes the statistics as the rest of a catalog line, and reads them back
+bool writeColumnStats(FILE* fp, const ColumnStats* stats);
+ColumnStats* readColumnStats(const char* line);
+
+#endif
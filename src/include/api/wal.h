@@ -0,0 +1,51 @@
+// Write-ahead log for statements that modify the database.
+//
+// Every successful create and relational_insert is appended to WAL_PATH as
+// "<lsn> <statement>". Appends are only buffered; a background thread
+// flushes and fsyncs the buffer once per group-commit window, so a crash
+// loses at most WAL_COMMIT_INTERVAL_MS of acknowledged statements.
+// A checkpoint writes the database out, records the last lsn it contains
+// in the catalog and empties the log; on startup, records past that lsn
+// are replayed. Background checkpoints move the log to WAL_OLD_PATH, which
+// is removed once the snapshot is on disk.
+#ifndef WAL_H
+#define WAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define WAL_PATH "./wal"
+#define WAL_OLD_PATH "./wal.old"
+#define WAL_COMMIT_INTERVAL_MS 10
+// logged statements after which a background checkpoint is started
+#define WAL_CHECKPOINT_RECORDS 100000
+
+// true if the statement changes the database and has to be logged
+bool walShouldLog(const char* statement);
+
+// re-executes every logged statement with an lsn past checkpoint_lsn
+bool walReplay(size_t checkpoint_lsn);
+
+// opens the log for appending and starts the group-commit thread
+bool walStart();
+
+// buffers a statement; it becomes durable with the next group commit
+bool walAppend(const char* statement);
+
+// forces every buffered statement to disk
+bool walFlush();
+
+// the lsn of the last statement appended or replayed
+size_t walLastLsn();
+
+// writes the database to disk and truncates the log
+bool walCheckpoint();
+
+// forks a child that checkpoints a snapshot of the database, unless one is
+// already running
+bool walCheckpointInBackground();
+
+// starts a background checkpoint once enough statements have been logged
+void walCheckpointIfDue();
+
+#endif
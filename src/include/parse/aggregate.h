@@ -0,0 +1,16 @@
+#ifndef PARSE_AGGREGATE_H
+#define PARSE_AGGREGATE_H
+
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+bool parse_aggregate_type(char* name, MathType* type);
+DbOperator* parse_aggregate(char* arguments, message* response, char* handles);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef PARSE_ANALYZE_H
+#define PARSE_ANALYZE_H
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+DbOperator* parse_analyze(char* arguments, message* response);
+
+#endif
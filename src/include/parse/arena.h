@@ -0,0 +1,30 @@
+// Bump allocator the parsers build their DbOperators in.
+//
+// An arena hands out memory from a buffer its owner provides and gives it
+// all back at once when it's reset, so a statement can be parsed without
+// touching the heap: parse_command() resets the statement arena before
+// every statement, and nothing parsed outlives the statement's execution.
+#ifndef PARSE_ARENA_H
+#define PARSE_ARENA_H
+
+#include <stddef.h>
+
+// room for the operator and argument arrays of any single statement
+#define PARSE_ARENA_SIZE 65536
+
+typedef struct ParseArena {
+    char* base;
+    size_t size;
+    size_t used;
+} ParseArena;
+
+// makes an empty arena out of the size bytes at base
+void initArena(ParseArena* arena, void* base, size_t size);
+
+// returns bytes of suitably aligned memory, or NULL if the arena is full
+void* arenaAlloc(ParseArena* arena, size_t bytes);
+
+// frees everything allocated from the arena
+void resetArena(ParseArena* arena);
+
+#endif
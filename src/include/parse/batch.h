@@ -12,4 +12,7 @@
 
 DbOperator* parse_batch(char* arguments, message* response);
 
+// parses a statement to queue in the open batch
+DbOperator* parse_batched(char* query, message* response);
+
 #endif
@@ -0,0 +1,9 @@
+#ifndef PARSE_COMBINE_H
+#define PARSE_COMBINE_H
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+DbOperator* parse_combine(char* arguments, message* response, char* handle, bool conjunctive);
+
+#endif
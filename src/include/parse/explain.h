@@ -0,0 +1,9 @@
+#ifndef PARSE_EXPLAIN_H
+#define PARSE_EXPLAIN_H
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+DbOperator* parse_explain(char* arguments, message* response);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef PARSE_GROUPBY_H
+#define PARSE_GROUPBY_H
+
+#include <string.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+DbOperator* parse_group_by(char* arguments, message* response, char* handles);
+
+#endif
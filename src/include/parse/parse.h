@@ -1,9 +1,23 @@
 #ifndef PARSE_H_
 #define PARSE_H_
 #include "api/cs165.h"
+#include "parse/arena.h"
 #include "util/message.h"
 
 DbOperator* process_query(char* query, message* send_message);
 DbOperator* parse_command(char* query_command, message* send_message, int client, ClientContext* context);
 
+// Parsers work on the statement in place: tokens point into the statement
+// text, which must outlive the parsed operator.
+
+// checks that arguments are wrapped in parentheses and strips them,
+// setting the response status and returning NULL if they aren't
+char* unwrap_arguments(char* arguments, message* response);
+
+// allocates from the arena the current statement is parsed into
+void* parse_alloc(size_t bytes);
+
+// makes the parsers allocate from arena, returning the arena they used
+ParseArena* parse_use_arena(ParseArena* arena);
+
 #endif
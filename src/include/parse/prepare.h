@@ -0,0 +1,13 @@
+#ifndef PARSE_PREPARE_H
+#define PARSE_PREPARE_H
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+// room for a prepared statement's operator, on top of its text
+#define PREPARED_STATEMENT_SIZE 4096
+
+DbOperator* parse_prepare(char* arguments, message* response, char* handle);
+DbOperator* parse_execute(char* arguments, message* response);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef PARSE_STATS_H
+#define PARSE_STATS_H
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+DbOperator* parse_stats(char* arguments, message* response);
+
+#endif
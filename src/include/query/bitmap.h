@@ -0,0 +1,42 @@
+// Bitmap selections.
+//
+// A select keeps its positions either as an array of ints or, once the
+// selection is dense enough, as a bitmap with one bit per row of the table:
+// at 32 bits per position, the bitmap is smaller as soon as more than one
+// row in 32 qualifies. Bitmaps always list rows in order, and two of them
+// are intersected or united a word at a time. Operators that can't read a
+// bitmap directly get the positions back through resultPayload().
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#include <stdint.h>
+
+#include "api/cs165.h"
+
+// a selection of at least one row in BITMAP_DENSITY is kept as a bitmap
+#define BITMAP_DENSITY 32
+
+// 64-bit words in a bitmap over num_rows rows
+size_t bitmapWords(size_t num_rows);
+
+// true if num_tuples positions out of num_rows rows are stored smaller as a
+// bitmap
+bool preferBitmap(size_t num_tuples, size_t num_rows);
+
+// stores a selection of num_tuples rows given as a bitmap over num_rows
+// rows, turning it into positions if it's too sparse. Takes over words.
+void storeBitmap(Result* result, uint64_t* words, size_t num_rows, size_t num_tuples);
+
+// stores a selection given as positions below num_rows, turning it into a
+// bitmap if it's dense enough. Takes over positions.
+void storePositions(Result* result, int* positions, size_t num_tuples, size_t num_rows);
+
+// returns the payload of a result. A bitmap is listed as positions in
+// *copy, which the caller frees; otherwise *copy is NULL.
+void* resultPayload(Result* result, void** copy);
+
+// the rows in both selections (conjunctive) or in either of them, in row
+// order; NULL if out of memory
+Result* combineSelections(Result* left, Result* right, bool conjunctive);
+
+#endif
@@ -19,7 +19,6 @@
 #define COL_INITIAL_SIZE 2000
 #define COL_RESIZE_FACTOR 2
 
-Db *current_db;
 
 char* executeDbOperator(DbOperator* query, message* send_message);
 char* handleCreateQuery(DbOperator* query, message* send_message);
@@ -30,8 +29,27 @@ char* handleFetchQuery(DbOperator* query, message* send_message);
 char* handlePrintQuery(DbOperator* query, message* send_message);
 char* handleBatchQuery(DbOperator* query, message* send_message);
 char* handleMathQuery(DbOperator* query, message* send_message);
+char* handleAggregateQuery(DbOperator* query, message* send_message);
+char* handleGroupByQuery(DbOperator* query, message* send_message);
 char* handleJoinQuery(DbOperator* query, message* send_message);
+char* handlePrepareQuery(DbOperator* query, message* send_message);
+char* handleExecuteQuery(DbOperator* query, message* send_message);
+char* handleStatsQuery(DbOperator* query, message* send_message);
+char* handleExplainQuery(DbOperator* query, message* send_message);
+char* handleAnalyzeQuery(DbOperator* query, message* send_message);
+char* handleCombineQuery(DbOperator* query, message* send_message);
 
-char* handleBatchSelectQuery(BatchedQueries* queries, message* send_message);
+char* handleBatchSelectQuery(ScanGroup* queries, message* send_message);
+
+// looks up the table and column a select reads; returns an error message,
+// or NULL once both are found
+char* resolveSelectColumn(SelectOperator* select, message* send_message);
+
+// true for statements that change neither the database nor anything but
+// their own handles
+bool readsOnly(DbOperator* query);
+
+// stores a result under the given handle of the client
+bool addResultHandle(ClientContext* context, char* name, Result* result);
 
 #endif
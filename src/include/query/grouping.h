@@ -0,0 +1,21 @@
+// Key grouping for the group_by operator.
+//
+// Keys are mapped onto dense group ids so that the per-group accumulators
+// can live in plain arrays indexed by id. Keys spanning a small range are
+// mapped through a directly indexed array; everything else goes through an
+// open-addressing table with linear probing, which keeps each probe within
+// a cache line or two.
+#ifndef GROUPING_H
+#define GROUPING_H
+
+#include "api/cs165.h"
+
+// key ranges up to this many values are grouped without hashing
+#define DIRECT_GROUP_LIMIT 65536
+
+// assigns every key a group id in order of first appearance. groups must
+// have room for num_tuples ids; *group_keys receives a new array holding
+// the key of every group. Returns the number of groups.
+size_t assignGroups(DataType type, const void* keys, size_t num_tuples, int* groups, long** group_keys);
+
+#endif
@@ -0,0 +1,57 @@
+// Parallel radix hash join.
+//
+// Both inputs are split into JOIN_PARTITIONS partitions by the high bits of
+// a hash of their keys, and each pair of partitions is then joined on its
+// own through a small chained hashtable that fits in cache. Every phase is
+// shared by a team of threads that claim work with an atomic counter:
+// morsels of JOIN_MORSEL_ROWS tuples while partitioning, whole partitions
+// while joining. A histogram per morsel gives every morsel its own slice of
+// each partition to write to, and every partition collects its matches on
+// its own, so no phase takes a lock.
+//
+// Joins expected to need more than JOIN_MEMORY_BYTES of working memory run
+// as grace hash joins instead: both sides are partitioned the same way into
+// temporary files, and the pairs of partitions are joined one at a time. A
+// partition whose build side still doesn't fit is partitioned again on the
+// next bits of the hash, up to GRACE_MAX_DEPTH times; past that, which only
+// happens when most of it shares a key, it's joined in memory regardless.
+// Only the inputs and the matches are ever held in memory whole.
+#ifndef HASHJOIN_H
+#define HASHJOIN_H
+
+#include "api/cs165.h"
+
+#define JOIN_PARTITION_BITS 7
+#define JOIN_PARTITIONS (1 << JOIN_PARTITION_BITS)
+
+// tuples a thread partitions at a time
+#define JOIN_MORSEL_ROWS 16384
+
+// threads never outnumber the cores, nor this
+#define JOIN_MAX_THREADS 32
+
+// working memory a join may use; can be set at build time with
+// make CFLAGS=-DJOIN_MEMORY_BYTES=<bytes>
+#ifndef JOIN_MEMORY_BYTES
+#define JOIN_MEMORY_BYTES ((size_t) 1 << 30)
+#endif
+
+// bytes a tuple takes while it's joined in memory: its key, its row and
+// its share of the hashtable
+#define JOIN_TUPLE_BYTES 24
+
+// times a partition is split again before it's joined regardless
+#define GRACE_MAX_DEPTH 4
+
+// true if a join of inputs this large spills to disk
+bool hashJoinSpills(size_t num_tuples1, size_t num_tuples2);
+
+// joins values1 with values2 on equal keys; positions1 and positions2 give
+// the position reported for every value. The positions of each matching
+// pair are appended to *result1 and *result2, allocated by the call, and
+// *count receives the number of pairs. Returns false if out of memory.
+bool hashJoin(DataType type1, const void* values1, const int* positions1, size_t num_tuples1,
+    DataType type2, const void* values2, const int* positions2, size_t num_tuples2,
+    int** result1, int** result2, size_t* count);
+
+#endif
@@ -0,0 +1,31 @@
+// Index nested-loop join.
+//
+// When the inner side of a join is a base column with an index, nothing
+// needs to fetch or hash the whole column: every outer key is looked up in
+// the index, which only touches the rows that match. Probes go in key
+// order, sorted in batches unless the outer values already ascend, so a
+// lookup starts from where the previous one ended: a clustered column or a
+// sorted index gallops forward from the last match, and an unclustered
+// btree walks along its leaves instead of descending from the root again.
+// A key repeated on the outer side reuses the matches of the first.
+#ifndef INDEXJOIN_H
+#define INDEXJOIN_H
+
+#include "api/cs165.h"
+
+// outer tuples sorted and probed together when the outer values are out of
+// order
+#define INDEX_JOIN_BATCH 4096
+
+// an unclustered btree lookup follows the leaf chain for at most this many
+// leaves before descending from the root instead
+#define INDEX_JOIN_LEAF_WALK 8
+
+// joins the outer values, at the given positions, with the rows of the
+// table whose value in index->column is equal. *result1 receives outer
+// positions and *result2 inner rows, *count the number of matches; both
+// arrays are allocated by the call. Returns false if memory ran out.
+bool indexJoin(DataType type, const void* values, const int* positions, size_t num_tuples, bool sorted,
+    Table* table, Index* index, int** result1, int** result2, size_t* count);
+
+#endif
@@ -0,0 +1,136 @@
+// Column kernels specialized per storage width.
+//
+// Every kernel is generated once per integer type from a single macro body
+// in query/kernels.c, so a scan over a byte column touches a quarter of the
+// memory a scan over an int column would. The functions declared here take
+// the storage type and dispatch to the matching specialization once per call.
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <stdint.h>
+
+#include "api/cs165.h"
+
+// X-macro listing every integer storage type together with its C type
+#define FOR_EACH_INT_TYPE(X) \
+    X(BYTE, int8_t) \
+    X(SHORT, int16_t) \
+    X(INT, int) \
+    X(LONG, long)
+
+// stores the positions of all values in [minimum, maximum), numbering the
+// first value first_row; positions must have room for num_rows entries.
+// Returns the number of positions stored.
+size_t selectRange(DataType type, const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, int* positions);
+
+// selectRange into a bitmap of rows: sets the bit of every row whose value
+// is in [minimum, maximum) and returns how many were set
+size_t selectRangeBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, uint64_t* words);
+
+// runs num_queries range selections in one pass over the data; results and
+// num_tuples receive one (grown on demand) position array and count per query
+bool selectRangeBatch(DataType type, const void* data, size_t first_row, size_t num_rows,
+    long* minimum, long* maximum, int num_queries, int** results, size_t* num_tuples);
+
+// stores src[i] for every values[i] in [minimum, maximum); positions must
+// have room for num_tuples entries. Returns the number of positions stored.
+size_t selectValues(DataType type, const void* values, const int* src, size_t num_tuples, long minimum, long maximum, int* positions);
+
+// selectValues for a selection kept as a bitmap over num_rows rows: the
+// i-th value belongs to the i-th row set in src, and rows whose value is
+// in range are set in words. Returns the number of rows set.
+size_t selectValuesBitmap(DataType type, const void* values, const uint64_t* src, size_t num_rows, long minimum, long maximum, uint64_t* words);
+
+// clears the bit of every row set in the bitmap among [first_row, first_row
+// + num_rows) whose value is outside [minimum, maximum); data holds those
+// rows. Returns the number of rows left set.
+size_t refineBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, uint64_t* words);
+
+// keeps the positions whose data[positions[i]] is in [minimum, maximum),
+// compacting them in place; returns how many are left
+size_t refinePositions(DataType type, const void* data, int* positions, size_t num_tuples, long minimum, long maximum);
+
+// gathers data[positions[i]] into out, which has the same storage type
+void fetchValues(DataType type, const void* data, const int* positions, size_t num_tuples, void* out);
+
+// gathers the values of the rows set in the bitmap among [first_row,
+// first_row + num_rows) into out, in row order; data holds those rows.
+// Returns the number of values gathered.
+size_t fetchBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, const uint64_t* words, void* out);
+
+// true if no value is smaller than the one before it
+bool valuesAscend(DataType type, const void* data, size_t num_tuples);
+
+// widens every value to a long
+void widenValues(DataType type, const void* data, size_t num_tuples, long* out);
+
+// aggregates a fused pass has to maintain
+#define AGG_SUM 1
+#define AGG_MINMAX 2
+#define AGG_ALL (AGG_SUM | AGG_MINMAX)
+
+// results of a fused aggregation pass; min and max are 0 when count is 0
+typedef struct Aggregates {
+    long sum;
+    long min;
+    long max;
+    size_t count;
+} Aggregates;
+
+// computes the requested aggregates in a single pass with 64-bit
+// accumulators. If positions is not NULL only data[positions[i]] is read,
+// so a selection can be aggregated straight off a base column.
+void aggregateValues(DataType type, const void* data, const int* positions, size_t num_tuples, int which, Aggregates* out);
+
+// aggregateValues over the rows set in the bitmap among [first_row,
+// first_row + num_rows); data holds those rows
+void aggregateBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, const uint64_t* words,
+    int which, Aggregates* out);
+
+// folds data[i] into the accumulators of group groups[i]. sums and counts
+// must start at 0, mins at LONG_MAX and maxs at LONG_MIN; sums are only
+// updated for AGG_SUM and mins/maxs only for AGG_MINMAX.
+void aggregateGroups(DataType type, const void* data, const int* groups, size_t num_tuples, int which,
+    long* sums, long* mins, long* maxs, size_t* counts);
+
+// the storage type ADD/SUB produce for inputs of the given type
+DataType combinedType(DataType type);
+
+// element-wise ADD or SUB of two inputs of the same type into out, which
+// is stored as combinedType(type)
+void combineValues(MathType op, DataType type, const void* data1, const void* data2, size_t num_tuples, void* out);
+
+// The scans below run the kernels over the first num_rows rows of a base
+// column, one contiguous chunk at a time, so they work on paged columns
+// too: each page is pinned only while its chunk is processed. They return
+// false if a page can't be read, in which case their output is incomplete.
+
+// selectRange over a column; count receives the number of positions stored
+bool scanColumn(Column* column, size_t num_rows, long minimum, long maximum, int* positions, size_t* count);
+
+// selectRangeBitmap over a column; words must start out cleared
+bool scanColumnBitmap(Column* column, size_t num_rows, long minimum, long maximum, uint64_t* words, size_t* count);
+
+// selectRangeBatch over a column
+bool scanColumnBatch(Column* column, size_t num_rows,
+    long* minimum, long* maximum, int num_queries, int** results, size_t* num_tuples);
+
+// fetchValues over a column
+bool fetchColumn(Column* column, const int* positions, size_t num_tuples, void* out);
+
+// fetchBitmap over the first num_rows rows of a column
+bool fetchColumnBitmap(Column* column, const uint64_t* words, size_t num_rows, void* out);
+
+// refineBitmap over the first num_rows rows of a column
+bool refineColumnBitmap(Column* column, size_t num_rows, long minimum, long maximum, uint64_t* words, size_t* count);
+
+// refinePositions over a column
+bool refineColumnPositions(Column* column, int* positions, size_t num_tuples, long minimum, long maximum, size_t* count);
+
+// aggregateValues over a column; with positions only those rows are read
+bool aggregateColumn(Column* column, size_t num_rows, const int* positions, size_t num_tuples, int which, Aggregates* out);
+
+// aggregateBitmap over the first num_rows rows of a column
+bool aggregateColumnBitmap(Column* column, const uint64_t* words, size_t num_rows, int which, Aggregates* out);
+
+#endif
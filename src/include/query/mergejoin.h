@@ -0,0 +1,21 @@
+// Sort-merge join.
+//
+// Inputs that are already in key order, like values fetched in row order
+// from a column with a clustered index, are joined in one sequential pass
+// over both: each run of equal keys on one side is matched with the run of
+// the same key on the other, and everything in between is skipped. Inputs
+// out of order are first sorted with an LSD radix sort that skips the
+// bytes all keys agree on. No hashtable is built, and the matches come out
+// in key order.
+#ifndef MERGEJOIN_H
+#define MERGEJOIN_H
+
+#include "api/cs165.h"
+
+// joins values1 with values2 like hashJoin() does; sorted1 and sorted2 tell
+// whether each input is in ascending order already
+bool mergeJoin(DataType type1, const void* values1, const int* positions1, size_t num_tuples1, bool sorted1,
+    DataType type2, const void* values2, const int* positions2, size_t num_tuples2, bool sorted2,
+    int** result1, int** result2, size_t* count);
+
+#endif
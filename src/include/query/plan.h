@@ -0,0 +1,42 @@
+// Access path selection.
+//
+// A select on a base column can read it through any index on the column or
+// scan it. A clustered index only touches the rows in range and hands fetch
+// positions in order, so it always wins. An unclustered index pays a random
+// access per match and produces positions in value order, which makes the
+// following fetch jump around the column; past a small fraction of the rows
+// a sequential scan of the column is cheaper. Composite and covering indexes
+// hand the columns they copy to fetches in entry order, so like a clustered
+// index they're always used.
+#ifndef PLAN_H
+#define PLAN_H
+
+#include "api/cs165.h"
+
+// relative cost of producing one match through an unclustered index, in
+// rows of sequential scan: the index is chosen while it is expected to
+// match fewer than 1 in UNCLUSTERED_MATCH_COST rows
+#define UNCLUSTERED_MATCH_COST 16
+
+// rows sampled to estimate a range when neither an index nor the column
+// statistics can
+#define SELECTIVITY_SAMPLE_ROWS 64
+
+// the cheapest index for a select of [minimum, maximum) on the column, or
+// NULL if a full scan is cheaper. *estimated_rows receives the expected
+// number of matches.
+Index* chooseSelectIndex(Table* table, Column* column, long minimum, long maximum, long* estimated_rows);
+
+// the expected number of rows of the column in [minimum, maximum); exact
+// when the index keeps the values sorted, from the column statistics
+// otherwise
+long estimateSelectRows(Table* table, Column* column, Index* index, long minimum, long maximum);
+
+// the index an index nested-loop join looks the column's values up in, or
+// NULL if the column has none
+Index* chooseJoinIndex(Table* table, Column* column);
+
+// names an access path for explain(); NULL is a full scan
+const char* accessPathName(Index* index);
+
+#endif
@@ -0,0 +1,38 @@
+// Scans shared across clients.
+//
+// The server answers its clients one statement at a time. A select that
+// would scan its column in full doesn't run when it arrives while other
+// clients are connected: it waits, for at most SHARED_SCAN_WINDOW_MS, for
+// selects of other clients on the same column, and all of them are then
+// answered by one pass over the column. Each client gets its own result
+// under its own handle, and hears back once the pass is done; until then
+// it can't send anything else, so statements of one client still run in
+// order. Selects read through an index or a cracker run on their own.
+#ifndef SHAREDSCAN_H
+#define SHAREDSCAN_H
+
+#include <stdint.h>
+
+#include "api/cs165.h"
+#include "util/message.h"
+
+// how long the first queued select waits for others to join its scan
+#define SHARED_SCAN_WINDOW_MS 2
+
+// answers a queued select of the client once its scan is done
+typedef void (*SharedScanReply)(int client_fd, message* send_message, char* result, uint64_t parse_ns,
+    uint64_t execute_ns);
+
+// queues a select that would scan its column in full, creating its handle
+// with a result that stays empty until the scan runs. Returns false, with
+// nothing queued, for any other statement.
+bool queueSharedSelect(DbOperator* query, uint64_t parse_ns);
+
+// the number of selects waiting for a scan
+size_t sharedSelectsQueued();
+
+// scans every column queued selects read once, for all of them, and
+// replies to each
+void runSharedScans(SharedScanReply reply);
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "api/cs165.h"
 
+// frees an index object and whatever of its structure was built
+void freeIndex(Index* index);
 // frees a table object
 void freeTable(Table* tbl);
 // frees a database object
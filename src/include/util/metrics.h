@@ -0,0 +1,77 @@
+// Per-operator counters and latency histograms.
+//
+// Every thread records into a buffer of its own, so recording a statement
+// is a handful of unsynchronized adds. A report merges the buffers of all
+// threads; counts still being recorded by another thread may be missed.
+#ifndef UTIL_METRICS_H
+#define UTIL_METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "api/cs165.h"
+
+// the phases every statement's latency is split into
+typedef enum StatsPhase {
+    PHASE_PARSE,
+    PHASE_EXECUTE,
+    PHASE_SEND,
+    NUM_PHASES
+} StatsPhase;
+
+// statements are counted by operator type; those that didn't parse into
+// an operator (comments, unknown commands) are counted as STATS_UNPARSED
+#define STATS_UNPARSED (OP_COMBINE + 1)
+#define NUM_STATS_OPERATORS (STATS_UNPARSED + 1)
+
+// bucket i of a latency histogram counts latencies below 2^i microseconds
+// (and at least 2^(i-1)); the last bucket counts everything slower
+#define LATENCY_BUCKETS 32
+
+// the name of an operator type in reports
+const char* statsOperatorName(int type);
+
+// monotonic time in nanoseconds
+uint64_t statsNow();
+
+// records the phase latencies of one statement of the given operator type
+void statsRecordStatement(int type, uint64_t parse_ns, uint64_t execute_ns, uint64_t send_ns);
+
+// adds the rows an operator read and the rows (or values) it produced
+void statsAddRows(int type, size_t scanned, size_t produced);
+
+// what explain() learns about the one statement it runs
+#define MAX_TRACE_PHASES 8
+typedef struct StatsTrace {
+    // how the operator reached its input, or NULL if it didn't say
+    const char* access_path;
+    // rows the operator expected to produce, or -1 if it couldn't tell
+    long estimated_rows;
+    size_t rows_scanned;
+    size_t rows_produced;
+    const char* phase_names[MAX_TRACE_PHASES];
+    uint64_t phase_ns[MAX_TRACE_PHASES];
+    size_t num_phases;
+    uint64_t phase_start;
+} StatsTrace;
+
+// starts collecting what this thread's operators report into trace, on
+// top of the counters, until statsTraceStop()
+void statsTraceStart(StatsTrace* trace);
+void statsTraceStop();
+
+// notes the access path an operator chose and the rows it expects
+void statsTraceAccess(const char* access_path, long estimated_rows);
+
+// ends a phase of the traced operator; it began where the last one ended
+void statsTracePhase(const char* name);
+
+// formats the merged counters of every thread; the returned report is
+// valid until the next call
+const char* statsReport();
+
+// writes the report to the file at path
+bool statsDump(const char* path);
+
+#endif
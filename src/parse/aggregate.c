@@ -0,0 +1,112 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "parse/parse.h"
+#include "parse/aggregate.h"
+#include "util/log.h"
+#include "util/strmanip.h"
+
+// maps an aggregate name onto its MathType; returns false for anything else
+bool parse_aggregate_type(char* name, MathType* type) {
+    if (strcmp(name, "avg") == 0)
+        *type = AVG;
+    else if (strcmp(name, "sum") == 0)
+        *type = SUM;
+    else if (strcmp(name, "min") == 0)
+        *type = MIN;
+    else if (strcmp(name, "max") == 0)
+        *type = MAX;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Parses a fused aggregate of the form
+ *     h1,h2,...=aggregate(<source>[,<selection>],<agg1>,<agg2>,...)
+ * where <source> is a variable or a db.tbl.col and every <agg> is one of
+ * avg, sum, min or max. The i-th handle receives the i-th aggregate.
+ **/
+DbOperator* parse_aggregate(char* arguments, message* response, char* handles) {
+    if (response == NULL)
+        return NULL;
+    if (handles == NULL) {
+        response->status = UNKNOWN_COMMAND;
+        return NULL;
+    }
+    char* copy = unwrap_arguments(arguments, response);
+    if (copy == NULL)
+        return NULL;
+
+    // count handles and arguments to size the arrays
+    size_t num_handles = 1;
+    for (char* ptr = handles; *ptr != '\0'; ptr++)
+        num_handles += *ptr == ',';
+    size_t num_args = 1;
+    for (char* ptr = copy; *ptr != '\0'; ptr++)
+        num_args += *ptr == ',';
+
+    // parse the source argument
+    char* source = strsep(&copy, ",");
+    if (source == NULL || copy == NULL) {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+    char** params = parse_alloc(sizeof(char*) * 3);
+    MathType* types = parse_alloc(sizeof(MathType) * num_args);
+    char** targets = parse_alloc(sizeof(char*) * num_handles);
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (params == NULL || types == NULL || targets == NULL || dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    size_t num_params = 0;
+    bool is_var = strchr(source, '.') == NULL;
+    if (is_var) {
+        params[num_params++] = source;
+    } else {
+        params[num_params++] = strsep(&source, ".");
+        params[num_params++] = strsep(&source, ".");
+        params[num_params++] = source;
+        if (params[2] == NULL) {
+            response->status = INCORRECT_FORMAT;
+            return NULL;
+        }
+    }
+
+    // an argument that isn't an aggregate name is the selection
+    size_t num_aggregates = 0;
+    char* selection = NULL;
+    char* token = NULL;
+    while ((token = strsep(&copy, ",")) != NULL) {
+        if (parse_aggregate_type(token, &types[num_aggregates])) {
+            num_aggregates++;
+        } else if (num_aggregates == 0 && selection == NULL && !is_var) {
+            selection = token;
+        } else {
+            response->status = INCORRECT_FORMAT;
+            return NULL;
+        }
+    }
+    if (num_aggregates == 0 || num_aggregates != num_handles) {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+
+    // split the target handles
+    for (size_t i = 0; i < num_handles; i++)
+        targets[i] = strsep(&handles, ",");
+
+    // create aggregate operator object
+    dbo->type = OP_AGGREGATE;
+    dbo->fields.aggregate = (AggregateOperator) {
+        .types = types,
+        .handles = targets,
+        .num_aggregates = num_aggregates,
+        .params = params,
+        .num_params = num_params,
+        .selection = selection,
+        .is_var = is_var
+    };
+    return dbo;
+}
@@ -0,0 +1,31 @@
+#include <string.h>
+
+#include "parse/parse.h"
+#include "parse/analyze.h"
+
+// analyze(db.tbl) rebuilds the statistics of every column of the table
+DbOperator* parse_analyze(char* arguments, message* response) {
+    if (response == NULL)
+        return NULL;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
+        return NULL;
+
+    char* db_name = strsep(&args, ".");
+    if (args == NULL || *db_name == '\0' || *args == '\0') {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    dbo->type = OP_ANALYZE;
+    dbo->fields.analyze = (AnalyzeOperator) {
+        .db_name = db_name,
+        .tbl_name = args
+    };
+    return dbo;
+}
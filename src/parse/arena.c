@@ -0,0 +1,21 @@
+#include "parse/arena.h"
+
+void initArena(ParseArena* arena, void* base, size_t size) {
+    arena->base = (char*) base;
+    arena->size = size;
+    arena->used = 0;
+}
+
+void* arenaAlloc(ParseArena* arena, size_t bytes) {
+    // align every allocation for the widest type an operator holds
+    size_t align = sizeof(long double);
+    size_t start = (arena->used + align - 1) & ~(align - 1);
+    if (start > arena->size || bytes > arena->size - start)
+        return NULL;
+    arena->used = start + bytes;
+    return arena->base + start;
+}
+
+void resetArena(ParseArena* arena) {
+    arena->used = 0;
+}
@@ -1,14 +1,61 @@
+#include "parse/parse.h"
 #include "parse/batch.h"
+#include "parse/prepare.h"
 
 DbOperator* parse_batch(char* arguments, message* response) {
     response->status = OK_DONE;
     arguments[7] = '\0';
     
     // create DbOperator and return
-    DbOperator* result = malloc(sizeof(DbOperator));
+    DbOperator* result = parse_alloc(sizeof(DbOperator));
+    if (result == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
     result->type = OP_BATCH;
     result->fields.batch = (BatchOperator) {
         .start = strcmp(arguments, "queries") == 0
     };
     return result;
 }
+
+// a statement sent while a batch is open is parsed right away, so errors
+// still surface, into a block of its own like a prepared statement. The
+// block also keeps the text for the log; argument arrays never take more
+// than a word per character of it.
+DbOperator* parse_batched(char* query, message* response) {
+    size_t len = strlen(query) + 1;
+    size_t size = 2 * len + sizeof(long) * len + PREPARED_STATEMENT_SIZE;
+    char* memory = malloc(size);
+    if (memory == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    ParseArena arena;
+    initArena(&arena, memory, size);
+    char* text = arenaAlloc(&arena, len);
+    char* copy = arenaAlloc(&arena, len);
+    memcpy(text, query, len);
+    memcpy(copy, query, len);
+
+    ParseArena* statement_arena = parse_use_arena(&arena);
+    DbOperator* statement = process_query(copy, response);
+    parse_use_arena(statement_arena);
+    if (statement == NULL) {
+        free(memory);
+        return NULL;
+    }
+
+    DbOperator* result = parse_alloc(sizeof(DbOperator));
+    if (result == NULL) {
+        free(memory);
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    result->type = OP_BATCH;
+    result->fields.batch = (BatchOperator) {
+        .start = false,
+        .queued = { .statement = statement, .text = text, .memory = memory }
+    };
+    return result;
+}
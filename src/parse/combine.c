@@ -0,0 +1,33 @@
+#include <string.h>
+
+#include "parse/parse.h"
+#include "parse/combine.h"
+
+// and(s1,s2) and or(s1,s2) intersect or unite two selections
+DbOperator* parse_combine(char* arguments, message* response, char* handle, bool conjunctive) {
+    if (response == NULL)
+        return NULL;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
+        return NULL;
+
+    char* left = strsep(&args, ",");
+    if (handle == NULL || args == NULL || *left == '\0' || *args == '\0' || strchr(args, ',') != NULL) {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    dbo->type = OP_COMBINE;
+    dbo->fields.combine = (CombineOperator) {
+        .conjunctive = conjunctive,
+        .left = left,
+        .right = args,
+        .handle = handle
+    };
+    return dbo;
+}
@@ -1,6 +1,7 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "parse/parse.h"
 #include "parse/create.h"
 #include "util/log.h"
 #include "util/strmanip.h"
@@ -14,13 +15,8 @@ DbOperator* parse_create(char* arguments, message* response) {
         return NULL;
     }
     
-    // create a copy of string
-    size_t space = strlen(arguments) + 1;
-    char *copy = malloc(space * sizeof(char));
-    strcpy(copy, arguments);
-    
-    // parse arguments
-    copy++;
+    // parse arguments in place
+    char* copy = arguments + 1;
     char* token = strsep(&copy, ",");
     if (token == NULL) {
         // invalid query format
@@ -74,9 +70,13 @@ DbOperator* parse_create_db(char* arguments, message* response) {
     }
     
     // create DbOperator and return
-    DbOperator* result = malloc(sizeof(DbOperator));
+    DbOperator* result = parse_alloc(sizeof(DbOperator));
+    char** params = parse_alloc(sizeof(char*));
+    if (result == NULL || params == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
     result->type = OP_CREATE;
-    char** params = malloc(sizeof(char*));
     params[0] = db_name;
     result->fields.create = (CreateOperator) {
         .type = CREATE_DB, 
@@ -120,9 +120,13 @@ DbOperator* parse_create_tbl(char* arguments, message* response) {
     }
     
     // create DbOperator and return
-    DbOperator* result = malloc(sizeof(DbOperator));
+    DbOperator* result = parse_alloc(sizeof(DbOperator));
+    char** params = parse_alloc(3 * sizeof(char*));
+    if (result == NULL || params == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
     result->type = OP_CREATE;
-    char** params = malloc(3 * sizeof(char*));
     params[0] = db_name;
     params[1] = table_name;
     params[2] = col_cnt;
@@ -144,20 +148,27 @@ DbOperator* parse_create_col(char* arguments, message* response) {
     char** arguments_index = &arguments;
     char* col_name = next_token(arguments_index, &(response->status));
     char* table_path = next_token(arguments_index, &(response->status));
+    // the storage type is an optional trailing argument
+    char* type = strsep(arguments_index, ",");
 
     col_name = trim_quotes(col_name);
     // not enough arguments
     if (response->status == INCORRECT_FORMAT) {
         return NULL;
     }
+    if (*arguments_index != NULL) {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
 
     // read and chop off last char
-    int last_char = strlen(table_path) - 1;
-    if (table_path[last_char] != ')') {
+    char* last_arg = (type == NULL) ? table_path : type;
+    int last_char = strlen(last_arg) - 1;
+    if (last_char < 0 || last_arg[last_char] != ')') {
         response->status = INCORRECT_FORMAT;
         return NULL;
     }
-    table_path[last_char] = '\0';
+    last_arg[last_char] = '\0';
 
     // pull out database and table from table_path
     char* db_name = trim_quotes(table_path);
@@ -171,16 +182,21 @@ DbOperator* parse_create_col(char* arguments, message* response) {
     }
 
     // create DbOperator and return
-    DbOperator* result = malloc(sizeof(DbOperator));
+    DbOperator* result = parse_alloc(sizeof(DbOperator));
+    char** params = parse_alloc(4 * sizeof(char*));
+    if (result == NULL || params == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
     result->type = OP_CREATE;
-    char** params = malloc(3 * sizeof(char*));
     params[0] = db_name;
     params[1] = tbl_name;
     params[2] = col_name;
+    params[3] = type;
     result->fields.create = (CreateOperator) {
         .type = CREATE_COL, 
         .params = params,
-        .num_params = 3
+        .num_params = (type == NULL) ? 3 : 4
     };
     return result;
 }
@@ -188,6 +204,9 @@ DbOperator* parse_create_col(char* arguments, message* response) {
 /**
  * This method takes in a string representing the arguments to create an index.
  * It parses those arguments, checks that they are valid, and creates an index.
+ * A composite index joins its key columns with '+', as in db.tbl.col1+col2,
+ * and a covering index lists the columns it includes last, as in
+ * create(idx,db.tbl.col1,sorted,unclustered,col3,col4).
  **/
 
 DbOperator* parse_create_idx(char* arguments, message* response) {
@@ -200,17 +219,30 @@ DbOperator* parse_create_idx(char* arguments, message* response) {
     // check for # of arguments
     if (response->status == INCORRECT_FORMAT)
         return NULL;
+
+    // a covering index names the columns it includes after the others
+    size_t num_included = 0;
     if (*arguments_index != NULL) {
-        response->status = INCORRECT_FORMAT;
+        num_included = 1;
+        for (char* c = *arguments_index; *c != '\0'; c++)
+            num_included += (*c == ',');
+    }
+    char** params = parse_alloc((5 + num_included) * sizeof(char*));
+    if (params == NULL) {
+        response->status = EXECUTION_ERROR;
         return NULL;
     }
+    for (size_t i = 0; i < num_included; i++)
+        params[5 + i] = strsep(arguments_index, ",");
+
     // check and chop off ending parenthesis
-    int last_char = strlen(cluster) - 1;
-    if (cluster[last_char] != ')') {
+    char* last = (num_included > 0) ? params[4 + num_included] : cluster;
+    int last_char = strlen(last) - 1;
+    if (last_char < 0 || last[last_char] != ')') {
         response->status = INCORRECT_FORMAT;
         return NULL;
     }
-    cluster[last_char] = '\0';
+    last[last_char] = '\0';
 
     // pull out database and table from table_path
     char* db_name = strsep(&col_path, ".");
@@ -230,9 +262,12 @@ DbOperator* parse_create_idx(char* arguments, message* response) {
     }
 
     // create DbOperator and return
-    DbOperator* result = malloc(sizeof(DbOperator));
+    DbOperator* result = parse_alloc(sizeof(DbOperator));
+    if (result == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
     result->type = OP_CREATE;
-    char** params = malloc(5 * sizeof(char*));
     params[0] = db_name;
     params[1] = tbl_name;
     params[2] = col_name;
@@ -241,7 +276,7 @@ DbOperator* parse_create_idx(char* arguments, message* response) {
     result->fields.create = (CreateOperator) {
         .type = CREATE_IDX, 
         .params = params,
-        .num_params = 5
+        .num_params = 5 + num_included
     };
     return result;
 }
@@ -0,0 +1,45 @@
+#include <string.h>
+
+#include "parse/parse.h"
+#include "parse/explain.h"
+#include "util/metrics.h"
+
+// explain(<statement>): runs the statement once and reports how it was
+// executed instead of its result. explain(<statement>,plan) leaves out the
+// timings, so the report is the same on every run.
+DbOperator* parse_explain(char* arguments, message* response) {
+    if (response == NULL)
+        return NULL;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
+        return NULL;
+
+    // the option follows the statement's closing parenthesis
+    bool plan_only = false;
+    char* option = strrchr(args, ')');
+    if (option != NULL && strcmp(option + 1, ",plan") == 0) {
+        option[1] = '\0';
+        plan_only = true;
+    }
+
+    uint64_t start = statsNow();
+    DbOperator* statement = process_query(args, response);
+    if (statement == NULL) {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+    uint64_t parsed = statsNow();
+
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    dbo->type = OP_EXPLAIN;
+    dbo->fields.explain = (ExplainOperator) {
+        .statement = statement,
+        .parse_ns = parsed - start,
+        .plan_only = plan_only
+    };
+    return dbo;
+}
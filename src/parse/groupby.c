@@ -0,0 +1,76 @@
+#include <string.h>
+#include <stdio.h>
+
+#include "parse/parse.h"
+#include "parse/groupby.h"
+#include "parse/aggregate.h"
+#include "util/log.h"
+#include "util/strmanip.h"
+
+/**
+ * Parses a grouped aggregation of the form
+ *     k,h1,h2,...=group_by(<keys>,<values1>,<agg1>,<values2>,<agg2>,...)
+ * where every argument is a variable of the same length and every <agg>
+ * is one of avg, sum, min or max. k receives the distinct keys and the
+ * i-th handle the i-th aggregate of each group, in the same order.
+ **/
+DbOperator* parse_group_by(char* arguments, message* response, char* handles) {
+    if (response == NULL)
+        return NULL;
+    if (handles == NULL) {
+        response->status = UNKNOWN_COMMAND;
+        return NULL;
+    }
+    char* copy = unwrap_arguments(arguments, response);
+    if (copy == NULL)
+        return NULL;
+
+    // count handles and arguments; both are a key followed by one entry
+    // per aggregate
+    size_t num_handles = 1;
+    for (char* ptr = handles; *ptr != '\0'; ptr++)
+        num_handles += *ptr == ',';
+    size_t num_args = 1;
+    for (char* ptr = copy; *ptr != '\0'; ptr++)
+        num_args += *ptr == ',';
+    size_t num_aggregates = num_handles - 1;
+    if (num_aggregates == 0 || num_args != 1 + 2 * num_aggregates) {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+
+    char* keys = strsep(&copy, ",");
+    char** values = parse_alloc(sizeof(char*) * num_aggregates);
+    MathType* types = parse_alloc(sizeof(MathType) * num_aggregates);
+    char** targets = parse_alloc(sizeof(char*) * num_aggregates);
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (values == NULL || types == NULL || targets == NULL || dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    for (size_t i = 0; i < num_aggregates; i++) {
+        values[i] = strsep(&copy, ",");
+        char* name = strsep(&copy, ",");
+        if (strchr(values[i], '.') != NULL || !parse_aggregate_type(name, &types[i])) {
+            response->status = INCORRECT_FORMAT;
+            return NULL;
+        }
+    }
+
+    // split the target handles
+    char* key_handle = strsep(&handles, ",");
+    for (size_t i = 0; i < num_aggregates; i++)
+        targets[i] = strsep(&handles, ",");
+
+    // create group by operator object
+    dbo->type = OP_GROUP_BY;
+    dbo->fields.group_by = (GroupByOperator) {
+        .keys = keys,
+        .key_handle = key_handle,
+        .values = values,
+        .types = types,
+        .handles = targets,
+        .num_aggregates = num_aggregates
+    };
+    return dbo;
+}
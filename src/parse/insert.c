@@ -1,3 +1,6 @@
+#include <stdlib.h>
+
+#include "parse/parse.h"
 #include "parse/insert.h"
 #include "util/log.h"
 #include "util/strmanip.h"
@@ -14,46 +17,45 @@ DbOperator* parse_insert(char* arguments, message* response) {
     arguments++;
     char** command_index = &arguments;
     char* table_name = next_token(command_index, &(response->status));
-    if (response->status == INCORRECT_FORMAT) {
+    if (response->status == INCORRECT_FORMAT || arguments == NULL) {
+        response->status = INCORRECT_FORMAT;
         return NULL;
     }
     while (*table_name != '\0' && *table_name != '.')
         table_name++;
     table_name++;
-    
-    // create insert operator object
-    DbOperator* dbo = calloc(1, sizeof(DbOperator));
-    dbo->type = OP_INSERT;
-    dbo->fields.insert.tbl_name = table_name;
-    
-    // get values from query
-    size_t columns_inserted = 1;
-    char* cpy = arguments;
-    while (*cpy != '\0') {
-        if (*cpy == ',')
-            columns_inserted++;
-        cpy++;
+
+    // every value takes at least a digit and a separator, which bounds the
+    // number of values without counting them first
+    size_t max_values = strlen(arguments) / 2 + 1;
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    long* values = parse_alloc(sizeof(long) * max_values);
+    if (dbo == NULL || values == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
     }
-    dbo->fields.insert.num_values = columns_inserted;
-    if (dbo->fields.insert.values == NULL) {
-        dbo->fields.insert.values = calloc(columns_inserted, sizeof(int));
-    } else {
-        int* new_data = realloc(dbo->fields.insert.values, sizeof(int) * columns_inserted);
-        if (new_data == NULL) {
-            response->status = EXECUTION_ERROR;
+    
+    // convert the values in a single pass, stopping at the closing ')'
+    size_t num_values = 0;
+    char* cursor = arguments;
+    while (true) {
+        char* end;
+        values[num_values++] = strtol(cursor, &end, 10);
+        if (end == cursor || (*end != ',' && *end != ')')) {
+            response->status = INCORRECT_FORMAT;
             return NULL;
         }
-        dbo->fields.insert.values = new_data;
-    }   
- 
-    // iterate down values and insert one by one
-    int index = 0;
-    char* token = NULL;
-    while ((token = strsep(command_index, ",")) != NULL) {
-        int insert_val = atoi(token);
-        dbo->fields.insert.values[index] = insert_val;
-        index++;
+        if (*end == ')')
+            break;
+        cursor = end + 1;
     }
 
+    // create insert operator object
+    dbo->type = OP_INSERT;
+    dbo->fields.insert = (InsertOperator) {
+        .tbl_name = table_name,
+        .values = values,
+        .num_values = num_values
+    };
     return dbo;
 }
@@ -1,6 +1,7 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "parse/parse.h"
 #include "parse/join.h"
 #include "util/log.h"
 #include "util/strmanip.h"
@@ -8,22 +9,13 @@
 DbOperator* parse_join(char* arguments, message* response, char* handles) {
     if (response == NULL)
         return NULL;
-    if (arguments == NULL || *arguments != '(') {
-        response->status = UNKNOWN_COMMAND;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
         return NULL;
-    }
-    arguments++;
-
-    // create a copy of string
-    size_t space = strlen(arguments) + 1;
-    char* copy = malloc(space * sizeof(char));
-    strcpy(copy, arguments);
-    size_t len = strlen(copy);
-    if (copy[len - 1] != ')') {
+    if (handles == NULL) {
         response->status = INCORRECT_FORMAT;
         return NULL;
     }
-    copy[len - 1] = '\0';
     
     // pull first and second handles out
     char* handle1 = handles;
@@ -38,43 +30,51 @@ DbOperator* parse_join(char* arguments, message* response, char* handles) {
     handle2++;
 
     // parse select and fetch handles
-    char* fetch1 = strsep(&copy, ",");
-    if (fetch1 == NULL) {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    char* select1 = strsep(&copy, ",");
-    if (select1 == NULL) {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    char* fetch2 = strsep(&copy, ",");
-    if (fetch2 == NULL) {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    char* select2 = strsep(&copy, ",");
-    if (select2 == NULL) {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    char* type = copy;
-    if (type == NULL) {
+    char* fetch1 = strsep(&args, ",");
+    char* select1 = strsep(&args, ",");
+    char* fetch2 = strsep(&args, ",");
+    char* select2 = strsep(&args, ",");
+    char* type = args;
+
+    // join(<fetch>,<select>,<db.tbl.col>,index) looks the fetched values up
+    // in an index on the column
+    char** inner = NULL;
+    if (type == NULL && select2 != NULL && strcmp(select2, "index") == 0) {
+        inner = parse_alloc(sizeof(char*) * 3);
+        if (inner == NULL) {
+            response->status = EXECUTION_ERROR;
+            return NULL;
+        }
+        inner[0] = strsep(&fetch2, ".");
+        inner[1] = strsep(&fetch2, ".");
+        inner[2] = fetch2;
+        if (inner[1] == NULL || inner[2] == NULL) {
+            response->status = INCORRECT_FORMAT;
+            return NULL;
+        }
+        type = select2;
+        fetch2 = select2 = NULL;
+    } else if (select1 == NULL || fetch2 == NULL || select2 == NULL || type == NULL) {
         response->status = INCORRECT_FORMAT;
         return NULL;
     }
 
     // create select operator object
-    DbOperator* dbo = malloc(sizeof(DbOperator));
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
     dbo->type = OP_JOIN;
     dbo->fields.join = (JoinOperator) {
-        .type = strcmp(type, "hash") == 0 ? HASH : NESTED,
+        .type = inner != NULL ? INDEX : strcmp(type, "hash") == 0 ? HASH : strcmp(type, "sort-merge") == 0 ? MERGE : NESTED,
         .fetch1 = fetch1,
         .select1 = select1,
         .fetch2 = fetch2,
         .select2 = select2,
         .handle1 = handle1,
-        .handle2 = handle2
+        .handle2 = handle2,
+        .inner = inner
     };
 
     return dbo;
@@ -1,6 +1,7 @@
 #include <string.h>
 #include <stdio.h>
 
+#include "parse/parse.h"
 #include "parse/math.h"
 #include "util/log.h"
 #include "util/strmanip.h"
@@ -8,43 +9,32 @@
 DbOperator* parse_math(char* arguments, message* response, char* handle, MathType type) {
     if (response == NULL)
         return NULL;
-    if (arguments == NULL || *arguments != '(') {
-        response->status = UNKNOWN_COMMAND;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
         return NULL;
-    }
-    arguments++;
-
-    // create a copy of string
-    size_t space = strlen(arguments) + 1;
-    char* copy = malloc(space * sizeof(char));
-    strcpy(copy, arguments);
-    size_t len = strlen(copy);
-    if (copy[len - 1] != ')') {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    copy[len - 1] = '\0';
     
     // possible to have two arguments to the operator
     char* first;
 
     // parse arguments, look for two if necessary
     if (type > MIN) {
-        first = (char*) strsep(&copy, ",");
-        if (first == NULL) {
+        first = (char*) strsep(&args, ",");
+        if (args == NULL) {
             response->status = INCORRECT_FORMAT;
             return NULL;
         }
     } else {
-        first = copy;
+        first = args;
+        args = NULL;
     }
-    char** params = malloc(sizeof(char*) * 6);
-    bool is_var = false;
-    int num_tokens = 0;
-    if (first == NULL) {
-        response->status = INCORRECT_FORMAT;
+    char** params = parse_alloc(sizeof(char*) * 6);
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (params == NULL || dbo == NULL) {
+        response->status = EXECUTION_ERROR;
         return NULL;
     }
+    bool is_var = false;
+    int num_tokens = 0;
     // parse the first argument
     params[num_tokens] = (char*) strsep(&first, ".");
     if (first == NULL) {
@@ -54,7 +44,6 @@ DbOperator* parse_math(char* arguments, message* response, char* handle, MathTyp
         params[num_tokens + 1] = (char*) strsep(&first, ".");
         if (first == NULL) {
             response->status = INCORRECT_FORMAT;
-            free(params);
             return NULL;
         } else {
             params[num_tokens + 2] = first;
@@ -62,25 +51,23 @@ DbOperator* parse_math(char* arguments, message* response, char* handle, MathTyp
         num_tokens += 3;
     }
     // parse the second argument
-    if (copy != NULL) {
-        params[num_tokens] = (char*) strsep(&copy, ".");
-        if (copy == NULL) {
+    if (args != NULL) {
+        params[num_tokens] = (char*) strsep(&args, ".");
+        if (args == NULL) {
             num_tokens += 1;
         } else {
-            params[num_tokens + 1] = (char*) strsep(&copy, ".");
-            if (copy == NULL) {
+            params[num_tokens + 1] = (char*) strsep(&args, ".");
+            if (args == NULL) {
                 response->status = INCORRECT_FORMAT;
-                free(params);
                 return NULL;
             } else {
-                params[num_tokens + 2] = copy;
+                params[num_tokens + 2] = args;
             }
             num_tokens += 3;
         }
     }
 
     // create select operator object
-    DbOperator* dbo = malloc(sizeof(DbOperator));
     dbo->type = OP_MATH;
     dbo->fields.math = (MathOperator) {
         .type = type,
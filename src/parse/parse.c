@@ -14,13 +14,57 @@
 #include "parse/print.h"
 #include "parse/batch.h"
 #include "parse/math.h"
+#include "parse/aggregate.h"
+#include "parse/groupby.h"
 #include "parse/join.h"
+#include "parse/prepare.h"
+#include "parse/stats.h"
+#include "parse/explain.h"
+#include "parse/analyze.h"
+#include "parse/combine.h"
+
+// statements are parsed into a fixed buffer, reset before each one
+static long double statement_memory[PARSE_ARENA_SIZE / sizeof(long double)];
+static ParseArena statement_arena = {
+    .base = (char*) statement_memory,
+    .size = sizeof(statement_memory),
+    .used = 0
+};
+static ParseArena* current_arena = &statement_arena;
+
+void* parse_alloc(size_t bytes) {
+    return arenaAlloc(current_arena, bytes);
+}
+
+ParseArena* parse_use_arena(ParseArena* arena) {
+    ParseArena* previous = current_arena;
+    current_arena = arena;
+    return previous;
+}
+
+char* unwrap_arguments(char* arguments, message* response) {
+    if (arguments == NULL || *arguments != '(') {
+        response->status = UNKNOWN_COMMAND;
+        return NULL;
+    }
+    arguments++;
+    size_t len = strlen(arguments);
+    if (len == 0 || arguments[len - 1] != ')') {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+    arguments[len - 1] = '\0';
+    return arguments;
+}
+
+// true if query starts with the keyword, whose length is known statically
+#define HAS_KEYWORD(query, keyword) (strncmp(query, keyword, sizeof(keyword) - 1) == 0)
 
 /**
  * parse_command takes as input the send_message from the client and then
  * parses it into the appropriate query. Stores into send_message the
  * status to send back.
- * Returns a db_operator.
+ * Returns a db_operator, which lives until the next command is parsed.
  **/
 DbOperator* parse_command(
     char* query_command, 
@@ -36,7 +80,13 @@ DbOperator* parse_command(
     send_message->status = OK_WAIT_FOR_RESPONSE;
     query_command = trim_whitespace(query_command);
 
-    DbOperator* dbo = process_query(query_command, send_message);
+    // the previous statement has been executed, so its memory is free.
+    // Statements sent between batch_queries() and batch_execute() are only
+    // parsed now; batch_execute() runs them.
+    resetArena(&statement_arena);
+    bool queue = context != NULL && context->queries != NULL &&
+        !HAS_KEYWORD(query_command, "batch_queries") && !HAS_KEYWORD(query_command, "batch_execute");
+    DbOperator* dbo = queue ? parse_batched(query_command, send_message) : process_query(query_command, send_message);
     if (dbo != NULL) {
         dbo->client_fd = client_socket;
         dbo->context = context;
@@ -45,6 +95,10 @@ DbOperator* parse_command(
 }
 
 DbOperator* process_query(char* query, message* send_message) {
+    // explain wraps a whole statement, handle included
+    if (HAS_KEYWORD(query, "explain("))
+        return parse_explain(query + 7, send_message);
+
     // check for variable name
     char *equals_pointer = strchr(query, '=');
     char *handle = query;
@@ -57,60 +111,75 @@ DbOperator* process_query(char* query, message* send_message) {
         log_info("No handle found in query\n");
     }
 
-    if (strncmp(query, "create", 6) == 0) {
-        query += 6;
-        return parse_create(query, send_message);
-    }
-    if (strncmp(query, "relational_insert", 17) == 0) {
-        query += 17;
-        return parse_insert(query, send_message);
-    }
-    if (strncmp(query, "select", 6) == 0) {
-        query += 6;
-        return parse_select(query, send_message, handle);
-    }
-    if (strncmp(query, "fetch", 5) == 0) {
-        query += 5;
-        return parse_fetch(query, send_message, handle);
-    }
-    if (strncmp(query, "print", 5) == 0) {
-        query += 5;
-        return parse_print(query, send_message);
-    }
-    if (strncmp(query, "avg", 3) == 0 ||
-        strncmp(query, "sum", 3) == 0 ||
-        strncmp(query, "max", 3) == 0 ||
-        strncmp(query, "min", 3) == 0 ||
-        strncmp(query, "add", 3) == 0 ||
-        strncmp(query, "sub", 3) == 0) {
-        MathType type;
-        if (strncmp(query, "avg", 3) == 0)
-            type = AVG;
-        else if (strncmp(query, "sum", 3) == 0)
-            type = SUM;
-        else if (strncmp(query, "max", 3) == 0)
-            type = MAX;
-        else if (strncmp(query, "min", 3) == 0)
-            type = MIN;
-        else if (strncmp(query, "add", 3) == 0)
-            type = ADD;
-        else if (strncmp(query, "sub", 3) == 0)
-            type = SUB;
-        else {
-            log_err("-- Invalid MATH operator type encountered.");
-            return NULL;
-        }
-        query += 3;
-        return parse_math(query, send_message, handle, type);
-    }
-    if (strncmp(query, "batch_queries", 13) == 0 ||
-        strncmp(query, "batch_execute", 13) == 0) {
-        query += 6;
-        return parse_batch(query, send_message);
-    }
-    if (strncmp(query, "join", 4) == 0) {
-        query += 4;
-        return parse_join(query, send_message, handle);
+    // dispatch on the first letter, then compare only the keywords that
+    // start with it
+    switch (query[0]) {
+        case 'a':
+            if (HAS_KEYWORD(query, "aggregate"))
+                return parse_aggregate(query + 9, send_message, handle);
+            if (HAS_KEYWORD(query, "avg"))
+                return parse_math(query + 3, send_message, handle, AVG);
+            if (HAS_KEYWORD(query, "add"))
+                return parse_math(query + 3, send_message, handle, ADD);
+            if (HAS_KEYWORD(query, "analyze"))
+                return parse_analyze(query + 7, send_message);
+            if (HAS_KEYWORD(query, "and"))
+                return parse_combine(query + 3, send_message, handle, true);
+            break;
+        case 'b':
+            if (HAS_KEYWORD(query, "batch_queries") || HAS_KEYWORD(query, "batch_execute"))
+                return parse_batch(query + 6, send_message);
+            break;
+        case 'c':
+            if (HAS_KEYWORD(query, "create"))
+                return parse_create(query + 6, send_message);
+            break;
+        case 'e':
+            if (HAS_KEYWORD(query, "execute"))
+                return parse_execute(query + 7, send_message);
+            break;
+        case 'f':
+            if (HAS_KEYWORD(query, "fetch"))
+                return parse_fetch(query + 5, send_message, handle);
+            break;
+        case 'g':
+            if (HAS_KEYWORD(query, "group_by"))
+                return parse_group_by(query + 8, send_message, handle);
+            break;
+        case 'j':
+            if (HAS_KEYWORD(query, "join"))
+                return parse_join(query + 4, send_message, handle);
+            break;
+        case 'm':
+            if (HAS_KEYWORD(query, "max"))
+                return parse_math(query + 3, send_message, handle, MAX);
+            if (HAS_KEYWORD(query, "min"))
+                return parse_math(query + 3, send_message, handle, MIN);
+            break;
+        case 'o':
+            if (HAS_KEYWORD(query, "or"))
+                return parse_combine(query + 2, send_message, handle, false);
+            break;
+        case 'p':
+            if (HAS_KEYWORD(query, "print"))
+                return parse_print(query + 5, send_message);
+            if (HAS_KEYWORD(query, "prepare"))
+                return parse_prepare(query + 7, send_message, handle);
+            break;
+        case 'r':
+            if (HAS_KEYWORD(query, "relational_insert"))
+                return parse_insert(query + 17, send_message);
+            break;
+        case 's':
+            if (HAS_KEYWORD(query, "select"))
+                return parse_select(query + 6, send_message, handle);
+            if (HAS_KEYWORD(query, "sum"))
+                return parse_math(query + 3, send_message, handle, SUM);
+            if (HAS_KEYWORD(query, "sub"))
+                return parse_math(query + 3, send_message, handle, SUB);
+            if (HAS_KEYWORD(query, "stats"))
+                return parse_stats(query + 5, send_message);
+            break;
     }
     return NULL;
 }
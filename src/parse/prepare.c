@@ -0,0 +1,86 @@
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "parse/parse.h"
+#include "parse/prepare.h"
+
+// name=prepare(<statement>): the statement is parsed now and kept, along
+// with a copy of its text, for execute() to run with new arguments. Both
+// live in a block of their own rather than in the statement arena.
+DbOperator* parse_prepare(char* arguments, message* response, char* handle) {
+    if (response == NULL)
+        return NULL;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
+        return NULL;
+    if (handle == NULL) {
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+
+    size_t len = strlen(args) + 1;
+    char* memory = malloc(len + PREPARED_STATEMENT_SIZE);
+    if (memory == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    ParseArena arena;
+    initArena(&arena, memory, len + PREPARED_STATEMENT_SIZE);
+    char* text = arenaAlloc(&arena, len);
+    memcpy(text, args, len);
+
+    ParseArena* statement_arena = parse_use_arena(&arena);
+    DbOperator* statement = process_query(text, response);
+    parse_use_arena(statement_arena);
+    if (statement == NULL) {
+        free(memory);
+        response->status = INCORRECT_FORMAT;
+        return NULL;
+    }
+
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (dbo == NULL) {
+        free(memory);
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    dbo->type = OP_PREPARE;
+    dbo->fields.prepare = (PrepareOperator) {
+        .name = handle,
+        .statement = statement,
+        .memory = memory
+    };
+    return dbo;
+}
+
+// execute(name,arg1,...): binds the arguments to the placeholders of a
+// prepared statement, in order
+DbOperator* parse_execute(char* arguments, message* response) {
+    if (response == NULL)
+        return NULL;
+    char* copy = unwrap_arguments(arguments, response);
+    if (copy == NULL)
+        return NULL;
+
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    dbo->type = OP_EXECUTE;
+    dbo->fields.execute.name = strsep(&copy, ",");
+    dbo->fields.execute.num_args = 0;
+    char* token;
+    while ((token = strsep(&copy, ",")) != NULL) {
+        char* end;
+        errno = 0;
+        long value = strtol(token, &end, 10);
+        if (dbo->fields.execute.num_args == MAX_STATEMENT_PARAMS || end == token || *end != '\0' || errno != 0) {
+            response->status = INCORRECT_FORMAT;
+            return NULL;
+        }
+        dbo->fields.execute.args[dbo->fields.execute.num_args++] = value;
+    }
+    return dbo;
+}
@@ -2,72 +2,99 @@
 #include <stdio.h>
 #include <limits.h>
 
+#include "parse/parse.h"
 #include "parse/select.h"
 
+// parses a select bound: null for no bound, ? for a prepared statement
+// placeholder, or a number
+static long parse_bound(char* arg, long unbounded, bool* placeholder) {
+    *placeholder = strcmp("?", arg) == 0;
+    if (*placeholder || strcmp("null", arg) == 0)
+        return unbounded;
+    return atol(arg);
+}
+
+// parses the predicates after the first one of
+// select(db.tbl.col,min,max,db.tbl.col,min,max,...), which have to be on
+// the same table
+static bool parse_conjuncts(char* args, SelectOperator* select, message* response) {
+    size_t num_args = 1;
+    for (char* c = args; *c != '\0'; c++)
+        num_args += (*c == ',');
+    if (num_args % 3 != 0 || select->params[2] == NULL) {
+        response->status = INCORRECT_FORMAT;
+        return false;
+    }
+    select->num_conjuncts = num_args / 3;
+    select->conjuncts = parse_alloc(sizeof(SelectPredicate) * select->num_conjuncts);
+    if (select->conjuncts == NULL) {
+        response->status = EXECUTION_ERROR;
+        return false;
+    }
+    for (size_t i = 0; i < select->num_conjuncts; i++) {
+        SelectPredicate* conjunct = &select->conjuncts[i];
+        char* col_name = strsep(&args, ",");
+        char* db_name = strsep(&col_name, ".");
+        char* tbl_name = strsep(&col_name, ".");
+        if (col_name == NULL || strcmp(db_name, select->params[0]) != 0 || strcmp(tbl_name, select->params[1]) != 0) {
+            response->status = INCORRECT_FORMAT;
+            return false;
+        }
+        *conjunct = (SelectPredicate) { .col_name = col_name, .column = NULL };
+        conjunct->minimum = parse_bound(strsep(&args, ","), LONG_MIN, &conjunct->bind_minimum);
+        conjunct->maximum = parse_bound(strsep(&args, ","), LONG_MAX, &conjunct->bind_maximum);
+    }
+    return true;
+}
+
 DbOperator* parse_select(char* arguments, message* response, char* handle) {
     if (response == NULL)
         return NULL;
-    if (arguments == NULL || *arguments != '(') {
-        response->status = UNKNOWN_COMMAND;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
         return NULL;
-    }
-    arguments++;
-
-    // create a copy of string
-    size_t space = strlen(arguments) + 1;
-    char* copy = malloc(space * sizeof(char));
-    strcpy(copy, arguments);
-    size_t len = strlen(copy);
-    if (copy[len - 1] != ')') {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    copy[len - 1] = '\0';
     
     // parse arguments
-    char* arg1 = (char*) strsep(&copy, ",");
-    if (arg1 == NULL) {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    char* arg2 = (char*) strsep(&copy, ",");
-    if (arg2 == NULL) {
+    char* arg1 = (char*) strsep(&args, ",");
+    char* arg2 = (char*) strsep(&args, ",");
+    char* arg3 = (char*) strsep(&args, ",");
+    if (arg2 == NULL || arg3 == NULL) {
         response->status = INCORRECT_FORMAT;
         return NULL;
     }
-    char* arg3 = (char*) strsep(&copy, ",");
-    if (arg3 == NULL) {
-        response->status = INCORRECT_FORMAT;
-        return NULL;
-    }
-    char* arg4 = copy;
+    char* arg4 = args;
 
     // create select operator object
-    DbOperator* dbo = malloc(sizeof(DbOperator));
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    char** params = parse_alloc(sizeof(char*) * 3);
+    if (dbo == NULL || params == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
     dbo->type = OP_SELECT;
-    if (arg4 == NULL) {
-        char** params = malloc(sizeof(char*) * 3);
+    if (arg4 == NULL || strchr(arg4, ',') != NULL) {
         params[0] = (char*) strsep(&arg1, ".");
         params[1] = (char*) strsep(&arg1, ".");
         params[2] = arg1;
         dbo->fields.select = (SelectOperator) {
             .handle = handle,
             .params = params,
-            .minimum = (strcmp("null", arg2) == 0) ? INT_MIN : atoi(arg2),
-            .maximum = (strcmp("null", arg3) == 0) ? INT_MAX : atoi(arg3),
             .src_is_var = false
         };
+        dbo->fields.select.minimum = parse_bound(arg2, LONG_MIN, &dbo->fields.select.bind_minimum);
+        dbo->fields.select.maximum = parse_bound(arg3, LONG_MAX, &dbo->fields.select.bind_maximum);
+        if (arg4 != NULL && !parse_conjuncts(arg4, &dbo->fields.select, response))
+            return NULL;
     } else {
-        char** params = malloc(sizeof(char*) * 2);
         params[0] = arg1;
         params[1] = arg2;
         dbo->fields.select = (SelectOperator) {
             .handle = handle,
             .params = params,
-            .minimum = (strcmp("null", arg3) == 0) ? INT_MIN : atoi(arg3),
-            .maximum = (strcmp("null", arg4) == 0) ? INT_MAX : atoi(arg4),
             .src_is_var = true
         };
+        dbo->fields.select.minimum = parse_bound(arg3, LONG_MIN, &dbo->fields.select.bind_minimum);
+        dbo->fields.select.maximum = parse_bound(arg4, LONG_MAX, &dbo->fields.select.bind_maximum);
     }
     return dbo;
 }
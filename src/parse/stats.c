@@ -0,0 +1,24 @@
+#include <string.h>
+
+#include "parse/parse.h"
+#include "parse/stats.h"
+#include "util/strmanip.h"
+
+// stats() sends the operator metrics back; stats("path") writes them to
+// a file on the server instead
+DbOperator* parse_stats(char* arguments, message* response) {
+    if (response == NULL)
+        return NULL;
+    char* args = unwrap_arguments(arguments, response);
+    if (args == NULL)
+        return NULL;
+
+    DbOperator* dbo = parse_alloc(sizeof(DbOperator));
+    if (dbo == NULL) {
+        response->status = EXECUTION_ERROR;
+        return NULL;
+    }
+    dbo->type = OP_STATS;
+    dbo->fields.stats.path = (*args == '\0') ? NULL : trim_quotes(args);
+    return dbo;
+}
@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "query/bitmap.h"
+
+size_t bitmapWords(size_t num_rows) {
+    return (num_rows + 63) / 64;
+}
+
+bool preferBitmap(size_t num_tuples, size_t num_rows) {
+    return num_tuples > 0 && num_tuples * BITMAP_DENSITY >= num_rows;
+}
+
+// lists the rows set in the bitmap, lowest first
+static int* bitmapPositions(const uint64_t* words, size_t num_rows, size_t num_tuples) {
+    int* positions = malloc(sizeof(int) * (num_tuples + 1));
+    if (positions == NULL)
+        return NULL;
+    size_t count = 0;
+    for (size_t word = 0; word < bitmapWords(num_rows); word++) {
+        uint64_t bits = words[word];
+        while (bits != 0) {
+            positions[count++] = (int) (word * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+    return positions;
+}
+
+void storeBitmap(Result* result, uint64_t* words, size_t num_rows, size_t num_tuples) {
+    result->data_type = INT;
+    result->num_tuples = num_tuples;
+    int* positions;
+    if (!preferBitmap(num_tuples, num_rows) && (positions = bitmapPositions(words, num_rows, num_tuples)) != NULL) {
+        free(words);
+        result->payload = positions;
+        result->is_bitmap = false;
+        return;
+    }
+    result->payload = words;
+    result->is_bitmap = true;
+    result->bitmap_rows = num_rows;
+}
+
+void storePositions(Result* result, int* positions, size_t num_tuples, size_t num_rows) {
+    result->data_type = INT;
+    result->num_tuples = num_tuples;
+    uint64_t* words;
+    if (preferBitmap(num_tuples, num_rows) && (words = calloc(bitmapWords(num_rows), sizeof(uint64_t))) != NULL) {
+        for (size_t i = 0; i < num_tuples; i++)
+            words[positions[i] / 64] |= (uint64_t) 1 << (positions[i] % 64);
+        free(positions);
+        result->payload = words;
+        result->is_bitmap = true;
+        result->bitmap_rows = num_rows;
+        return;
+    }
+    result->payload = positions;
+    result->is_bitmap = false;
+}
+
+void* resultPayload(Result* result, void** copy) {
+    *copy = NULL;
+    if (!result->is_bitmap)
+        return result->payload;
+    *copy = bitmapPositions(result->payload, result->bitmap_rows, result->num_tuples);
+    return *copy;
+}
+
+// the number of rows a selection spans
+static size_t selectionRows(const Result* result) {
+    if (result->is_bitmap)
+        return result->bitmap_rows;
+    const int* positions = result->payload;
+    size_t rows = 0;
+    for (size_t i = 0; i < result->num_tuples; i++)
+        rows = (size_t) positions[i] + 1 > rows ? (size_t) positions[i] + 1 : rows;
+    return rows;
+}
+
+// a new bitmap over num_rows rows holding the selection
+static uint64_t* selectionBitmap(const Result* result, size_t num_rows) {
+    uint64_t* words = calloc(bitmapWords(num_rows) + 1, sizeof(uint64_t));
+    if (words == NULL)
+        return NULL;
+    if (result->is_bitmap) {
+        memcpy(words, result->payload, sizeof(uint64_t) * bitmapWords(result->bitmap_rows));
+        return words;
+    }
+    const int* positions = result->payload;
+    for (size_t i = 0; i < result->num_tuples; i++)
+        words[positions[i] / 64] |= (uint64_t) 1 << (positions[i] % 64);
+    return words;
+}
+
+Result* combineSelections(Result* left, Result* right, bool conjunctive) {
+    size_t left_rows = selectionRows(left);
+    size_t right_rows = selectionRows(right);
+    size_t num_rows = left_rows > right_rows ? left_rows : right_rows;
+    Result* result = calloc(1, sizeof(Result));
+    uint64_t* words = selectionBitmap(left, num_rows);
+    uint64_t* other = selectionBitmap(right, num_rows);
+    if (result == NULL || words == NULL || other == NULL) {
+        free(result);
+        free(words);
+        free(other);
+        return NULL;
+    }
+
+    size_t num_tuples = 0;
+    size_t num_words = bitmapWords(num_rows);
+    if (conjunctive) {
+        for (size_t i = 0; i < num_words; i++) {
+            words[i] &= other[i];
+            num_tuples += __builtin_popcountll(words[i]);
+        }
+    } else {
+        for (size_t i = 0; i < num_words; i++) {
+            words[i] |= other[i];
+            num_tuples += __builtin_popcountll(words[i]);
+        }
+    }
+    free(other);
+    storeBitmap(result, words, num_rows, num_tuples);
+    return result;
+}
@@ -1,21 +1,43 @@
-#include <sys/time.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 
 #include "api/db_io.h"
+#include "api/column.h"
+#include "api/composite.h"
 #include "api/context.h"
+#include "api/cracker.h"
 #include "api/sorted.h"
-#include "api/hashtable.h"
+#include "api/persist.h"
+#include "api/statistics.h"
+#include "api/wal.h"
+#include "query/bitmap.h"
 #include "query/execute.h"
+#include "query/hashjoin.h"
+#include "query/indexjoin.h"
+#include "query/kernels.h"
+#include "query/mergejoin.h"
+#include "query/grouping.h"
+#include "query/plan.h"
 #include "util/debug.h"
 #include "util/cleanup.h"
+#include "util/metrics.h"
 
 Db* current_db = NULL;
+size_t catalog_generation = 0;
 
 Table* findTable(char* tbl_name) {
     if (current_db == NULL || tbl_name == NULL)
         return NULL;
-    for (size_t i = 0; i < current_db->num_tables; i++)
-        if (strcmp(current_db->tables[i]->name, tbl_name) == 0)
+    for (size_t i = 0; i < current_db->num_tables; i++) {
+        if (strcmp(current_db->tables[i]->name, tbl_name) == 0) {
+            // the table might still be waiting to be read from disk, and
+            // one that couldn't be read can't be used
+            if (!ensureTableLoaded(current_db->tables[i]))
+                return NULL;
             return current_db->tables[i];
+        }
+    }
     return NULL;
 }
 
@@ -29,6 +51,113 @@ Column* findColumn(Table* table, char* col_name) {
     return NULL;
 }
 
+// narrows a select bound to the int keys used by the indexes
+int clampInt(long value) {
+    if (value < INT_MIN)
+        return INT_MIN;
+    if (value > INT_MAX)
+        return INT_MAX;
+    return (int) value;
+}
+
+// gives back the unused tail of a position array sized for the worst case
+int* shrinkPositions(int* positions, size_t num_tuples) {
+    if (num_tuples == 0)
+        return positions;
+    int* shrunk = realloc(positions, sizeof(int) * num_tuples);
+    return (shrunk != NULL) ? shrunk : positions;
+}
+
+// stores a single aggregate into a one-tuple result. AVG is kept as a double,
+// the rest as longs; MIN and MAX of nothing produce an empty result.
+void storeAggregate(Result* result, MathType type, Aggregates* aggregates) {
+    result->num_tuples = 1;
+    if (type == AVG) {
+        double* toSave = malloc(sizeof(double));
+        toSave[0] = (double) aggregates->sum / aggregates->count;
+        result->data_type = DOUBLE;
+        result->payload = (void*) toSave;
+        return;
+    }
+    long* toSave = malloc(sizeof(long));
+    if (type == SUM)
+        toSave[0] = aggregates->sum;
+    else
+        toSave[0] = (type == MIN) ? aggregates->min : aggregates->max;
+    if (type != SUM && aggregates->count == 0)
+        result->num_tuples = 0;
+    result->data_type = LONG;
+    result->payload = (void*) toSave;
+}
+
+// stores a result under the given handle, replacing any earlier result
+// with the same name
+bool addResultHandle(ClientContext* context, char* name, Result* result) {
+    GeneralizedColumnHandle new_handle;
+    new_handle.generalized_column.column_type = RESULT;
+    new_handle.generalized_column.column_pointer.result = result;
+    strcpy(new_handle.name, name);
+
+    if (checkContextSize(context) != true)
+        return false;
+    int dupIndex = findDuplicateHandle(context, name);
+    if (dupIndex < 0) {
+        context->chandle_table[context->chandles_in_use++] = new_handle;
+    } else {
+        context->chandle_table[dupIndex] = new_handle;
+    }
+    return true;
+}
+
+// returns the first num_rows values of a base column as one array. Paged
+// columns are copied into *copy, which the caller frees; otherwise *copy is
+// NULL and the column's own storage is returned.
+void* columnPayload(Column* column, size_t num_rows, void** copy) {
+    *copy = NULL;
+    if (!column->paged)
+        return column->data;
+    *copy = malloc(typeWidth(column->type) * (num_rows + 1));
+    if (*copy != NULL)
+        readRows(column, 0, num_rows, *copy);
+    return *copy;
+}
+
+// looks up the table and column a select reads, unless prepare already did
+// in the current catalog generation. Returns an error message, or NULL once
+// both are found.
+char* resolveSelectColumn(SelectOperator* select, message* send_message) {
+    if (select->column != NULL && select->generation == catalog_generation)
+        return NULL;
+    select->column = NULL;
+
+    // check database
+    if (current_db == NULL || strcmp(select->params[0], current_db->name) != 0) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Database not found.";
+    }
+
+    // if we didn't manage to find a table
+    select->table = findTable(select->params[1]);
+    if (select->table == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified table.";
+    }
+
+    // if we didn't manage to find a column
+    select->column = findColumn(select->table, select->params[2]);
+    for (size_t i = 0; select->column != NULL && i < select->num_conjuncts; i++) {
+        SelectPredicate* conjunct = &select->conjuncts[i];
+        if ((conjunct->column = findColumn(select->table, conjunct->col_name)) == NULL)
+            select->column = NULL;
+    }
+    if (select->column == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified column.";
+    }
+    select->generation = catalog_generation;
+    return NULL;
+}
+
 /** execute_DbOperator takes as input the DbOperator and executes the query. **/
 char* executeDbOperator(DbOperator* query, message* send_message) {
     if (query == NULL) {
@@ -36,7 +165,9 @@ char* executeDbOperator(DbOperator* query, message* send_message) {
         return "Invalid query.";
     }
 
+#ifdef LOG_INFO
     printDbOperator(query);
+#endif
 
     char* res = NULL;
     switch(query->type) {
@@ -61,14 +192,38 @@ char* executeDbOperator(DbOperator* query, message* send_message) {
     case OP_MATH:
         res = handleMathQuery(query, send_message);
         break;
+    case OP_AGGREGATE:
+        res = handleAggregateQuery(query, send_message);
+        break;
+    case OP_GROUP_BY:
+        res = handleGroupByQuery(query, send_message);
+        break;
     case OP_JOIN:
         res = handleJoinQuery(query, send_message);
         break;
+    case OP_PREPARE:
+        res = handlePrepareQuery(query, send_message);
+        break;
+    case OP_EXECUTE:
+        res = handleExecuteQuery(query, send_message);
+        break;
+    case OP_STATS:
+        res = handleStatsQuery(query, send_message);
+        break;
+    case OP_EXPLAIN:
+        res = handleExplainQuery(query, send_message);
+        break;
+    case OP_ANALYZE:
+        res = handleAnalyzeQuery(query, send_message);
+        break;
+    case OP_COMBINE:
+        res = handleCombineQuery(query, send_message);
+        break;
     }
 
     // printDatabase(current_db);
     
-    free(query);
+    // the operator lives in the parser's arena, see parse_command()
     if (res != NULL)
         return res;
     return "";
@@ -106,8 +261,11 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
                 return "-- Error creating db.";   
             }
 
-            // destroy current db and replace with new db object
+            // destroy current db and replace with new db object, once no
+            // loader thread is still filling one of its tables
+            waitForLoads();
             freeDb(current_db);
+            catalog_generation++;
             current_db = malloc(sizeof(Db));
             strcpy(current_db->name, db_name);
             current_db->tables = NULL;
@@ -134,11 +292,13 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
                 return "-- At least one column required.";
             }
 
-            // check to make sure table doesn't already existence
-            Table* existing_table = findTable(tbl_name);
-            if (existing_table != NULL) {
-                send_message->status = EXECUTION_ERROR;
-                return "-- Table already exists.";
+            // check to make sure table doesn't already exist, even as one
+            // that failed to load
+            for (size_t i = 0; current_db != NULL && i < current_db->num_tables; i++) {
+                if (strcmp(current_db->tables[i]->name, tbl_name) == 0) {
+                    send_message->status = EXECUTION_ERROR;
+                    return "-- Table already exists.";
+                }
             }
 
             // create the table directory
@@ -167,6 +327,9 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
             new_table->num_rows = 0;
             new_table->capacity = 0;
             new_table->num_indexes = 0;
+            new_table->dirty = true;
+            new_table->persisted_rows = 0;
+            new_table->load_state = LOADED;
             current_db->tables[current_db->num_tables++] = new_table;
 
             // finished successfully
@@ -175,7 +338,7 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
         }
         case CREATE_COL: {
             // check for params
-            if (fields.create.num_params != 3) {
+            if (fields.create.num_params != 3 && fields.create.num_params != 4) {
                 send_message->status = INCORRECT_FORMAT;
                 return "-- Incorrect number of arguments when creating column.";
             }
@@ -184,6 +347,11 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
             db_name = fields.create.params[0];
             tbl_name = fields.create.params[1];
             col_name = fields.create.params[2];
+            DataType col_type = INT;
+            if (fields.create.num_params == 4 && !parseDataType(fields.create.params[3], &col_type)) {
+                send_message->status = INCORRECT_FORMAT;
+                return "-- Unknown column storage type.";
+            }
             if (strcmp(current_db->name, db_name) != 0) {
                 send_message->status = QUERY_UNSUPPORTED;
                 return "-- Cannot create index in inactive db.";
@@ -223,9 +391,18 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
             }
             Column* new_col = malloc(sizeof(Column));
             strcpy(new_col->name, col_name);
-            new_col->data = NULL;
+            new_col->type = col_type;
+            new_col->data = (table->capacity > 0) ? calloc(table->capacity, typeWidth(col_type)) : NULL;
+            new_col->dirty = true;
+            new_col->dirty_from = 0;
+            new_col->paged = false;
+            new_col->paged_rows = 0;
+            new_col->page_fd = -1;
+            new_col->stats = NULL;
+            new_col->cracker = NULL;
             table->columns[table->col_count] = new_col;
             table->col_count++;
+            table->dirty = true;
 
             // finished successfully
             send_message->status = OK_DONE;
@@ -233,15 +410,17 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
         }
         case CREATE_IDX: {
             // check for params
-            if (fields.create.num_params != 5) {
+            if (fields.create.num_params < 5) {
                 send_message->status = INCORRECT_FORMAT;
                 return "-- Incorrect number of arguments when creating index.";
             }
             
-            // extract params and validate
+            // extract params and validate; further key columns follow the
+            // first after a '+'
             db_name = fields.create.params[0];
             tbl_name = fields.create.params[1];
-            col_name = fields.create.params[2];
+            char* key_names = fields.create.params[2];
+            col_name = strsep(&key_names, "+");
             
             if (strcmp(current_db->name, db_name) != 0) {
                 send_message->status = QUERY_UNSUPPORTED;
@@ -262,51 +441,120 @@ char* handleCreateQuery(DbOperator* query, message* send_message) {
                 return "-- Unable to find specified column.";
             }
 
-            // resize table indexes array if necessary
-            if (table->num_indexes == 0)
-                table->indexes = malloc(sizeof(Index*) * 2);
-            if (table->num_indexes > 2 && table->num_indexes % 2 == 0) {
-                Index** new_list = realloc(table->indexes, sizeof(Index*) * (2 + table->num_indexes));
-                if (new_list != NULL) {
-                    table->indexes = new_list;
-                } else {
-                    send_message->status = EXECUTION_ERROR;
-                    return "-- Unable to insert a new index; no space in table.";
-                }
+            // indexes store int keys
+            if (typeWidth(column->type) > sizeof(int)) {
+                send_message->status = QUERY_UNSUPPORTED;
+                return "-- Indexes are only supported on columns of at most 4 bytes.";
+            }
+
+            // composite and covering indexes copy their other columns into
+            // a sorted array
+            IndexType index_type = strcmp("btree", fields.create.params[3]) == 0 ? BTREE : SORTED;
+            bool clustered = strcmp("clustered", fields.create.params[4]) == 0;
+            size_t num_keys = 0;
+            for (char* c = key_names; c != NULL && *c != '\0'; c++)
+                num_keys += (*c == '+');
+            num_keys += (key_names != NULL);
+            size_t num_included = fields.create.num_params - 5;
+            if ((num_keys > 0 || num_included > 0) && (index_type != SORTED || clustered)) {
+                send_message->status = QUERY_UNSUPPORTED;
+                return "-- Composite and covering indexes must be sorted and unclustered.";
+            }
+            Column** keys = (num_keys > 0) ? malloc(sizeof(Column*) * num_keys) : NULL;
+            Column** included = (num_included > 0) ? malloc(sizeof(Column*) * num_included) : NULL;
+            bool found = true;
+            for (size_t i = 0; i < num_keys; i++)
+                found &= (keys[i] = findColumn(table, strsep(&key_names, "+"))) != NULL;
+            for (size_t i = 0; i < num_included; i++)
+                found &= (included[i] = findColumn(table, fields.create.params[5 + i])) != NULL;
+            if (!found) {
+                free(keys);
+                free(included);
+                send_message->status = INCORRECT_FORMAT;
+                return "-- Unable to find specified column.";
+            }
+
+            // create an index object; from here on it owns keys and
+            // included, and is freed with them if it can't be added
+            Index* new_index = calloc(1, sizeof(Index));
+            if (new_index == NULL) {
+                free(keys);
+                free(included);
+                send_message->status = EXECUTION_ERROR;
+                return "-- Unable to allocate the index.";
             }
-            
-            // create an index object and insert into table now
-            Index* new_index = malloc(sizeof(Index));
             new_index->column = column;
-            new_index->type = strcmp("btree", fields.create.params[3]) == 0 ? BTREE : SORTED;
-            new_index->clustered = (strcmp("clustered", fields.create.params[4]) == 0);
+            new_index->type = index_type;
+            new_index->clustered = clustered;
+            new_index->keys = keys;
+            new_index->num_keys = num_keys;
+            new_index->included = included;
+            new_index->num_included = num_included;
+            // a paged column may fail to be read part way through
+            bool readable = true;
+            long value;
             switch (new_index->type) {
                 case BTREE:
-                    new_index->object = malloc(sizeof(IndexObject));
+                    new_index->object = calloc(1, sizeof(IndexObject));
                     if (new_index->clustered) {
                         new_index->object->btreec = createBTreeC();
-                        for (size_t i = 0; i < table->num_rows; i++) {
-                            insertValueC(&(new_index->object->btreec), column->data[i]);
+                        for (size_t i = 0; i < table->num_rows && (readable = readValue(column, i, &value)); i++) {
+                            insertValueC(&(new_index->object->btreec), value);
                         }
                     } else {
                         new_index->object->btreeu = createBTreeU();
-                        for (size_t i = 0; i < table->num_rows; i++)
-                            insertValueU(&(new_index->object->btreeu), column->data[i], i);
+                        for (size_t i = 0; i < table->num_rows && (readable = readValue(column, i, &value)); i++)
+                            insertValueU(&(new_index->object->btreeu), value, i);
                     }
                     break;
                 case SORTED:
                     new_index->column = column;
-                    if (!new_index->clustered) {
-                        new_index->object = malloc(sizeof(IndexObject));
+                    if (num_keys > 0 || num_included > 0) {
+                        new_index->object = calloc(1, sizeof(IndexObject));
+                        new_index->object->column = calloc(1, sizeof(ColumnIndex));
+                        if (!buildColumnIndex(new_index, table->num_rows, table->capacity)) {
+                            freeIndex(new_index);
+                            send_message->status = EXECUTION_ERROR;
+                            return "-- Unable to build index.";
+                        }
+                    } else if (!new_index->clustered) {
+                        new_index->object = calloc(1, sizeof(IndexObject));
                         initializeColumnIndex(&(new_index->object->column), table->capacity * sizeof(int));
-                        for (size_t i = 0; i < table->num_rows; i++)
-                            insertIndex(new_index->object->column, column->data[i], i, i);
+                        for (size_t i = 0; i < table->num_rows && (readable = readValue(column, i, &value)); i++)
+                            insertIndex(new_index->object->column, value, i, i);
                     } else {
                         new_index->object = NULL;
                     }
                     break;
             }
+            if (!readable) {
+                freeIndex(new_index);
+                send_message->status = EXECUTION_ERROR;
+                return "-- Unable to read the column.";
+            }
+
+            // the indexes array holds a power of two entries, as startupDb
+            // leaves it, so it's full whenever its count is one
+            if ((table->num_indexes & (table->num_indexes - 1)) == 0) {
+                size_t new_size = (table->num_indexes == 0) ? 1 : 2 * table->num_indexes;
+                Index** new_list = realloc(table->indexes, sizeof(Index*) * new_size);
+                if (new_list == NULL) {
+                    freeIndex(new_index);
+                    send_message->status = EXECUTION_ERROR;
+                    return "-- Unable to insert a new index; no space in table.";
+                }
+                table->indexes = new_list;
+            }
+            new_index->dirty = true;
             table->indexes[table->num_indexes++] = new_index;
+            table->dirty = true;
+
+            // the index build just read every value, so refresh the
+            // column's statistics while they're warm
+            analyzeColumn(column, table->num_rows);
+            // selects read the index from now on
+            freeCracker(column->cracker);
+            column->cracker = NULL;
             
             // finished successfully
             send_message->status = OK_DONE;
@@ -326,7 +574,7 @@ char* handleInsertQuery(DbOperator* query, message* send_message) {
 
     // retrieve params
     char* tbl_name = query->fields.insert.tbl_name;
-    int* values = query->fields.insert.values;
+    long* values = query->fields.insert.values;
 
     // if we didn't manage to find a table
     Table* table = findTable(tbl_name);
@@ -341,37 +589,40 @@ char* handleInsertQuery(DbOperator* query, message* send_message) {
         return "-- Mismatched number of values inserted.";
     }
 
+    // values that don't fit a column's type would be silently truncated
+    for (size_t i = 0; i < table->col_count; i++) {
+        if (!fitsType(table->columns[i]->type, values[i])) {
+            send_message->status = INCORRECT_FORMAT;
+            return "-- Value out of range for the column's type.";
+        }
+    }
+
+    // check for a clustered index
+    Index* cluster_index = NULL;
+    for (size_t i = 0; i < table->num_indexes; i++)
+        cluster_index = (table->indexes[i]->clustered) ? table->indexes[i] : cluster_index;
+
+    // a clustered insert may move any row, so paged rows must be in memory
+    if (cluster_index != NULL && unpageTable(table) == false) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to insert a new row.";
+    }
+
     // resize the table if necessary
     size_t num_rows = table->num_rows;
     bool must_resize = num_rows == table->capacity;
     if (must_resize) {
         log_info("-- Resizing table columns...\n");
-        bool was_empty = false;
+        size_t new_capacity = (table->capacity == 0) ? COL_INITIAL_SIZE : table->capacity * COL_RESIZE_FACTOR;
         for (size_t j = 0; j < table->col_count; j++) {
-            Column* curr_col = table->columns[j];
-            if (curr_col->data == NULL) {
-                curr_col->data = calloc(COL_INITIAL_SIZE, sizeof(int));
-                was_empty = true;
-            } else {
-                int* new_data = realloc(curr_col->data, table->capacity * COL_RESIZE_FACTOR * sizeof(int));
-                if (new_data == NULL) {
-                    send_message->status = EXECUTION_ERROR;
-                    return "-- Unable to insert a new row.";
-                }
-                curr_col->data = new_data;
+            if (resizeColumn(table->columns[j], new_capacity) == false) {
+                send_message->status = EXECUTION_ERROR;
+                return "-- Unable to insert a new row.";
             }
         }
-        if (was_empty == true) {
-            table->capacity = COL_INITIAL_SIZE;
-        } else {
-            table->capacity *= COL_RESIZE_FACTOR;
-        }
+        table->capacity = new_capacity;
     }
 
-    // check for a clustered index
-    Index* cluster_index = NULL;
-    for (size_t i = 0; i < table->num_indexes; i++)
-        cluster_index = (table->indexes[i]->clustered) ? table->indexes[i] : cluster_index;
     if (cluster_index != NULL) {
         // find corresponding column index and value
         size_t col_index = -1;
@@ -386,16 +637,19 @@ char* handleInsertQuery(DbOperator* query, message* send_message) {
                 insert_index = insertValueC(&(cluster_index->object->btreec), values[col_index]);
                 break;
             case SORTED:
-                insert_index = insertSorted(cluster_index->column->data, values[col_index], table->num_rows);
+                insert_index = insertSortedColumn(cluster_index->column, values[col_index], table->num_rows);
                 break;
         }
         
-        // now shift all values in all columns starting from insert_index onwards
+        // now shift all values in all columns starting from insert_index
+        // onwards; the rows crackers point at move with them
+        markTableDirty(table, insert_index);
+        dropCrackers(table);
         for (size_t j = 0; j < table->col_count; j++) {
-            if (j == col_index)
+            if (j == col_index && cluster_index->type == SORTED)
                 continue;
-            shiftValues(table->columns[j]->data, insert_index, table->num_rows, 0);
-            table->columns[j]->data[insert_index] = values[j];
+            shiftColumn(table->columns[j], insert_index, table->num_rows);
+            setValue(table->columns[j], insert_index, values[j]);
         }
 
         // check the other indexes to see if any need adjustment
@@ -419,46 +673,28 @@ char* handleInsertQuery(DbOperator* query, message* send_message) {
                     insertValueU(&(table->indexes[j]->object->btreeu), values[col_index], insert_index);
                     break;
                 case SORTED:
-                    // resize sorted column index array if necessary
-                    if (table->indexes[j]->object == NULL) {
-                        table->indexes[j]->object = malloc(sizeof(IndexObject));
-                        table->indexes[j]->object->column = malloc(sizeof(ColumnIndex));
-                    }
-                    if (table->indexes[j]->object->column->values == NULL) {
-                        table->indexes[j]->object->column->values = malloc(sizeof(int) * table->capacity);
-                        table->indexes[j]->object->column->indexes = malloc(sizeof(int) * table->capacity);
-                    }
-                    if (must_resize) {
-                        int* new_array1 = realloc(table->indexes[j]->object->column->values, sizeof(int) * table->capacity);
-                        int* new_array2 = realloc(table->indexes[j]->object->column->indexes, sizeof(int) * table->capacity);
-                        if (new_array1 != NULL) {
-                            table->indexes[j]->object->column->values = new_array1;
-                        } else {
-                            send_message->status = EXECUTION_ERROR;
-                            return "-- Re-allocation of unclustered sorted index values failed.";
-                        }
-                        if (new_array2 != NULL) {
-                            table->indexes[j]->object->column->indexes = new_array2;
-                        } else {
-                            send_message->status = EXECUTION_ERROR;
-                            return "-- Re-allocation of unclustered sorted index values failed.";
-                        }
+                    // grow the index along with the table
+                    if (!resizeColumnIndex(table->indexes[j], table->capacity)) {
+                        send_message->status = EXECUTION_ERROR;
+                        return "-- Re-allocation of unclustered sorted index values failed.";
                     }
-                    // insert value into unclustered column index array
-                    int unclustered_index = insertSorted(table->indexes[j]->object->column->values, values[col_index], table->num_rows);
-                    table->indexes[j]->object->column->indexes[unclustered_index] = insert_index;
+                    insertIndexRow(table->indexes[j], insert_index, table->num_rows);
                     break;
             }
         }
 
         table->num_rows++;
+        for (size_t j = 0; j < table->col_count; j++)
+            updateColumnStats(table->columns[j], values[j], table->num_rows);
+        statsAddRows(OP_INSERT, 0, 1);
         send_message->status = OK_DONE;
         return "Successfully inserted new row.";
     }
 
     // unclustered indices only, simply insert and update indices as necessary
+    markTableDirty(table, table->num_rows);
     for (size_t i = 0; i < table->col_count; i++)
-        table->columns[i]->data[table->num_rows] = values[i];
+        setValue(table->columns[i], table->num_rows, values[i]);
 
     // update indices
     for (size_t i = 0; i < table->num_indexes; i++) {
@@ -479,37 +715,192 @@ char* handleInsertQuery(DbOperator* query, message* send_message) {
                 insertValueU(&(table->indexes[i]->object->btreeu), values[col_index], table->num_rows);
                 break;
             case SORTED:
-                // resize sorted column index array if necessary
-                if (table->indexes[i]->object->column->values == NULL) {
-                    table->indexes[i]->object->column->values = malloc(sizeof(int) * table->capacity);
-                    table->indexes[i]->object->column->indexes = malloc(sizeof(int) * table->capacity);
+                // grow the index along with the table
+                if (!resizeColumnIndex(table->indexes[i], table->capacity)) {
+                    send_message->status = EXECUTION_ERROR;
+                    return "-- Re-allocation of unclustered sorted index values failed.";
                 }
-                if (must_resize) {
-                    int* new_array1 = realloc(table->indexes[i]->object->column->values, sizeof(int) * table->capacity);
-                    int* new_array2 = realloc(table->indexes[i]->object->column->indexes, sizeof(int) * table->capacity);
-                    if (new_array1 != NULL) {
-                        table->indexes[i]->object->column->values = new_array1;
-                    } else {
+                insertIndexRow(table->indexes[i], table->num_rows, table->num_rows);
+                break;
+        }
+    }
+    table->num_rows++;
+    for (size_t i = 0; i < table->col_count; i++)
+        updateColumnStats(table->columns[i], values[i], table->num_rows);
+    statsAddRows(OP_INSERT, 0, 1);
+
+    send_message->status = OK_DONE;
+    return "Successfully inserted new row.";
+}
+
+// selects the rows of a base column in [minimum, maximum) into result;
+// *num_scanned receives the number of rows read. Returns an error message,
+// or NULL on success.
+char* selectColumn(Table* table, Column* column, long minimum, long maximum, Result* result, size_t* num_scanned,
+    message* send_message) {
+    // read through an index only when it beats a scan, and crack
+    // columns that have no index instead of scanning them
+    long estimated_rows;
+    Index* index = chooseSelectIndex(table, column, minimum, maximum, &estimated_rows);
+    bool cracked = index == NULL && shouldCrack(table, column);
+    statsTracePhase("plan");
+    statsTraceAccess(cracked ? "cracker index" : accessPathName(index), estimated_rows);
+    
+    if (cracked) {
+        int* data;
+        long num_selected = crackSelect(column, table->num_rows, minimum, maximum, &data);
+        if (num_selected < 0) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Error cracking column.";
+        }
+        storePositions(result, data, num_selected, table->num_rows);
+        *num_scanned = num_selected;
+        statsTracePhase("crack");
+    } else if (index != NULL) {
+        // use index to search for valid values
+        switch (index->type) {
+            case BTREE:
+                if (index->clustered) {
+                    int* int_payload;
+                    size_t num_selected = findRangeC(&int_payload, index->object->btreec, clampInt(minimum), clampInt(maximum));
+                    storePositions(result, int_payload, num_selected, table->num_rows);
+                } else {
+                    int* int_payload;
+                    result->num_tuples = findRangeU(&int_payload, index->object->btreeu, clampInt(minimum), clampInt(maximum));
+                    result->payload = (void*) int_payload;
+                }
+                break;
+            case SORTED:
+                if (index->clustered) {
+                    // rows [minIndex, maxIndex) hold the values in [minimum, maximum)
+                    size_t minIndex, maxIndex;
+                    if (!lowerBound(column, table->num_rows, minimum, &minIndex)
+                        || !lowerBound(column, table->num_rows, maximum, &maxIndex)) {
                         send_message->status = EXECUTION_ERROR;
-                        return "-- Re-allocation of unclustered sorted index values failed.";
+                        return "-- Unable to read the column.";
                     }
-                    if (new_array2 != NULL) {
-                        table->indexes[i]->object->column->indexes = new_array2;
+                    if (minIndex >= maxIndex) {
+                        result->num_tuples = 0;
+                        result->payload = NULL;
+                    } else if (preferBitmap(maxIndex - minIndex, table->num_rows)) {
+                        uint64_t* words = calloc(bitmapWords(table->num_rows), sizeof(uint64_t));
+                        for (size_t i = minIndex; i < maxIndex; i++)
+                            words[i / 64] |= (uint64_t) 1 << (i % 64);
+                        storeBitmap(result, words, table->num_rows, maxIndex - minIndex);
                     } else {
-                        send_message->status = EXECUTION_ERROR;
-                        return "-- Re-allocation of unclustered sorted index values failed.";
+                        result->num_tuples = maxIndex - minIndex;
+                        int* results = malloc(sizeof(int) * (maxIndex - minIndex));
+                        for (size_t i = minIndex; i < maxIndex; i++) {
+                            results[i - minIndex] = i;
+                        }
+                        result->payload = (void*) results;
                     }
+                } else {
+                    // entries [from, to) hold the values in range; the
+                    // result remembers them so fetches of the columns
+                    // the index copies can read them from it
+                    ColumnIndex* cindex = index->object->column;
+                    size_t from = lowerBoundS(cindex, table->num_rows, minimum);
+                    size_t to = lowerBoundS(cindex, table->num_rows, maximum);
+                    size_t count = (to > from) ? to - from : 0;
+                    int* results = malloc(sizeof(int) * (count + 1));
+                    memcpy(results, cindex->indexes + from, sizeof(int) * count);
+                    result->num_tuples = count;
+                    result->payload = (void*) results;
+                    result->covering = index;
+                    result->cover_from = from;
+                    result->cover_version = cindex->version;
                 }
-                // insert value into unsorted column index array
-                int unclustered_index = insertSorted(table->indexes[i]->object->column->values, values[col_index], table->num_rows);
-                table->indexes[i]->object->column->indexes[unclustered_index] = table->num_rows;
                 break;
         }
+
+        // an index only reads the entries in range
+        *num_scanned = result->num_tuples;
+        statsTracePhase("index lookup");
+    } else {
+        // scan through column into a bitmap of the matching rows, which
+        // a sparse selection then trades for its positions
+        uint64_t* words = calloc(bitmapWords(table->num_rows) + 1, sizeof(uint64_t));
+        if (words == NULL) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Error calculating result array.";
+        }
+        size_t num_inserted;
+        if (!scanColumnBitmap(column, table->num_rows, minimum, maximum, words, &num_inserted)) {
+            free(words);
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to read the column.";
+        }
+        storeBitmap(result, words, table->num_rows, num_inserted);
+        *num_scanned = table->num_rows;
+        statsTracePhase("scan");
     }
-    table->num_rows++;
+    return NULL;
+}
 
-    send_message->status = OK_DONE;
-    return "Successfully inserted new row.";
+// selects the rows of a table that satisfy the predicates of a select on
+// several of its columns. The predicate expected to match the fewest rows
+// is evaluated through its access path; every other one, most selective
+// first, only checks the rows still left. Returns an error message, or
+// NULL on success.
+char* selectConjunction(SelectOperator* select, Result* result, message* send_message) {
+    Table* table = select->table;
+    size_t num_predicates = select->num_conjuncts + 1;
+    SelectPredicate predicates[num_predicates];
+    long estimates[num_predicates];
+    predicates[0] = (SelectPredicate) {
+        .col_name = select->params[2],
+        .minimum = select->minimum,
+        .maximum = select->maximum,
+        .column = select->column
+    };
+    memcpy(predicates + 1, select->conjuncts, sizeof(SelectPredicate) * select->num_conjuncts);
+
+    // order the predicates by their estimated matches; there are only a few
+    for (size_t i = 0; i < num_predicates; i++) {
+        SelectPredicate predicate = predicates[i];
+        long estimate;
+        chooseSelectIndex(table, predicate.column, predicate.minimum, predicate.maximum, &estimate);
+        size_t j = i;
+        for (; j > 0 && estimates[j - 1] > estimate; j--) {
+            predicates[j] = predicates[j - 1];
+            estimates[j] = estimates[j - 1];
+        }
+        predicates[j] = predicate;
+        estimates[j] = estimate;
+    }
+
+    size_t num_scanned;
+    char* error = selectColumn(table, predicates[0].column, predicates[0].minimum, predicates[0].maximum,
+        result, &num_scanned, send_message);
+    if (error != NULL)
+        return error;
+
+    // the survivors are no longer a run of index entries
+    result->covering = NULL;
+    for (size_t i = 1; i < num_predicates && result->num_tuples > 0; i++) {
+        SelectPredicate* predicate = &predicates[i];
+        num_scanned += result->num_tuples;
+        size_t count;
+        bool success;
+        if (result->is_bitmap) {
+            success = refineColumnBitmap(predicate->column, result->bitmap_rows,
+                predicate->minimum, predicate->maximum, result->payload, &count);
+            if (success)
+                storeBitmap(result, result->payload, result->bitmap_rows, count);
+        } else {
+            success = refineColumnPositions(predicate->column, result->payload, result->num_tuples,
+                predicate->minimum, predicate->maximum, &count);
+            result->num_tuples = count;
+        }
+        if (!success) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to read the column.";
+        }
+    }
+    statsAddRows(OP_SELECT, num_scanned, result->num_tuples);
+    statsTracePhase("refine");
+    return NULL;
 }
 
 char* handleSelectQuery(DbOperator* query, message* send_message) {
@@ -521,8 +912,8 @@ char* handleSelectQuery(DbOperator* query, message* send_message) {
     // retrieve params
     SelectOperator select = query->fields.select;
     char* handle = select.handle;
-    int minimum = select.minimum;
-    int maximum = select.maximum;
+    long minimum = select.minimum;
+    long maximum = select.maximum;
 
     // search for context and add to the list of variables
     ClientContext* context = searchContext(query->client_fd);
@@ -534,7 +925,7 @@ char* handleSelectQuery(DbOperator* query, message* send_message) {
     // create a new GeneralizedColumnHandle
     GeneralizedColumnHandle new_handle;
     GeneralizedColumnPointer new_pointer;
-    new_pointer.result = malloc(sizeof(Result));
+    new_pointer.result = calloc(1, sizeof(Result));
     new_pointer.result->data_type = INT;
     new_pointer.result->num_tuples = 0;
     new_pointer.result->payload = NULL;
@@ -559,69 +950,6 @@ char* handleSelectQuery(DbOperator* query, message* send_message) {
         context->chandle_table[dupIndex] = new_handle;
     }
 
-    // add to batched queries if necessary
-    if (context->queries != NULL) {
-        BatchedQueries* queries = context->queries;
-        if (queries->num_queries == 0) {
-            char* db_name = select.params[0];
-            char* tbl_name = select.params[1];
-            char* col_name = select.params[2];
-
-            // check database
-            if (strcmp(db_name, current_db->name) != 0) {
-                send_message->status = OBJECT_NOT_FOUND;
-                return "-- Database not found.";
-            }
-
-            // if we didn't manage to find a table
-            Table* table = findTable(tbl_name);
-            if (table == NULL) {
-                send_message->status = OBJECT_NOT_FOUND;
-                return "-- Unable to find specified table.";
-            }
-
-            // if we didn't manage to find a column
-            Column* column = findColumn(table, col_name);
-            if (column == NULL) {
-                send_message->status = OBJECT_NOT_FOUND;
-                return "-- Unable to find specified column.";
-            }
-
-            queries->table = table;
-            queries->column = column;
-
-            queries->minimum = malloc(sizeof(int));
-            queries->maximum = malloc(sizeof(int));
-            queries->results = malloc(sizeof(Result*));
-        } else {
-            int* new_mins = realloc(queries->minimum, sizeof(int) * (queries->num_queries + 1));
-            int* new_maxs = realloc(queries->maximum, sizeof(int) * (queries->num_queries + 1));
-            Result** new_results = realloc(queries->results, sizeof(Result*) * (queries->num_queries + 1));
-            if (new_mins != NULL) {
-                queries->minimum = new_mins;
-            } else {
-                return "-- Failed to insert new select query into batch.";
-            }
-            if (new_maxs != NULL) {
-                queries->maximum = new_maxs;
-            } else {
-                return "-- Failed to insert new select query into batch.";
-            }
-            if (new_results != NULL) {
-                queries->results = new_results;
-            } else {
-                return "-- Failed to insert new select query into batch.";
-            }
-        }
-        queries->minimum[queries->num_queries] = minimum;
-        queries->maximum[queries->num_queries] = maximum;
-        queries->results[queries->num_queries] = new_pointer.result;
-        queries->num_queries++;
-        
-        send_message->status = OK_DONE;
-        return "-- Successfully inserted select query into batch.";
-    }
-
     // handle variable select sources separately from database sources
     if (select.src_is_var) {
         GeneralizedColumnHandle* src_handle = findHandle(context, select.params[0]);
@@ -637,170 +965,50 @@ char* handleSelectQuery(DbOperator* query, message* send_message) {
             return "-- Unable to find specified select source.";
         }
 
-        // scan through column and store all data in tuples
-        int capacity = 0;
-        int num_inserted = 0;
-        int* data = NULL;
-        int* indexes = (int*) src_result->payload;
-        int* values = (int*) val_result->payload;
-        for (size_t i = 0; i < src_result->num_tuples; i++) {
-            if (values[i] < minimum || values[i] >= maximum) 
-                continue;
-            if (num_inserted == capacity) {
-                capacity = (capacity == 0) ? 1 : 2 * capacity;
-                if (data == NULL) {
-                    data = calloc(capacity, sizeof(int));
-                } else {
-                    int* new_data = realloc(data, sizeof(int) * capacity);
-                    if (new_data == NULL) {
-                        free(new_data);
-                        free(new_pointer.result);
-                        send_message->status = EXECUTION_ERROR;
-                        return "-- Error calculating result array.";
-                    }
-                    data = new_data;   
-                }
-            }
-            data[num_inserted] = indexes[i];
-            num_inserted++;
-        }
-        new_pointer.result->payload = data;
-        new_pointer.result->num_tuples = num_inserted;
-    } else {
-        char* db_name = select.params[0];
-        char* tbl_name = select.params[1];
-        char* col_name = select.params[2];
-
-        // check database
-        if (strcmp(db_name, current_db->name) != 0) {
-            send_message->status = OBJECT_NOT_FOUND;
-            return "-- Database not found.";
-        }
-
-        // if we didn't manage to find a table
-        Table* table = findTable(tbl_name);
-        if (table == NULL) {
-            send_message->status = OBJECT_NOT_FOUND;
-            return "-- Unable to find specified table.";
-        }
-
-        // if we didn't manage to find a column
-        Column* column = findColumn(table, col_name);
-        if (column == NULL) {
-            send_message->status = OBJECT_NOT_FOUND;
-            return "-- Unable to find specified column.";
+        if (!isIntegerType(val_result->data_type)) {
+            send_message->status = QUERY_UNSUPPORTED;
+            return "-- Unable to select on non-integer values.";
         }
 
-        // check for an index we can use
-        Index* index = NULL;
-        for (size_t i = 0; i < table->num_indexes; i++)
-            index = table->indexes[i]->column == column ? table->indexes[i] : index;
-        
-        if (index != NULL) {
-            struct timeval stop, start;
-            gettimeofday(&start, NULL);
-            
-            // use index to search for valid values
-            switch (index->type) {
-                case BTREE:
-                    if (index->clustered) {
-                        int* int_payload;
-                        new_pointer.result->num_tuples = findRangeC(&int_payload, index->object->btreec, minimum, maximum);
-                        new_pointer.result->payload = (void*) int_payload;
-                    } else {
-                        int* int_payload;
-                        new_pointer.result->num_tuples = findRangeU(&int_payload, index->object->btreeu, minimum, maximum);
-                        new_pointer.result->payload = (void*) int_payload;
-                    }
-                    break;
-                case SORTED:
-                    if (index->clustered) {
-                        int low = 0;
-                        int high = table->num_rows;
-                        while (low < high) {
-                            int current = (low + high) / 2;
-                            if (column->data[current] < minimum)
-                                low = current + 1;
-                            else
-                                high = current;
-                        }
-                        // low now contains the smallest element >= minimum
-                        size_t minIndex = low;
-                        low = 0;
-                        high = table->num_rows;
-                        while (low < high) {
-                            int current = (low + high) / 2;
-                            if (column->data[current] >= maximum)
-                                high = current - 1;
-                            else
-                                low = current + 1;
-                        }
-                        // high now contains the greatest element <= minimum
-                        size_t maxIndex = high;
-                        if (minIndex >= table->num_rows || maxIndex <= 0) {
-                            new_pointer.result->num_tuples = 0;
-                            new_pointer.result->payload = NULL;
-                        } else {
-                            new_pointer.result->num_tuples = maxIndex - minIndex + 1;
-                            int* results = malloc(sizeof(int) * (maxIndex - minIndex + 1));
-                            for (size_t i = minIndex; i <= maxIndex && i < table->num_rows; i++) {
-                                results[i - minIndex] = i;
-                            }
-                            new_pointer.result->payload = (void*) results;
-                        }
-                    } else {
-                        int* int_payload;
-                        new_pointer.result->num_tuples = findRangeS(&int_payload, index->object->column, table->num_rows, minimum, maximum);
-                        new_pointer.result->payload = (void*) int_payload;
-                    }
-                    break;
+        // scan through values and store the matching positions; a bitmap
+        // source is narrowed into a bitmap of its own
+        statsTraceAccess("scan of intermediate result", -1);
+        size_t num_inserted;
+        if (src_result->is_bitmap) {
+            uint64_t* words = calloc(bitmapWords(src_result->bitmap_rows) + 1, sizeof(uint64_t));
+            if (words == NULL) {
+                send_message->status = EXECUTION_ERROR;
+                return "-- Error calculating result array.";
             }
-
-            gettimeofday(&stop, NULL);
-            printf("-- Select query using %s %s index took %lu milliseconds.  %i out of %i tuples.\n", 
-                index->clustered ? "clustered" : "unclustered",
-                index->type == BTREE ? "BTREE" : "SORTED",
-                1000000 * (stop.tv_sec - start.tv_sec) + stop.tv_usec - start.tv_usec,
-                new_pointer.result->num_tuples,
-                table->num_rows);
+            num_inserted = selectValuesBitmap(val_result->data_type, val_result->payload, src_result->payload,
+                src_result->bitmap_rows, minimum, maximum, words);
+            storeBitmap(new_pointer.result, words, src_result->bitmap_rows, num_inserted);
         } else {
-            struct timeval stop, start;
-            gettimeofday(&start, NULL);
-            
-            // scan through column and store all data in tuples
-            int capacity = 0;
-            int num_inserted = 0;
-            int* data = NULL;
-            for (size_t i = 0; i < table->num_rows; i++) {
-                if (column->data[i] < minimum || column->data[i] >= maximum)
-                    continue;
-                if (num_inserted == capacity) {
-                    capacity = (capacity == 0) ? 1 : 2 * capacity;
-                    if (data == NULL) {
-                        data = calloc(capacity, sizeof(int));
-                    } else {
-                        int* new_data = realloc(data, sizeof(int) * capacity);
-                        if (new_data == NULL) {
-                            free(new_data);
-                            free(new_pointer.result);
-                            send_message->status = EXECUTION_ERROR;
-                            return "-- Error calculating result array.";
-                        }
-                        data = new_data;   
-                    }
-                }
-                data[num_inserted] = i;
-                num_inserted++;
+            int* data = malloc(sizeof(int) * (src_result->num_tuples + 1));
+            if (data == NULL) {
+                send_message->status = EXECUTION_ERROR;
+                return "-- Error calculating result array.";
             }
+            num_inserted = selectValues(val_result->data_type, val_result->payload, (int*) src_result->payload,
+                src_result->num_tuples, minimum, maximum, data);
+            data = shrinkPositions(data, num_inserted);
             new_pointer.result->payload = data;
             new_pointer.result->num_tuples = num_inserted;
-
-            gettimeofday(&stop, NULL);
-            printf("-- Select query using scan took %lu milliseconds.  %i out of %i tuples.\n", 
-                1000000 * (stop.tv_sec - start.tv_sec) + stop.tv_usec - start.tv_usec, 
-                num_inserted,
-                table->num_rows);
         }
+        statsAddRows(OP_SELECT, src_result->num_tuples, num_inserted);
+        statsTracePhase("scan");
+    } else {
+        size_t num_scanned;
+        char* error = resolveSelectColumn(&select, send_message);
+        if (error == NULL && select.num_conjuncts > 0)
+            error = selectConjunction(&select, new_pointer.result, send_message);
+        else if (error == NULL)
+            error = selectColumn(select.table, select.column, minimum, maximum, new_pointer.result, &num_scanned,
+                send_message);
+        if (error != NULL)
+            return error;
+        if (select.num_conjuncts == 0)
+            statsAddRows(OP_SELECT, num_scanned, new_pointer.result->num_tuples);
     }
 
     send_message->status = OK_DONE;
@@ -822,7 +1030,7 @@ char* handleFetchQuery(DbOperator* query, message* send_message) {
     char* target = fetch.target;
     
     // check database
-    if (strcmp(db_name, current_db->name) != 0) {
+    if (current_db == NULL || strcmp(db_name, current_db->name) != 0) {
         send_message->status = OBJECT_NOT_FOUND;
         return "-- Database not found.";
     }
@@ -858,8 +1066,8 @@ char* handleFetchQuery(DbOperator* query, message* send_message) {
     // create a new GeneralizedColumnHandle
     GeneralizedColumnHandle new_handle;
     GeneralizedColumnPointer new_pointer;
-    new_pointer.result = malloc(sizeof(Result));
-    new_pointer.result->data_type = INT;
+    new_pointer.result = calloc(1, sizeof(Result));
+    new_pointer.result->data_type = column->type;
     new_pointer.result->num_tuples = 0;
     new_pointer.result->payload = NULL;
     GeneralizedColumn gen_column = {
@@ -869,13 +1077,32 @@ char* handleFetchQuery(DbOperator* query, message* send_message) {
     new_handle.generalized_column = gen_column;
     strcpy(new_handle.name, target);
 
-    // scan through column and store all data in tuples
-    int num_tuples = src_handle->generalized_column.column_pointer.result->num_tuples;
-    int* indices = (int*) src_handle->generalized_column.column_pointer.result->payload;
-    int* data = malloc(sizeof(int) * num_tuples);
-    for (int i = 0; i < num_tuples; i++) {
-        data[i] = column->data[indices[i]];
+    // gather the selected values, keeping the column's storage width; rows
+    // selected through an index that copies the column are read from it
+    Result* src_result = src_handle->generalized_column.column_pointer.result;
+    size_t num_tuples = src_result->num_tuples;
+    Index* covering = src_result->covering;
+    bool covered = covering != NULL && indexCovers(covering, column) &&
+        covering->object->column->version == src_result->cover_version;
+    const char* path = src_result->is_bitmap ? "bitmap fetch" : "positional fetch";
+    statsTraceAccess(covered ? "covering index" : path, (long) num_tuples);
+    statsTracePhase("resolve");
+    void* data = malloc(typeWidth(column->type) * (num_tuples + 1));
+    bool success = data != NULL;
+    if (success && covered)
+        readCovered(covering, column, src_result->cover_from, num_tuples, data);
+    else if (success && src_result->is_bitmap)
+        success = fetchColumnBitmap(column, src_result->payload, src_result->bitmap_rows, data);
+    else if (success)
+        success = fetchColumn(column, (int*) src_result->payload, num_tuples, data);
+    if (!success) {
+        free(data);
+        free(new_pointer.result);
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to read the column.";
     }
+    statsAddRows(OP_FETCH, num_tuples, num_tuples);
+    statsTracePhase("gather");
     new_pointer.result->payload = data;
     new_pointer.result->num_tuples = num_tuples;
 
@@ -914,8 +1141,11 @@ char* handlePrintQuery(DbOperator* query, message* send_message) {
         return "-- Unable to find context for current client.";
     }
 
-    // search for handles in context
+    // search for handles in context; selections kept as bitmaps are
+    // printed as their positions
     Result* results[num_handles];
+    void* payloads[num_handles];
+    void* copies[num_handles];
     for (size_t i = 0; i < num_handles; i++) {
         GeneralizedColumnHandle* columnHandle = findHandle(context, handles[i]);
         if (columnHandle == NULL) {
@@ -929,6 +1159,8 @@ char* handlePrintQuery(DbOperator* query, message* send_message) {
         }
         results[i] = result;
     }
+    for (size_t i = 0; i < num_handles; i++)
+        payloads[i] = resultPayload(results[i], &copies[i]);
 
     // create string payload to return
     int length = 0;
@@ -936,32 +1168,48 @@ char* handlePrintQuery(DbOperator* query, message* send_message) {
     size_t num_tuples = results[0]->num_tuples;
     for (size_t i = 0; i < num_handles; i++) {
         switch(results[i]->data_type) {
-            case INT: {
-                int* data = (int*) results[i]->payload;
+            case BYTE: {
+                int8_t* data = (int8_t*) payloads[i];
                 for (size_t i = 0; i < num_tuples; i++) {
                     sprintf(buf, "%i", data[i]);
                     length += strlen(buf) + 1;
                 }
                 break;
             }
-            case LONG: {
-                long* data = (long*) results[i]->payload;
+            case SHORT: {
+                int16_t* data = (int16_t*) payloads[i];
                 for (size_t i = 0; i < num_tuples; i++) {
-                    sprintf(buf, "%ld", data[i]);
+                    sprintf(buf, "%i", data[i]);
                     length += strlen(buf) + 1;
                 }
                 break;
             }
-            case FLOAT: {
-                float* data = (float*) results[i]->payload;
+            case INT: {
+                int* data = (int*) payloads[i];
                 for (size_t i = 0; i < num_tuples; i++) {
-                    sprintf(buf, "%.2f", data[i]);
+                    sprintf(buf, "%i", data[i]);
                     length += strlen(buf) + 1;
                 }
                 break;
             }
-            case DOUBLE: {
-                double* data = (double*) results[i]->payload;
+            case LONG: {
+                long* data = (long*) payloads[i];
+                for (size_t i = 0; i < num_tuples; i++) {
+                    sprintf(buf, "%ld", data[i]);
+                    length += strlen(buf) + 1;
+                }
+                break;
+            }
+            case FLOAT: {
+                float* data = (float*) payloads[i];
+                for (size_t i = 0; i < num_tuples; i++) {
+                    sprintf(buf, "%.2f", data[i]);
+                    length += strlen(buf) + 1;
+                }
+                break;
+            }
+            case DOUBLE: {
+                double* data = (double*) payloads[i];
                 for (size_t i = 0; i < num_tuples; i++) {
                     sprintf(buf, "%.2f", data[i]);
                     length += strlen(buf) + 1;
@@ -976,37 +1224,40 @@ char* handlePrintQuery(DbOperator* query, message* send_message) {
     char* values = malloc(sizeof(char) * (length + 1));
     values[0] = '\0';
     
-    // TODO: really inefficient because it iterates across results
+    // append row by row at the end of what was written so far
+    int written = 0;
     for (size_t i = 0; i < num_tuples; i++) {
         for (size_t j = 0; j < num_handles; j++) {
             char delim = (j + 1 == num_handles) ? '\n' : ',';
+            char* end = values + written;
+            size_t space = length + 1 - written;
             switch (results[j]->data_type) {
-                case INT: {
-                    int* data = (int*) results[j]->payload;
-                    sprintf(values, "%s%i%c", values, data[i], delim);
+                case BYTE:
+                    written += snprintf(end, space, "%i%c", ((int8_t*) payloads[j])[i], delim);
                     break;
-                }
-                case LONG: {
-                    long* data = (long*) results[j]->payload;
-                    sprintf(values, "%s%ld%c", values, data[i], delim);
+                case SHORT:
+                    written += snprintf(end, space, "%i%c", ((int16_t*) payloads[j])[i], delim);
                     break;
-                }
-                case FLOAT: {
-                    float* data = (float*) results[j]->payload;
-                    sprintf(values, "%s%.2f%c", values, data[i], delim);
+                case INT:
+                    written += snprintf(end, space, "%i%c", ((int*) payloads[j])[i], delim);
                     break;
-                }
-                case DOUBLE: {
-                    double* data = (double*) results[j]->payload;
-                    sprintf(values, "%s%.2f%c", values, data[i], delim);
+                case LONG:
+                    written += snprintf(end, space, "%ld%c", ((long*) payloads[j])[i], delim);
+                    break;
+                case FLOAT:
+                    written += snprintf(end, space, "%.2f%c", ((float*) payloads[j])[i], delim);
+                    break;
+                case DOUBLE:
+                    written += snprintf(end, space, "%.2f%c", ((double*) payloads[j])[i], delim);
                     break;
-                }
                 default:
                     break;
             }
         }
     }
     values[length] = '\0';
+    for (size_t i = 0; i < num_handles; i++)
+        free(copies[i]);
     // log_info("-- result printf: %s\n", values);
 
     send_message->status = OK_WAIT_FOR_RESPONSE;
@@ -1014,6 +1265,247 @@ char* handlePrintQuery(DbOperator* query, message* send_message) {
     return values;
 }
 
+// keeps a statement sent while a batch is open for batch_execute()
+char* queueBatchedStatement(ClientContext* context, DbOperator* query, message* send_message) {
+    BatchedStatement queued = query->fields.batch.queued;
+    if (context->queries == NULL) {
+        free(queued.memory);
+        send_message->status = EXECUTION_ERROR;
+        return "-- Invalid batch request; not in the correct state.";
+    }
+    BatchedQueries* queries = context->queries;
+    if (queries->num_statements == queries->statement_slots) {
+        size_t new_slots = (queries->statement_slots == 0) ? 16 : 2 * queries->statement_slots;
+        BatchedStatement* statements = realloc(queries->statements, sizeof(BatchedStatement) * new_slots);
+        if (statements == NULL) {
+            free(queued.memory);
+            send_message->status = EXECUTION_ERROR;
+            return "-- Failed to insert new query into batch.";
+        }
+        queries->statements = statements;
+        queries->statement_slots = new_slots;
+    }
+    queued.statement->client_fd = query->client_fd;
+    queued.statement->context = context;
+    queries->statements[queries->num_statements++] = queued;
+    statsTraceAccess("deferred to batch_execute()", -1);
+
+    send_message->status = OK_DONE;
+    return "-- Successfully inserted query into batch.";
+}
+
+// true for a select of a batch that a pass over its column can answer: one
+// predicate on a base column, which no index answers better
+bool scansInBatch(DbOperator* query) {
+    if (query->type != OP_SELECT)
+        return false;
+    SelectOperator* select = &query->fields.select;
+    message ignored;
+    if (select->src_is_var || select->num_conjuncts > 0 || resolveSelectColumn(select, &ignored) != NULL)
+        return false;
+    long estimated_rows;
+    return chooseSelectIndex(select->table, select->column, select->minimum, select->maximum, &estimated_rows) == NULL;
+}
+
+// true for statements that change neither the database nor anything but
+// their own handles
+bool readsOnly(DbOperator* query) {
+    switch (query->type) {
+        case OP_SELECT:
+        case OP_FETCH:
+        case OP_PRINT:
+        case OP_MATH:
+        case OP_AGGREGATE:
+        case OP_GROUP_BY:
+        case OP_JOIN:
+        case OP_COMBINE:
+        case OP_STATS:
+            return true;
+        case OP_EXPLAIN:
+            // explain runs the statement it wraps
+            return readsOnly(query->fields.explain.statement);
+        default:
+            return false;
+    }
+}
+
+static bool isNameChar(char c) {
+    return isalnum((unsigned char) c) || c == '_';
+}
+
+// true if the handle appears in the text as a name of its own
+bool mentionsHandle(const char* text, const char* handle) {
+    size_t len = strlen(handle);
+    for (const char* found = strstr(text, handle); found != NULL; found = strstr(found + 1, handle))
+        if ((found == text || !isNameChar(found[-1])) && !isNameChar(found[len]))
+            return true;
+    return false;
+}
+
+// moves the selects of the batch that a pass over their column can answer
+// up to the first one, statement first, and runs those on a column shared
+// by several with one scan of it. A select only moves past statements that
+// change nothing but their handles and don't mention its own. Returns the
+// error of the first scan that failed, with its status in send_message, or
+// NULL.
+char* runBatchScans(BatchedQueries* queries, size_t first, bool* done, message* send_message) {
+    size_t num_statements = queries->num_statements;
+    size_t* moved = malloc(sizeof(size_t) * num_statements);
+    size_t* stayed = malloc(sizeof(size_t) * num_statements);
+    if (moved == NULL || stayed == NULL) {
+        free(moved);
+        free(stayed);
+        return NULL;
+    }
+    size_t num_moved = 0;
+    size_t num_stayed = 0;
+    moved[num_moved++] = first;
+    for (size_t i = first + 1; i < num_statements; i++) {
+        if (done[i])
+            continue;
+        DbOperator* statement = queries->statements[i].statement;
+        bool movable = scansInBatch(statement);
+        for (size_t j = 0; movable && j < num_stayed; j++)
+            movable = !mentionsHandle(queries->statements[stayed[j]].text, statement->fields.select.handle);
+        if (movable)
+            moved[num_moved++] = i;
+        else if (readsOnly(statement))
+            stayed[num_stayed++] = i;
+        else
+            break;
+    }
+
+    // one scan for every column more than one select reads
+    char* error = NULL;
+    for (size_t i = 0; i < num_moved; i++) {
+        SelectOperator* select = &queries->statements[moved[i]].statement->fields.select;
+        if (done[moved[i]])
+            continue;
+        int num_queries = 0;
+        for (size_t j = i; j < num_moved; j++)
+            num_queries += queries->statements[moved[j]].statement->fields.select.column == select->column;
+        if (num_queries < 2)
+            continue;
+
+        long minimum[num_queries];
+        long maximum[num_queries];
+        Result* results[num_queries];
+        ScanGroup group = {
+            .table = select->table,
+            .column = select->column,
+            .minimum = minimum,
+            .maximum = maximum,
+            .results = results,
+            .num_queries = 0
+        };
+        ClientContext* context = queries->statements[moved[i]].statement->context;
+        for (size_t j = i; j < num_moved; j++) {
+            SelectOperator* member = &queries->statements[moved[j]].statement->fields.select;
+            if (member->column != select->column)
+                continue;
+            Result* result = calloc(1, sizeof(Result));
+            if (result == NULL || !addResultHandle(context, member->handle, result)) {
+                free(result);
+                break;
+            }
+            result->data_type = INT;
+            minimum[group.num_queries] = member->minimum;
+            maximum[group.num_queries] = member->maximum;
+            results[group.num_queries++] = result;
+            done[moved[j]] = true;
+        }
+        message scan_message = { .status = OK_DONE, .length = 0, .payload = NULL };
+        char* result = handleBatchSelectQuery(&group, &scan_message);
+        if (scan_message.status != OK_DONE && error == NULL) {
+            send_message->status = scan_message.status;
+            error = result;
+        }
+    }
+    free(moved);
+    free(stayed);
+    return error;
+}
+
+// what the statements of the last batch printed, one after another
+static char* batch_output = NULL;
+static size_t batch_output_size = 0;
+
+static bool appendBatchOutput(size_t* length, const char* output) {
+    size_t added = strlen(output);
+    if (*length + added + 1 > batch_output_size) {
+        size_t new_size = batch_output_size == 0 ? 4096 : batch_output_size;
+        while (new_size < *length + added + 1)
+            new_size *= 2;
+        char* new_output = realloc(batch_output, new_size);
+        if (new_output == NULL)
+            return false;
+        batch_output = new_output;
+        batch_output_size = new_size;
+    }
+    memcpy(batch_output + *length, output, added + 1);
+    *length += added;
+    return true;
+}
+
+// adds the error of a statement to what the batch printed, on a line of
+// its own
+static bool appendBatchError(size_t* length, const char* error) {
+    return appendBatchOutput(length, error) && appendBatchOutput(length, "\n");
+}
+
+// runs the statements of a batch in order, except for the selects
+// runBatchScans() moves ahead to share a scan. Statements that change the
+// database are logged as they succeed. Returns what the statements
+// printed, with the error of each that failed where it would have printed.
+char* executeBatch(BatchedQueries* queries, message* send_message) {
+    bool* done = calloc(queries->num_statements + 1, sizeof(bool));
+    if (done == NULL) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to execute batch.";
+    }
+    size_t length = 0;
+    bool logged = false;
+    for (size_t i = 0; i < queries->num_statements; i++) {
+        if (done[i])
+            continue;
+        BatchedStatement* batched = &queries->statements[i];
+        message statement_message = { .status = OK_DONE, .length = 0, .payload = NULL };
+        bool collected = true;
+        if (scansInBatch(batched->statement)) {
+            // a shared scan that failed reports itself where it ran
+            char* error = runBatchScans(queries, i, done, &statement_message);
+            if (error != NULL)
+                collected = appendBatchError(&length, error);
+        }
+        if (collected && !done[i]) {
+            statement_message.status = OK_DONE;
+            char* result = executeDbOperator(batched->statement, &statement_message);
+            if (walShouldLog(batched->text) && statement_message.status == OK_DONE)
+                logged |= walAppend(batched->text);
+            if (statement_message.status == OK_WAIT_FOR_RESPONSE)
+                collected = appendBatchOutput(&length, result);
+            else if (statement_message.status != OK_DONE)
+                collected = appendBatchError(&length, result);
+            done[i] = true;
+        }
+        if (!collected) {
+            free(done);
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to collect batch output.";
+        }
+    }
+    free(done);
+    if (logged)
+        walCheckpointIfDue();
+
+    if (length == 0) {
+        send_message->status = OK_DONE;
+        return "-- Successfully processed batch request.";
+    }
+    send_message->status = OK_WAIT_FOR_RESPONSE;
+    return batch_output;
+}
+
 char* handleBatchQuery(DbOperator* query, message* send_message) {
     if (query == NULL || query->type != OP_BATCH) {
         send_message->status = QUERY_UNSUPPORTED;
@@ -1027,40 +1519,49 @@ char* handleBatchQuery(DbOperator* query, message* send_message) {
         return "-- Error finding client context for batch request.";
     }
 
+    BatchOperator batch = query->fields.batch;
+    if (batch.queued.statement != NULL)
+        return queueBatchedStatement(context, query, send_message);
+
     // validate batch request
-    if ((context->queries == NULL && query->fields.batch.start == false) ||
-        (context->queries != NULL && query->fields.batch.start == true)) {
+    if ((context->queries == NULL && batch.start == false) ||
+        (context->queries != NULL && batch.start == true)) {
         send_message->status = EXECUTION_ERROR;
         return "-- Invalid batch request; not in the correct state.";
     }
 
-    if (query->fields.batch.start) {
+    if (batch.start) {
         // start a batch of queries
-        context->queries = malloc(sizeof(BatchedQueries));
-        context->queries->table = NULL;
-        context->queries->column = NULL;
-        context->queries->minimum = NULL;
-        context->queries->maximum = NULL;
-        context->queries->results = NULL;
-        context->queries->num_queries = 0;
-
+        context->queries = calloc(1, sizeof(BatchedQueries));
+        if (context->queries == NULL) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to start batch.";
+        }
         send_message->status = OK_DONE;
         return "-- Successfully processed batch request.";
     } else {
-        // execute a batch of queries
-        return handleBatchSelectQuery(context->queries, send_message);
+        // execute a batch of queries; its statements run like any other,
+        // so the batch is closed first
+        BatchedQueries* queries = context->queries;
+        context->queries = NULL;
+        char* res = executeBatch(queries, send_message);
+        for (size_t i = 0; i < queries->num_statements; i++)
+            free(queries->statements[i].memory);
+        free(queries->statements);
+        free(queries);
+        return res;
     }
 }
 
-void findRangeCBatchHelper(BTreeCNode* node, BatchedQueries* queries) {
+void findRangeCBatchHelper(BTreeCNode* node, ScanGroup* queries) {
     int num_queries = queries->num_queries;
     if (num_queries <= 0)
         return;
     
-    int min_overall = queries->minimum[0];
-    int max_overall = queries->maximum[0];
-    int* minimum = queries->minimum;
-    int* maximum = queries->maximum;
+    long min_overall = queries->minimum[0];
+    long max_overall = queries->maximum[0];
+    long* minimum = queries->minimum;
+    long* maximum = queries->maximum;
     for (int i = 0; i < num_queries; i++) {
         min_overall = min_overall < queries->minimum[i] ? min_overall : queries->minimum[i];
         max_overall = max_overall > queries->maximum[i] ? max_overall : queries->maximum[i];
@@ -1132,15 +1633,15 @@ void findRangeCBatchHelper(BTreeCNode* node, BatchedQueries* queries) {
     }
 }
 
-void findRangeUBatchHelper(BTreeUNode* node, BatchedQueries* queries) {
+void findRangeUBatchHelper(BTreeUNode* node, ScanGroup* queries) {
     int num_queries = queries->num_queries;
     if (num_queries <= 0)
         return;
     
-    int min_overall = queries->minimum[0];
-    int max_overall = queries->maximum[0];
-    int* minimum = queries->minimum;
-    int* maximum = queries->maximum;
+    long min_overall = queries->minimum[0];
+    long max_overall = queries->maximum[0];
+    long* minimum = queries->minimum;
+    long* maximum = queries->maximum;
     for (int i = 0; i < num_queries; i++) {
         min_overall = min_overall < queries->minimum[i] ? min_overall : queries->minimum[i];
         max_overall = max_overall > queries->maximum[i] ? max_overall : queries->maximum[i];
@@ -1212,27 +1713,31 @@ void findRangeUBatchHelper(BTreeUNode* node, BatchedQueries* queries) {
     }
 }
 
-void findRangeSBatchHelper(Column* column, int total, BatchedQueries* queries) {
+// fails if a row of the column can't be read
+bool findRangeSBatchHelper(Column* column, int total, ScanGroup* queries) {
     int num_queries = queries->num_queries;
     if (num_queries <= 0)
-        return;
+        return true;
     
-    int min_overall = queries->minimum[0];
-    int max_overall = queries->maximum[0];
-    int* minimum = queries->minimum;
-    int* maximum = queries->maximum;
+    long min_overall = queries->minimum[0];
+    long max_overall = queries->maximum[0];
+    long* minimum = queries->minimum;
+    long* maximum = queries->maximum;
     for (int i = 0; i < num_queries; i++) {
         min_overall = min_overall < queries->minimum[i] ? min_overall : queries->minimum[i];
         max_overall = max_overall > queries->maximum[i] ? max_overall : queries->maximum[i];
     }
     
     int minIndex, maxIndex;
+    long value;
     // find starting point in data array
     int low = 0;
     int high = total;
     while (low < high) {
         int current = (low + high) / 2;
-        if (column->data[current] < min_overall)
+        if (!readValue(column, current, &value))
+            return false;
+        if (value < min_overall)
             low = current + 1;
         else
             high = current;
@@ -1244,7 +1749,9 @@ void findRangeSBatchHelper(Column* column, int total, BatchedQueries* queries) {
     high = total;
     while (low < high) {
         int current = (low + high) / 2;
-        if (column->data[current] >= max_overall)
+        if (!readValue(column, current, &value))
+            return false;
+        if (value >= max_overall)
             high = current - 1;
         else
             low = current + 1;
@@ -1267,11 +1774,16 @@ void findRangeSBatchHelper(Column* column, int total, BatchedQueries* queries) {
             queries->results[i]->payload = NULL;
         }
     } else {
-        for (int i = minIndex; i <= maxIndex; i++) {
+        for (int i = minIndex; i <= maxIndex && i < total; i++) {
+            if (!readValue(column, i, &value)) {
+                for (int j = 0; j < num_queries; j++)
+                    free(results[j]);
+                return false;
+            }
             // iterate over all queries and insert appropriately
             for (int j = 0; j < num_queries; j++) {
                 // skip if not in the needed range
-                if (column->data[i] < minimum[j] || column->data[i] >= maximum[j])
+                if (value < minimum[j] || value >= maximum[j])
                     continue;
                 // resize if needed
                 if (capacities[j] == num_tuples[j]) {
@@ -1296,10 +1808,11 @@ void findRangeSBatchHelper(Column* column, int total, BatchedQueries* queries) {
         queries->results[i]->data_type = INT;
         queries->results[i]->num_tuples = num_tuples[i];
     }
+    return true;
 }
 
 // need to modify this to batch queries
-char* handleBatchSelectQuery(BatchedQueries* queries, message* send_message) {
+char* handleBatchSelectQuery(ScanGroup* queries, message* send_message) {
     
     Column* column = queries->column;
     Index* index = NULL;
@@ -1319,7 +1832,10 @@ char* handleBatchSelectQuery(BatchedQueries* queries, message* send_message) {
                 break;
             case SORTED:
                 if (index->clustered) {
-                    findRangeSBatchHelper(column, queries->table->num_rows, queries);
+                    if (!findRangeSBatchHelper(column, queries->table->num_rows, queries)) {
+                        send_message->status = EXECUTION_ERROR;
+                        return "-- Unable to read the column.";
+                    }
                 } else {
                     for (int i = 0; i < queries->num_queries; i++) {
                         int* payload;
@@ -1327,8 +1843,8 @@ char* handleBatchSelectQuery(BatchedQueries* queries, message* send_message) {
                             &payload, 
                             index->object->column, 
                             queries->table->num_rows, 
-                            queries->minimum[i],
-                            queries->maximum[i]
+                            clampInt(queries->minimum[i]),
+                            clampInt(queries->maximum[i])
                         );
                         queries->results[i]->payload = (void*) payload;
                     }
@@ -1336,39 +1852,19 @@ char* handleBatchSelectQuery(BatchedQueries* queries, message* send_message) {
                 break;
         }
     } else {
-        struct timeval start, stop;
-        gettimeofday(&start, NULL);
-
-        // scan through column and store all data in tuples
-        int num_tuples[queries->num_queries];
-        int capacities[queries->num_queries];
+        // scan through column once for all queries and store matching positions
+        size_t num_tuples[queries->num_queries];
         int* results[queries->num_queries];
         for (int i = 0; i < queries->num_queries; i++) {
             num_tuples[i] = 0;
-            capacities[i] = 0;
             results[i] = NULL;
         }
 
-        for (size_t i = 0; i < queries->table->num_rows; i++) {
-            // iterate over all queries and insert appropriately
-            for (int j = 0; j < queries->num_queries; j++) {
-                // skip if not in the needed range
-                if (column->data[i] < queries->minimum[j] || column->data[i] >= queries->maximum[j])
-                    continue;
-                // resize if needed
-                if (capacities[j] == num_tuples[j]) {
-                    int new_size = (capacities[j] == 0) ? 1 : 2 * capacities[j];
-                    if (new_size == 1) {
-                        results[j] = malloc(sizeof(int));
-                    } else {
-                        int* new_data = realloc(results[j], sizeof(int) * new_size);
-                        if (new_data != NULL)
-                            results[j] = new_data;
-                    }
-                    capacities[j] = new_size;
-                }
-                results[j][num_tuples[j]++] = column->data[i];
-            }
+        statsTraceAccess("shared scan", -1);
+        if (scanColumnBatch(column, queries->table->num_rows,
+            queries->minimum, queries->maximum, queries->num_queries, results, num_tuples) == false) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Error calculating batch result arrays.";
         }
 
         // store values in Results array
@@ -1376,11 +1872,10 @@ char* handleBatchSelectQuery(BatchedQueries* queries, message* send_message) {
             queries->results[i]->payload = (void*) results[i];
             queries->results[i]->data_type = INT;
             queries->results[i]->num_tuples = num_tuples[i];
+            statsAddRows(OP_BATCH, 0, num_tuples[i]);
         }
-
-        gettimeofday(&stop, NULL);
-        printf("-- Batch select scan query took %lu milliseconds.\n", 
-            1000000 * (stop.tv_sec - start.tv_sec) + stop.tv_usec - start.tv_usec);
+        statsAddRows(OP_BATCH, queries->table->num_rows, 0);
+        statsTracePhase("shared scan");
     }
 
     send_message->status = OK_DONE;
@@ -1407,7 +1902,10 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
     // handle one and two argument cases separately
     if (math.type <= 3) {
         size_t num_tuples;
-        int* payload;
+        DataType type;
+        void* payload;
+        void* copy = NULL;
+        Column* base_column = NULL;
         
         // handle variable vs. database queries separately
         if (math.is_var == true) {
@@ -1423,7 +1921,8 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
                 return "-- Unable to find specified result source.";
             }
             num_tuples = result->num_tuples;
-            payload = (int*) result->payload;
+            type = result->data_type;
+            payload = resultPayload(result, &copy);
         } else {
             // check database
             if (strcmp(math.params[0], current_db->name) != 0) {
@@ -1446,13 +1945,21 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
             }
 
             num_tuples = table->num_rows;
+            type = column->type;
             payload = column->data;
+            base_column = column;
+        }
+
+        if (!isIntegerType(type)) {
+            free(copy);
+            send_message->status = QUERY_UNSUPPORTED;
+            return "-- Unable to aggregate non-integer values.";
         }
 
         // create a new GeneralizedColumnHandle
         GeneralizedColumnHandle new_handle;
         GeneralizedColumnPointer new_pointer;
-        new_pointer.result = malloc(sizeof(Result));
+        new_pointer.result = calloc(1, sizeof(Result));
         new_pointer.result->num_tuples = 1;
         GeneralizedColumn gen_column = {
             .column_type = RESULT,
@@ -1462,60 +1969,21 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
         strcpy(new_handle.name, handle);
 
         // calculate values to store
-        switch (math.type) {
-            case AVG: {
-                double result = 0;
-                for (size_t i = 0; i < num_tuples; i++) {
-                    result += payload[i];
-                }
-                result /= num_tuples;
-                
-                double* toSave = malloc(sizeof(double));
-                toSave[0] = result;
-                new_pointer.result->data_type = DOUBLE;
-                new_pointer.result->payload = (void*) toSave;
-                break;
-            }
-            case SUM: {
-                int result = 0;
-                for (size_t i = 0; i < num_tuples; i++) {
-                    result += payload[i];
-                }
-                int* toSave = malloc(sizeof(double));
-                toSave[0] = result;
-                new_pointer.result->data_type = INT;
-                new_pointer.result->payload = (void*) toSave;
-                break;
-            }
-            case MIN: {
-                int result = payload[0];
-                for (size_t i = 1; i < num_tuples; i++) {
-                    if (payload[i] < result) {
-                        result = payload[i];
-                    }
-                }
-                int* toSave = malloc(sizeof(double));
-                toSave[0] = result;
-                new_pointer.result->data_type = INT;
-                new_pointer.result->payload = (void*) toSave;
-                break;
-            }
-            case MAX: {
-                int result = payload[0];
-                for (size_t i = 1; i < num_tuples; i++) {
-                    if (payload[i] > result) {
-                        result = payload[i];
-                    }
-                }
-                int* toSave = malloc(sizeof(double));
-                toSave[0] = result;
-                new_pointer.result->data_type = INT;
-                new_pointer.result->payload = (void*) toSave;
-                break;
-            }
-            default:
-                break;
+        Aggregates aggregates;
+        int which = (math.type == AVG || math.type == SUM) ? AGG_SUM : AGG_MINMAX;
+        bool success = true;
+        if (base_column != NULL)
+            success = aggregateColumn(base_column, num_tuples, NULL, 0, which, &aggregates);
+        else
+            aggregateValues(type, payload, NULL, num_tuples, which, &aggregates);
+        free(copy);
+        if (!success) {
+            free(new_pointer.result);
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to read the column.";
         }
+        storeAggregate(new_pointer.result, math.type, &aggregates);
+        statsAddRows(OP_MATH, num_tuples, 1);
 
         // search for context and add to the list of variables
         if (checkContextSize(context) != true) {
@@ -1534,8 +2002,12 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
         return "Successfully completed computation in math query.";
     } else {
         size_t num_tuples;
-        int* payload1;
-        int* payload2;
+        DataType type1 = INT;
+        DataType type2 = INT;
+        void* payload1;
+        void* payload2;
+        void* copy1 = NULL;
+        void* copy2 = NULL;
         
         // handle variable vs. database queries separately for first argument
         if (math.is_var == true) {
@@ -1551,7 +2023,8 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
                 return "-- Unable to find specified result source.";
             }
             num_tuples = result->num_tuples;
-            payload1 = (int*) result->payload;
+            type1 = result->data_type;
+            payload1 = resultPayload(result, &copy1);
             
             // handle variable vs. database queries separately for second argument
             if (math.num_params == 2) {
@@ -1566,7 +2039,8 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
                     send_message->status = OBJECT_NOT_FOUND;
                     return "-- Unable to find specified result source.";
                 }
-                payload2 = (int*) result->payload;
+                type2 = result->data_type;
+                payload2 = resultPayload(result, &copy2);
             } else {
                 // check database
                 if (strcmp(math.params[1], current_db->name) != 0) {
@@ -1588,7 +2062,8 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
                     return "-- Unable to find specified column.";
                 }
 
-                payload2 = column->data;
+                type2 = column->type;
+                payload2 = columnPayload(column, num_tuples, &copy2);
             }
         } else {
             // check database
@@ -1612,7 +2087,8 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
             }
 
             num_tuples = table->num_rows;
-            payload1 = column->data;
+            type1 = column->type;
+            payload1 = columnPayload(column, num_tuples, &copy1);
             
             // handle variable vs. database queries separately for second argument
             if (math.num_params == 4) {
@@ -1627,7 +2103,8 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
                     send_message->status = OBJECT_NOT_FOUND;
                     return "-- Unable to find specified result source.";
                 }
-                payload2 = (int*) result->payload;
+                type2 = result->data_type;
+                payload2 = resultPayload(result, &copy2);
             } else {
                 // check database
                 if (strcmp(math.params[3], current_db->name) != 0) {
@@ -1649,33 +2126,45 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
                     return "-- Unable to find specified column.";
                 }
 
-                payload2 = column->data;
+                type2 = column->type;
+                payload2 = columnPayload(column, num_tuples, &copy2);
             }
         }
 
-        int* result = malloc(sizeof(int) * num_tuples);
-        switch (math.type) {
-            case ADD: {
-                for (size_t i = 0; i < num_tuples; i++) {
-                    result[i] = payload1[i] + payload2[i];
-                }
-                break;
-            }
-            case SUB: {
-                for (size_t i = 0; i < num_tuples; i++) {
-                    result[i] = payload1[i] - payload2[i];
-                }
-                break;
-            }
-            default:
-                break;
+        if (!isIntegerType(type1) || !isIntegerType(type2)) {
+            free(copy1);
+            free(copy2);
+            send_message->status = QUERY_UNSUPPORTED;
+            return "-- Unable to combine non-integer values.";
         }
 
+        // mixed widths are widened to longs before being combined
+        DataType type = type1;
+        long* widened1 = NULL;
+        long* widened2 = NULL;
+        if (type1 != type2) {
+            type = LONG;
+            widened1 = malloc(sizeof(long) * (num_tuples + 1));
+            widened2 = malloc(sizeof(long) * (num_tuples + 1));
+            widenValues(type1, payload1, num_tuples, widened1);
+            widenValues(type2, payload2, num_tuples, widened2);
+            payload1 = widened1;
+            payload2 = widened2;
+        }
+        DataType result_type = combinedType(type);
+        void* result = malloc(typeWidth(result_type) * (num_tuples + 1));
+        combineValues(math.type, type, payload1, payload2, num_tuples, result);
+        statsAddRows(OP_MATH, 2 * num_tuples, num_tuples);
+        free(widened1);
+        free(widened2);
+        free(copy1);
+        free(copy2);
+
         // create a new GeneralizedColumnHandle
         GeneralizedColumnHandle new_handle;
         GeneralizedColumnPointer new_pointer;
-        new_pointer.result = malloc(sizeof(Result));
-        new_pointer.result->data_type = INT;
+        new_pointer.result = calloc(1, sizeof(Result));
+        new_pointer.result->data_type = result_type;
         new_pointer.result->num_tuples = num_tuples;
         new_pointer.result->payload = (void*) result;
         GeneralizedColumn gen_column = {
@@ -1703,6 +2192,311 @@ char* handleMathQuery(DbOperator* query, message* send_message) {
     }    
 }
 
+char* handleAggregateQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_AGGREGATE) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    // retrieve params
+    AggregateOperator aggregate = query->fields.aggregate;
+
+    // get context for current client
+    ClientContext* context = searchContext(query->client_fd);
+    if (context == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find context for current client.";
+    }
+
+    size_t num_tuples;
+    DataType type;
+    void* payload;
+    void* copy = NULL;
+    int* positions = NULL;
+    Result* selection = NULL;
+    Column* base_column = NULL;
+
+    // handle variable vs. database queries separately
+    if (aggregate.is_var == true) {
+        // search for result in context
+        GeneralizedColumnHandle* src_handle = findHandle(context, aggregate.params[0]);
+        if (src_handle == NULL || src_handle->generalized_column.column_pointer.result == NULL) {
+            send_message->status = OBJECT_NOT_FOUND;
+            return "-- Unable to find specified result source.";
+        }
+        Result* result = src_handle->generalized_column.column_pointer.result;
+        num_tuples = result->num_tuples;
+        type = result->data_type;
+        payload = resultPayload(result, &copy);
+    } else {
+        // check database
+        if (strcmp(aggregate.params[0], current_db->name) != 0) {
+            send_message->status = OBJECT_NOT_FOUND;
+            return "-- Database not found.";
+        }
+
+        // if we didn't manage to find a table
+        Table* table = findTable(aggregate.params[1]);
+        if (table == NULL) {
+            send_message->status = OBJECT_NOT_FOUND;
+            return "-- Unable to find specified table.";
+        }
+
+        // if we didn't manage to find a column
+        Column* column = findColumn(table, aggregate.params[2]);
+        if (column == NULL) {
+            send_message->status = OBJECT_NOT_FOUND;
+            return "-- Unable to find specified column.";
+        }
+
+        num_tuples = table->num_rows;
+        type = column->type;
+        payload = column->data;
+        base_column = column;
+
+        // aggregate only the selected positions, without fetching them first
+        if (aggregate.selection != NULL) {
+            GeneralizedColumnHandle* src_handle = findHandle(context, aggregate.selection);
+            if (src_handle == NULL || src_handle->generalized_column.column_pointer.result == NULL) {
+                send_message->status = OBJECT_NOT_FOUND;
+                return "-- Unable to find specified select source.";
+            }
+            selection = src_handle->generalized_column.column_pointer.result;
+            num_tuples = selection->num_tuples;
+            positions = (int*) selection->payload;
+        }
+    }
+
+    if (!isIntegerType(type)) {
+        free(copy);
+        send_message->status = QUERY_UNSUPPORTED;
+        return "-- Unable to aggregate non-integer values.";
+    }
+
+    // work out which accumulators the single pass has to maintain
+    int which = 0;
+    for (size_t i = 0; i < aggregate.num_aggregates; i++) {
+        MathType agg = aggregate.types[i];
+        which |= (agg == AVG || agg == SUM) ? AGG_SUM : AGG_MINMAX;
+    }
+    Aggregates aggregates;
+    bool success = true;
+    if (selection != NULL && selection->is_bitmap)
+        success = aggregateColumnBitmap(base_column, selection->payload, selection->bitmap_rows, which, &aggregates);
+    else if (base_column != NULL)
+        success = aggregateColumn(base_column, num_tuples, positions, num_tuples, which, &aggregates);
+    else
+        aggregateValues(type, payload, positions, num_tuples, which, &aggregates);
+    free(copy);
+    if (!success) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to read the column.";
+    }
+    statsAddRows(OP_AGGREGATE, num_tuples, aggregate.num_aggregates);
+
+    // store one handle per requested aggregate
+    for (size_t i = 0; i < aggregate.num_aggregates; i++) {
+        Result* result = calloc(1, sizeof(Result));
+        storeAggregate(result, aggregate.types[i], &aggregates);
+        if (!addResultHandle(context, aggregate.handles[i], result)) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Problem inserting new handle into client context.";
+        }
+    }
+
+    send_message->status = OK_DONE;
+    return "Successfully completed computation in aggregate query.";
+}
+
+char* handleGroupByQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_GROUP_BY) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    // retrieve params
+    GroupByOperator group_by = query->fields.group_by;
+
+    // get context for current client
+    ClientContext* context = searchContext(query->client_fd);
+    if (context == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find context for current client.";
+    }
+
+    // search for keys and values in context
+    GeneralizedColumnHandle* key_handle = findHandle(context, group_by.keys);
+    if (key_handle == NULL || key_handle->generalized_column.column_pointer.result == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified group by keys.";
+    }
+    Result* keys = key_handle->generalized_column.column_pointer.result;
+    size_t num_tuples = keys->num_tuples;
+    Result* values[group_by.num_aggregates];
+    for (size_t i = 0; i < group_by.num_aggregates; i++) {
+        GeneralizedColumnHandle* src_handle = findHandle(context, group_by.values[i]);
+        if (src_handle == NULL || src_handle->generalized_column.column_pointer.result == NULL) {
+            send_message->status = OBJECT_NOT_FOUND;
+            return "-- Unable to find specified group by values.";
+        }
+        values[i] = src_handle->generalized_column.column_pointer.result;
+        if (!isIntegerType(values[i]->data_type)) {
+            send_message->status = QUERY_UNSUPPORTED;
+            return "-- Unable to aggregate non-integer values.";
+        }
+        if (values[i]->num_tuples != num_tuples) {
+            send_message->status = INCORRECT_FORMAT;
+            return "-- Group by keys and values must have the same length.";
+        }
+    }
+    if (!isIntegerType(keys->data_type)) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "-- Unable to group by non-integer keys.";
+    }
+
+    // map every key to a dense group id
+    int* groups = malloc(sizeof(int) * (num_tuples + 1));
+    long* group_keys;
+    void* key_copy;
+    void* key_payload = resultPayload(keys, &key_copy);
+    size_t num_groups = assignGroups(keys->data_type, key_payload, num_tuples, groups, &group_keys);
+    free(key_copy);
+    statsAddRows(OP_GROUP_BY, num_tuples, num_groups);
+
+    Result* key_result = calloc(1, sizeof(Result));
+    key_result->data_type = LONG;
+    key_result->num_tuples = num_groups;
+    key_result->payload = group_keys;
+    if (!addResultHandle(context, group_by.key_handle, key_result)) {
+        free(groups);
+        send_message->status = EXECUTION_ERROR;
+        return "-- Problem inserting new handle into client context.";
+    }
+
+    // accumulate each aggregate into arrays indexed by group id
+    size_t space = num_groups + 1;
+    long* sums = malloc(sizeof(long) * space);
+    long* mins = malloc(sizeof(long) * space);
+    long* maxs = malloc(sizeof(long) * space);
+    size_t* counts = malloc(sizeof(size_t) * space);
+    bool stored = true;
+    for (size_t i = 0; stored && i < group_by.num_aggregates; i++) {
+        MathType type = group_by.types[i];
+        int which = (type == AVG || type == SUM) ? AGG_SUM : AGG_MINMAX;
+        for (size_t j = 0; j < num_groups; j++) {
+            sums[j] = 0;
+            mins[j] = LONG_MAX;
+            maxs[j] = LONG_MIN;
+            counts[j] = 0;
+        }
+        void* copy;
+        void* payload = resultPayload(values[i], &copy);
+        aggregateGroups(values[i]->data_type, payload, groups, num_tuples, which,
+            sums, mins, maxs, counts);
+        free(copy);
+
+        Result* result = calloc(1, sizeof(Result));
+        result->num_tuples = num_groups;
+        if (type == AVG) {
+            double* averages = malloc(sizeof(double) * space);
+            for (size_t j = 0; j < num_groups; j++)
+                averages[j] = (double) sums[j] / counts[j];
+            result->data_type = DOUBLE;
+            result->payload = averages;
+        } else {
+            long* source = (type == SUM) ? sums : (type == MIN) ? mins : maxs;
+            long* aggregates = malloc(sizeof(long) * space);
+            memcpy(aggregates, source, sizeof(long) * num_groups);
+            result->data_type = LONG;
+            result->payload = aggregates;
+        }
+        stored = addResultHandle(context, group_by.handles[i], result);
+    }
+    free(sums);
+    free(mins);
+    free(maxs);
+    free(counts);
+    free(groups);
+
+    if (!stored) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Problem inserting new handle into client context.";
+    }
+    send_message->status = OK_DONE;
+    return "Successfully completed computation in group by query.";
+}
+
+// joins the fetched outer values with the rows of a base column by looking
+// each one up in an index on the column, which only touches the inner rows
+// that match. Returns the message for the client.
+char* handleIndexJoinQuery(ClientContext* context, JoinOperator* join, Result* fetch_r1, Result* select_r1,
+    message* send_message) {
+    if (current_db == NULL || strcmp(join->inner[0], current_db->name) != 0) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Database not found.";
+    }
+    Table* table = findTable(join->inner[1]);
+    if (table == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified table.";
+    }
+    Column* column = findColumn(table, join->inner[2]);
+    if (column == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified column.";
+    }
+    Index* index = chooseJoinIndex(table, column);
+    if (index == NULL) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "-- Unable to join through a column without an index.";
+    }
+    if (!isIntegerType(fetch_r1->data_type)) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "-- Unable to join on non-integer values.";
+    }
+
+    // outer values in order are probed as they are, the rest in sorted
+    // batches
+    bool sorted = valuesAscend(fetch_r1->data_type, fetch_r1->payload, fetch_r1->num_tuples);
+    statsTraceAccess("index nested-loop join", -1);
+    statsTracePhase("resolve");
+    void* copy;
+    int* positions = resultPayload(select_r1, &copy);
+    int* result1;
+    int* result2;
+    size_t count;
+    bool joined = indexJoin(fetch_r1->data_type, fetch_r1->payload, positions, fetch_r1->num_tuples, sorted,
+        table, index, &result1, &result2, &count);
+    free(copy);
+    statsTracePhase("join");
+    if (!joined) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to retrieve all values from join.";
+    }
+
+    Result* join_r1 = calloc(1, sizeof(Result));
+    Result* join_r2 = calloc(1, sizeof(Result));
+    if (join_r1 == NULL || join_r2 == NULL) {
+        free(join_r1);
+        free(join_r2);
+        free(result1);
+        free(result2);
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to retrieve all values from join.";
+    }
+    *join_r1 = (Result) { .data_type = INT, .num_tuples = count, .payload = result1 };
+    *join_r2 = (Result) { .data_type = INT, .num_tuples = count, .payload = result2 };
+    if (!addResultHandle(context, join->handle1, join_r1) || !addResultHandle(context, join->handle2, join_r2)) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Problem inserting new handle into client context.";
+    }
+    // the outer tuples and the inner rows they matched are all that's read
+    statsAddRows(OP_JOIN, fetch_r1->num_tuples + count, count);
+
+    send_message->status = OK_DONE;
+    return "-- Successfully completed join.";
+}
+
 char* handleJoinQuery(DbOperator* query, message* send_message) {
     if (query == NULL || query->type != OP_JOIN) {
         send_message->status = QUERY_UNSUPPORTED;
@@ -1734,16 +2528,6 @@ char* handleJoinQuery(DbOperator* query, message* send_message) {
         send_message->status = OBJECT_NOT_FOUND;
         return "-- Unable to find specified fetch source.";
     }
-    columnHandle = findHandle(context, join.fetch2);
-    if (columnHandle == NULL) {
-        send_message->status = OBJECT_NOT_FOUND;
-        return "-- Unable to find specified fetch source.";
-    }
-    fetch_r2 = columnHandle->generalized_column.column_pointer.result;
-    if (fetch_r2 == NULL) {
-        send_message->status = OBJECT_NOT_FOUND;
-        return "-- Unable to find specified fetch source.";
-    }
     columnHandle = findHandle(context, join.select1);
     if (columnHandle == NULL) {
         send_message->status = OBJECT_NOT_FOUND;
@@ -1754,6 +2538,18 @@ char* handleJoinQuery(DbOperator* query, message* send_message) {
         send_message->status = OBJECT_NOT_FOUND;
         return "-- Unable to find specified select source.";
     }
+    if (join.type == INDEX)
+        return handleIndexJoinQuery(context, &join, fetch_r1, select_r1, send_message);
+    columnHandle = findHandle(context, join.fetch2);
+    if (columnHandle == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified fetch source.";
+    }
+    fetch_r2 = columnHandle->generalized_column.column_pointer.result;
+    if (fetch_r2 == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified fetch source.";
+    }
     columnHandle = findHandle(context, join.select2);
     if (columnHandle == NULL) {
         send_message->status = OBJECT_NOT_FOUND;
@@ -1768,7 +2564,7 @@ char* handleJoinQuery(DbOperator* query, message* send_message) {
     // create two new Result objects in context// create a new GeneralizedColumnHandle
     GeneralizedColumnHandle join_r1;
     GeneralizedColumnPointer join_r1p;
-    join_r1p.result = malloc(sizeof(Result));
+    join_r1p.result = calloc(1, sizeof(Result));
     join_r1p.result->data_type = INT;
     join_r1p.result->num_tuples = 0;
     join_r1p.result->payload = NULL;
@@ -1780,7 +2576,7 @@ char* handleJoinQuery(DbOperator* query, message* send_message) {
     strcpy(join_r1.name, join.handle1);
     GeneralizedColumnHandle join_r2;
     GeneralizedColumnPointer join_r2p;
-    join_r2p.result = malloc(sizeof(Result));
+    join_r2p.result = calloc(1, sizeof(Result));
     join_r2p.result->data_type = INT;
     join_r2p.result->num_tuples = 0;
     join_r2p.result->payload = NULL;
@@ -1814,60 +2610,44 @@ char* handleJoinQuery(DbOperator* query, message* send_message) {
     else
         context->chandle_table[dupIndex] = join_r2;
 
-    // holds results from hashtable searches
-    size_t size = 1024;
-    int intermediate[size];
-    int* result1 = NULL;
-    int* result2 = NULL;
-    int count = 0;
-    int capacity = 0;
-
-    // initialize hashtable
-    HashTable* ht;
-    init(&ht);
-    
-    // values and indexes
-    int* values1 = (int*) fetch_r1->payload;
-    int* indexes1 = (int*) select_r1->payload;
-    int* values2 = (int*) fetch_r2->payload;
-    int* indexes2 = (int*) select_r2->payload;
-    
-    // insert all values from the first set into the hashtable
-    for (size_t i = 0; i < fetch_r1->num_tuples; i++)
-        put(ht, values1[i], indexes1[i]);
-
-    // compare against the second array
-    for (size_t i = 0; i < fetch_r2->num_tuples; i++) {
-        int found = get(ht, values2[i], intermediate, size);
-        if (found <= 0)
-            continue;
-        if (result1 == NULL || result2 == NULL) {
-            result1 = malloc(sizeof(int) * size);
-            result2 = malloc(sizeof(int) * size);
-            capacity = size;
-        }
-        if (count + found > capacity) {
-            int* new_res1 = realloc(result1, sizeof(int) * (capacity + size));
-            if (new_res1 != NULL) {
-                result1 = new_res1;
-            } else {
-                send_message->status = EXECUTION_ERROR;
-                return "-- Unable to retrieve all values from join.";
-            }
-            int* new_res2 = realloc(result2, sizeof(int) * (capacity + size));
-            if (new_res2 != NULL) {
-                result2 = new_res2;
-            } else {
-                send_message->status = EXECUTION_ERROR;
-                return "-- Unable to retrieve all values from join.";
-            }
-            capacity += size;
-        }
-        for (int j = count; j < count + found; j++) {
-            result1[j] = intermediate[j - count];
-            result2[j] = indexes2[i];
-        }
-        count += found;
+    if (!isIntegerType(fetch_r1->data_type) || !isIntegerType(fetch_r2->data_type)) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "-- Unable to join on non-integer values.";
+    }
+
+    // inputs already in order, like values fetched through a clustered
+    // index, are merged in one pass rather than hashed
+    bool sorted1 = valuesAscend(fetch_r1->data_type, fetch_r1->payload, fetch_r1->num_tuples);
+    bool sorted2 = valuesAscend(fetch_r2->data_type, fetch_r2->payload, fetch_r2->num_tuples);
+    bool merge = join.type == MERGE || (sorted1 && sorted2);
+    bool spills = !merge && hashJoinSpills(fetch_r1->num_tuples, fetch_r2->num_tuples);
+    if (merge)
+        statsTraceAccess(sorted1 && sorted2 ? "merge join" : "sort-merge join", -1);
+    else
+        statsTraceAccess(spills ? "grace hash join" : "hash join", -1);
+    statsTracePhase("resolve");
+    void* copy1;
+    void* copy2;
+    int* positions1 = resultPayload(select_r1, &copy1);
+    int* positions2 = resultPayload(select_r2, &copy2);
+
+    // otherwise partition both sides and join the partitions on all cores,
+    // or through temporary files when they won't fit in memory
+    int* result1;
+    int* result2;
+    size_t count;
+    bool joined = merge ?
+        mergeJoin(fetch_r1->data_type, fetch_r1->payload, positions1, fetch_r1->num_tuples, sorted1,
+            fetch_r2->data_type, fetch_r2->payload, positions2, fetch_r2->num_tuples, sorted2,
+            &result1, &result2, &count) :
+        hashJoin(fetch_r1->data_type, fetch_r1->payload, positions1, fetch_r1->num_tuples,
+            fetch_r2->data_type, fetch_r2->payload, positions2, fetch_r2->num_tuples, &result1, &result2, &count);
+    free(copy1);
+    free(copy2);
+    statsTracePhase("join");
+    if (!joined) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to retrieve all values from join.";
     }
 
     // save results
@@ -1875,7 +2655,300 @@ char* handleJoinQuery(DbOperator* query, message* send_message) {
     join_r1p.result->num_tuples = count;
     join_r2p.result->payload = (void*) result2;
     join_r2p.result->num_tuples = count;
+    statsAddRows(OP_JOIN, fetch_r1->num_tuples + fetch_r2->num_tuples, count);
 
     send_message->status = OK_DONE;
     return "-- Successfully completed join.";
 }
+
+char* handlePrepareQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_PREPARE) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    // retrieve params
+    PrepareOperator prepare = query->fields.prepare;
+    DbOperator* statement = prepare.statement;
+
+    // get context for current client
+    char* error = NULL;
+    ClientContext* context = searchContext(query->client_fd);
+    if (context == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        error = "-- Unable to find context for current client.";
+    } else if (strlen(prepare.name) > HANDLE_MAX_SIZE) {
+        send_message->status = INCORRECT_FORMAT;
+        error = "-- Statement name is too long.";
+    } else if (statement->type != OP_SELECT) {
+        // only selects take arguments so far
+        send_message->status = QUERY_UNSUPPORTED;
+        error = "-- Only select statements can be prepared.";
+    } else if (!statement->fields.select.src_is_var) {
+        // resolve the catalog objects once; execute looks them up again
+        // only if they may have been freed since
+        error = resolveSelectColumn(&statement->fields.select, send_message);
+    }
+    if (error != NULL) {
+        free(prepare.memory);
+        return error;
+    }
+
+    PreparedStatement prepared;
+    strcpy(prepared.name, prepare.name);
+    prepared.query = statement;
+    prepared.memory = prepare.memory;
+    prepared.num_params = 0;
+
+    // note which fields the arguments of execute() go to
+    SelectOperator* select = &statement->fields.select;
+    if (select->bind_minimum)
+        prepared.params[prepared.num_params++] = &select->minimum;
+    if (select->bind_maximum)
+        prepared.params[prepared.num_params++] = &select->maximum;
+    for (size_t i = 0; i < select->num_conjuncts; i++) {
+        SelectPredicate* conjunct = &select->conjuncts[i];
+        if ((size_t) (conjunct->bind_minimum + conjunct->bind_maximum) > MAX_STATEMENT_PARAMS - prepared.num_params) {
+            free(prepare.memory);
+            send_message->status = INCORRECT_FORMAT;
+            return "-- Too many placeholders in statement.";
+        }
+        if (conjunct->bind_minimum)
+            prepared.params[prepared.num_params++] = &conjunct->minimum;
+        if (conjunct->bind_maximum)
+            prepared.params[prepared.num_params++] = &conjunct->maximum;
+    }
+
+    if (!addStatement(context, &prepared)) {
+        free(prepare.memory);
+        send_message->status = EXECUTION_ERROR;
+        return "-- Problem storing prepared statement.";
+    }
+
+    send_message->status = OK_DONE;
+    return "Successfully prepared statement.";
+}
+
+char* handleExecuteQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_EXECUTE) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    // retrieve params
+    ExecuteOperator execute = query->fields.execute;
+
+    // get context for current client
+    ClientContext* context = searchContext(query->client_fd);
+    if (context == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find context for current client.";
+    }
+
+    PreparedStatement* prepared = findStatement(context, execute.name);
+    if (prepared == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified prepared statement.";
+    }
+    if (execute.num_args != prepared->num_params) {
+        send_message->status = INCORRECT_FORMAT;
+        return "-- Wrong number of arguments for prepared statement.";
+    }
+
+    // the resolved columns are stale once the catalog changed
+    DbOperator* statement = prepared->query;
+    if (!statement->fields.select.src_is_var) {
+        char* error = resolveSelectColumn(&statement->fields.select, send_message);
+        if (error != NULL)
+            return error;
+    }
+
+    // bind the arguments and run a copy of the statement
+    for (size_t i = 0; i < execute.num_args; i++)
+        *prepared->params[i] = execute.args[i];
+    DbOperator bound = *prepared->query;
+    bound.client_fd = query->client_fd;
+    bound.context = query->context;
+    return executeDbOperator(&bound, send_message);
+}
+
+char* handleStatsQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_STATS) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    char* path = query->fields.stats.path;
+    if (path != NULL) {
+        if (!statsDump(path)) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to write stats file.";
+        }
+        send_message->status = OK_DONE;
+        return "Successfully wrote stats file.";
+    }
+
+    send_message->status = OK_WAIT_FOR_RESPONSE;
+    return (char*) statsReport();
+}
+
+// the report of the last explain(), grown as needed
+static char* explanation = NULL;
+static size_t explanation_size = 0;
+
+char* handleExplainQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_EXPLAIN) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    DbOperator* statement = query->fields.explain.statement;
+    if (statement->type == OP_EXPLAIN) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "-- Unable to explain an explain.";
+    }
+    statement->client_fd = query->client_fd;
+    statement->context = query->context;
+
+    // run the statement once, collecting what its operator reports
+    StatsTrace trace;
+    statsTraceStart(&trace);
+    uint64_t start = statsNow();
+    char* res = executeDbOperator(statement, send_message);
+    uint64_t elapsed = statsNow() - start;
+    statsTraceStop();
+    message_status status = send_message->status;
+
+    // room for the plan, plus the statement's own output or error
+    size_t size = 1024 + MAX_TRACE_PHASES * (HANDLE_MAX_SIZE + 32) + strlen(res);
+    if (size > explanation_size) {
+        char* new_explanation = realloc(explanation, size);
+        if (new_explanation == NULL) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to allocate explanation.";
+        }
+        explanation = new_explanation;
+        explanation_size = size;
+    }
+    size_t length = 0;
+    length += sprintf(explanation + length, "operator: %s\n", statsOperatorName(statement->type));
+    length += sprintf(explanation + length, "access path: %s\n",
+        trace.access_path != NULL ? trace.access_path : "-");
+    if (trace.estimated_rows >= 0)
+        length += sprintf(explanation + length, "estimated rows: %ld\n", trace.estimated_rows);
+    else
+        length += sprintf(explanation + length, "estimated rows: -\n");
+    length += sprintf(explanation + length, "rows scanned: %zu\n", trace.rows_scanned);
+    length += sprintf(explanation + length, "rows produced: %zu\n", trace.rows_produced);
+    if (!query->fields.explain.plan_only) {
+        length += sprintf(explanation + length, "parse: %.1f us\n", query->fields.explain.parse_ns / 1000.0);
+        for (size_t i = 0; i < trace.num_phases; i++)
+            length += sprintf(explanation + length, "  %s: %.1f us\n", trace.phase_names[i], trace.phase_ns[i] / 1000.0);
+        length += sprintf(explanation + length, "execute: %.1f us\n", elapsed / 1000.0);
+    }
+    if (status == OK_WAIT_FOR_RESPONSE)
+        sprintf(explanation + length, "output:\n%s", res);
+    else if (status != OK_DONE)
+        sprintf(explanation + length, "error: %s\n", res);
+
+    send_message->status = OK_WAIT_FOR_RESPONSE;
+    return explanation;
+}
+
+// the report of the last analyze(), grown as needed
+static char* analysis = NULL;
+static size_t analysis_size = 0;
+
+char* handleAnalyzeQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_ANALYZE) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    AnalyzeOperator analyze = query->fields.analyze;
+    if (current_db == NULL || strcmp(current_db->name, analyze.db_name) != 0) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified database.";
+    }
+    Table* table = findTable(analyze.tbl_name);
+    if (table == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified table.";
+    }
+    if (!analyzeTable(table)) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Unable to analyze table.";
+    }
+    statsAddRows(OP_ANALYZE, table->num_rows * table->col_count, 0);
+
+    // one line per column with what the planner now knows about it
+    size_t size = table->col_count * (MAX_SIZE_NAME + 128) + 1;
+    if (size > analysis_size) {
+        char* new_analysis = realloc(analysis, size);
+        if (new_analysis == NULL) {
+            send_message->status = EXECUTION_ERROR;
+            return "-- Unable to allocate analysis.";
+        }
+        analysis = new_analysis;
+        analysis_size = size;
+    }
+    size_t length = 0;
+    analysis[0] = '\0';
+    for (size_t i = 0; i < table->col_count; i++) {
+        ColumnStats* stats = table->columns[i]->stats;
+        length += sprintf(analysis + length, "%s: rows %zu, min %ld, max %ld, distinct %zu\n",
+            table->columns[i]->name, stats->num_rows, stats->min, stats->max, estimateDistinct(stats));
+    }
+
+    send_message->status = OK_WAIT_FOR_RESPONSE;
+    return analysis;
+}
+
+char* handleCombineQuery(DbOperator* query, message* send_message) {
+    if (query == NULL || query->type != OP_COMBINE) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "Invalid query.";
+    }
+
+    // retrieve params
+    CombineOperator combine = query->fields.combine;
+
+    // get context for current client
+    ClientContext* context = searchContext(query->client_fd);
+    if (context == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find context for current client.";
+    }
+
+    // search for both selections in context
+    GeneralizedColumnHandle* left_handle = findHandle(context, combine.left);
+    GeneralizedColumnHandle* right_handle = findHandle(context, combine.right);
+    if (left_handle == NULL || left_handle->generalized_column.column_pointer.result == NULL ||
+        right_handle == NULL || right_handle->generalized_column.column_pointer.result == NULL) {
+        send_message->status = OBJECT_NOT_FOUND;
+        return "-- Unable to find specified select source.";
+    }
+    Result* left = left_handle->generalized_column.column_pointer.result;
+    Result* right = right_handle->generalized_column.column_pointer.result;
+    if (left->data_type != INT || right->data_type != INT) {
+        send_message->status = QUERY_UNSUPPORTED;
+        return "-- Unable to combine results that aren't selections.";
+    }
+
+    // both are laid over bitmaps of the rows and merged a word at a time
+    statsTraceAccess("bitmap merge", -1);
+    Result* result = combineSelections(left, right, combine.conjunctive);
+    if (result == NULL) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Error combining selections.";
+    }
+    statsAddRows(OP_COMBINE, left->num_tuples + right->num_tuples, result->num_tuples);
+    statsTracePhase("merge");
+    if (!addResultHandle(context, combine.handle, result)) {
+        send_message->status = EXECUTION_ERROR;
+        return "-- Problem inserting new handle into client context.";
+    }
+
+    send_message->status = OK_DONE;
+    return "Successfully combined selections.";
+}
@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "query/grouping.h"
+#include "query/kernels.h"
+
+// Fibonacci hashing; spreads clustered keys over the whole table
+static size_t hashKey(long key, int shift) {
+    return (size_t) (((uint64_t) key * 0x9E3779B97F4A7C15ULL) >> shift);
+}
+
+static size_t assignDirect(const long* keys, size_t num_tuples, long minimum, size_t range,
+    int* groups, long* group_keys) {
+    int* slots = malloc(sizeof(int) * range);
+    memset(slots, -1, sizeof(int) * range);
+    size_t num_groups = 0;
+    for (size_t i = 0; i < num_tuples; i++) {
+        size_t slot = (size_t) (keys[i] - minimum);
+        if (slots[slot] < 0) {
+            slots[slot] = num_groups;
+            group_keys[num_groups++] = keys[i];
+        }
+        groups[i] = slots[slot];
+    }
+    free(slots);
+    return num_groups;
+}
+
+static size_t assignHashed(const long* keys, size_t num_tuples, int* groups, long* group_keys) {
+    // at most half full, so probe sequences stay short
+    int bits = 1;
+    while (((size_t) 1 << bits) < 2 * num_tuples)
+        bits++;
+    size_t capacity = (size_t) 1 << bits;
+    size_t mask = capacity - 1;
+    int shift = 64 - bits;
+
+    long* table_keys = malloc(sizeof(long) * capacity);
+    int* table_groups = malloc(sizeof(int) * capacity);
+    memset(table_groups, -1, sizeof(int) * capacity);
+
+    size_t num_groups = 0;
+    for (size_t i = 0; i < num_tuples; i++) {
+        size_t slot = hashKey(keys[i], shift);
+        while (table_groups[slot] >= 0 && table_keys[slot] != keys[i])
+            slot = (slot + 1) & mask;
+        if (table_groups[slot] < 0) {
+            table_keys[slot] = keys[i];
+            table_groups[slot] = num_groups;
+            group_keys[num_groups++] = keys[i];
+        }
+        groups[i] = table_groups[slot];
+    }
+    free(table_keys);
+    free(table_groups);
+    return num_groups;
+}
+
+size_t assignGroups(DataType type, const void* keys, size_t num_tuples, int* groups, long** group_keys) {
+    *group_keys = malloc(sizeof(long) * (num_tuples + 1));
+    if (num_tuples == 0)
+        return 0;
+
+    // work on widened keys so the tables only deal with one key type
+    long* wide = malloc(sizeof(long) * num_tuples);
+    widenValues(type, keys, num_tuples, wide);
+
+    Aggregates bounds;
+    aggregateValues(LONG, wide, NULL, num_tuples, AGG_MINMAX, &bounds);
+    unsigned long range = (unsigned long) bounds.max - (unsigned long) bounds.min;
+
+    size_t num_groups;
+    if (range < DIRECT_GROUP_LIMIT)
+        num_groups = assignDirect(wide, num_tuples, bounds.min, range + 1, groups, *group_keys);
+    else
+        num_groups = assignHashed(wide, num_tuples, groups, *group_keys);
+    free(wide);
+
+    long* shrunk = realloc(*group_keys, sizeof(long) * num_groups);
+    if (shrunk != NULL)
+        *group_keys = shrunk;
+    return num_groups;
+}
@@ -0,0 +1,522 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "api/column.h"
+#include "query/hashjoin.h"
+#include "query/kernels.h"
+
+/*
+==========================================
+=========== PARALLEL HASH JOIN ===========
+==========================================
+*/
+
+// one input of the join and its partitioned copy, where partition p holds
+// entries [starts[p], starts[p + 1])
+typedef struct JoinSide {
+    DataType type;
+    const void* values;
+    const int* positions;
+    size_t num_tuples;
+    size_t first_morsel;
+    long* keys;
+    int* rows;
+    size_t starts[JOIN_PARTITIONS + 1];
+} JoinSide;
+
+// the matches found in one partition
+typedef struct JoinOutput {
+    int* rows1;
+    int* rows2;
+    size_t count;
+    size_t capacity;
+    size_t offset;
+} JoinOutput;
+
+typedef struct HashJoin {
+    JoinSide sides[2];
+    size_t num_morsels;
+    // per morsel and partition: entries counted, then where the next one goes
+    size_t* histograms;
+    JoinOutput outputs[JOIN_PARTITIONS];
+    int* result1;
+    int* result2;
+    // next morsel or partition of the running phase
+    size_t next;
+    bool failed;
+    int num_threads;
+} HashJoin;
+
+// multiplicative hashing; the xor folds the well-mixed high bits into the
+// low ones used for buckets without touching the ones picking partitions
+static inline uint64_t hashKey(long key) {
+    uint64_t hash = (uint64_t) key * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 29);
+}
+
+static inline size_t partitionOf(uint64_t hash) {
+    return hash >> (64 - JOIN_PARTITION_BITS);
+}
+
+static bool claim(HashJoin* join, size_t limit, size_t* item) {
+    *item = __atomic_fetch_add(&join->next, 1, __ATOMIC_RELAXED);
+    return *item < limit;
+}
+
+// runs phase on every thread of the team, the calling one included
+static void runPhase(HashJoin* join, void* (*phase)(void*)) {
+    join->next = 0;
+    pthread_t threads[JOIN_MAX_THREADS];
+    int started = 0;
+    for (int i = 1; i < join->num_threads; i++)
+        if (pthread_create(&threads[started], NULL, phase, join) == 0)
+            started++;
+    phase(join);
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+}
+
+// widens the keys of a morsel into keys; returns its side
+static JoinSide* readMorsel(HashJoin* join, size_t morsel, long* keys, size_t* from, size_t* to) {
+    JoinSide* side = &join->sides[morsel >= join->sides[1].first_morsel];
+    *from = (morsel - side->first_morsel) * JOIN_MORSEL_ROWS;
+    *to = (*from + JOIN_MORSEL_ROWS < side->num_tuples) ? *from + JOIN_MORSEL_ROWS : side->num_tuples;
+    widenValues(side->type, (const char*) side->values + *from * typeWidth(side->type), *to - *from, keys);
+    return side;
+}
+
+static void* countPartitions(void* arg) {
+    HashJoin* join = arg;
+    long* keys = malloc(sizeof(long) * JOIN_MORSEL_ROWS);
+    if (keys == NULL) {
+        __atomic_store_n(&join->failed, true, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    size_t morsel;
+    while (claim(join, join->num_morsels, &morsel)) {
+        size_t from, to;
+        readMorsel(join, morsel, keys, &from, &to);
+        size_t* histogram = join->histograms + morsel * JOIN_PARTITIONS;
+        for (size_t i = 0; i < to - from; i++)
+            histogram[partitionOf(hashKey(keys[i]))]++;
+    }
+    free(keys);
+    return NULL;
+}
+
+static void* scatterPartitions(void* arg) {
+    HashJoin* join = arg;
+    long* keys = malloc(sizeof(long) * JOIN_MORSEL_ROWS);
+    if (keys == NULL) {
+        __atomic_store_n(&join->failed, true, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    size_t morsel;
+    while (claim(join, join->num_morsels, &morsel)) {
+        size_t from, to;
+        JoinSide* side = readMorsel(join, morsel, keys, &from, &to);
+        size_t* offsets = join->histograms + morsel * JOIN_PARTITIONS;
+        for (size_t i = 0; i < to - from; i++) {
+            size_t entry = offsets[partitionOf(hashKey(keys[i]))]++;
+            side->keys[entry] = keys[i];
+            side->rows[entry] = side->positions[from + i];
+        }
+    }
+    free(keys);
+    return NULL;
+}
+
+static bool appendMatch(JoinOutput* output, int row1, int row2) {
+    if (output->count == output->capacity) {
+        size_t capacity = (output->capacity == 0) ? 1024 : 2 * output->capacity;
+        int* rows1 = realloc(output->rows1, sizeof(int) * capacity);
+        if (rows1 == NULL)
+            return false;
+        output->rows1 = rows1;
+        int* rows2 = realloc(output->rows2, sizeof(int) * capacity);
+        if (rows2 == NULL)
+            return false;
+        output->rows2 = rows2;
+        output->capacity = capacity;
+    }
+    output->rows1[output->count] = row1;
+    output->rows2[output->count++] = row2;
+    return true;
+}
+
+// a hashtable over a set of build entries; chains link entries by index,
+// 0 ending them
+typedef struct ChainedTable {
+    const long* keys;
+    const int* rows;
+    int* heads;
+    int* next;
+    size_t mask;
+} ChainedTable;
+
+static bool buildChained(ChainedTable* table, const long* keys, const int* rows, size_t num_entries) {
+    size_t num_buckets = 16;
+    while (num_buckets < 2 * num_entries)
+        num_buckets *= 2;
+    table->keys = keys;
+    table->rows = rows;
+    table->mask = num_buckets - 1;
+    table->heads = calloc(num_buckets, sizeof(int));
+    table->next = malloc(sizeof(int) * (num_entries + 1));
+    if (table->heads == NULL || table->next == NULL)
+        return false;
+    for (size_t i = 0; i < num_entries; i++) {
+        size_t bucket = hashKey(keys[i]) & table->mask;
+        table->next[i] = table->heads[bucket];
+        table->heads[bucket] = (int) i + 1;
+    }
+    return true;
+}
+
+// appends a match for every probe entry and build entry with equal keys;
+// swapped puts the probe's rows first
+static bool probeChained(ChainedTable* table, const long* keys, const int* rows, size_t num_entries,
+    bool swapped, JoinOutput* output) {
+    for (size_t i = 0; i < num_entries; i++) {
+        long key = keys[i];
+        for (int entry = table->heads[hashKey(key) & table->mask]; entry != 0; entry = table->next[entry - 1]) {
+            if (table->keys[entry - 1] != key)
+                continue;
+            int build_row = table->rows[entry - 1];
+            if (!appendMatch(output, swapped ? rows[i] : build_row, swapped ? build_row : rows[i]))
+                return false;
+        }
+    }
+    return true;
+}
+
+static void freeChained(ChainedTable* table) {
+    free(table->heads);
+    free(table->next);
+}
+
+// joins the first side's partition with the second side's
+static bool joinPartition(HashJoin* join, size_t partition) {
+    JoinSide* build = &join->sides[0];
+    JoinSide* probe = &join->sides[1];
+    size_t build_from = build->starts[partition];
+    size_t num_build = build->starts[partition + 1] - build_from;
+    size_t probe_from = probe->starts[partition];
+    size_t num_probe = probe->starts[partition + 1] - probe_from;
+    if (num_build == 0 || num_probe == 0)
+        return true;
+
+    ChainedTable table;
+    bool success = buildChained(&table, build->keys + build_from, build->rows + build_from, num_build) &&
+        probeChained(&table, probe->keys + probe_from, probe->rows + probe_from, num_probe, false,
+            &join->outputs[partition]);
+    freeChained(&table);
+    return success;
+}
+
+static void* joinPartitions(void* arg) {
+    HashJoin* join = arg;
+    size_t partition;
+    while (claim(join, JOIN_PARTITIONS, &partition))
+        if (!joinPartition(join, partition))
+            __atomic_store_n(&join->failed, true, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void* gatherPartitions(void* arg) {
+    HashJoin* join = arg;
+    size_t partition;
+    while (claim(join, JOIN_PARTITIONS, &partition)) {
+        JoinOutput* output = &join->outputs[partition];
+        memcpy(join->result1 + output->offset, output->rows1, sizeof(int) * output->count);
+        memcpy(join->result2 + output->offset, output->rows2, sizeof(int) * output->count);
+    }
+    return NULL;
+}
+
+// turns the per-morsel counts of a side into the offsets its morsels
+// write each partition from
+static void placePartitions(HashJoin* join, JoinSide* side, size_t num_morsels) {
+    size_t offset = 0;
+    for (size_t p = 0; p < JOIN_PARTITIONS; p++) {
+        side->starts[p] = offset;
+        for (size_t m = side->first_morsel; m < side->first_morsel + num_morsels; m++) {
+            size_t* slot = &join->histograms[m * JOIN_PARTITIONS + p];
+            size_t count = *slot;
+            *slot = offset;
+            offset += count;
+        }
+    }
+    side->starts[JOIN_PARTITIONS] = offset;
+}
+
+static void freeHashJoin(HashJoin* join) {
+    for (int i = 0; i < 2; i++) {
+        free(join->sides[i].keys);
+        free(join->sides[i].rows);
+    }
+    for (size_t p = 0; p < JOIN_PARTITIONS; p++) {
+        free(join->outputs[p].rows1);
+        free(join->outputs[p].rows2);
+    }
+    free(join->histograms);
+    free(join);
+}
+
+/*
+==========================================
+============ GRACE HASH JOIN =============
+==========================================
+*/
+
+typedef struct SpillRecord {
+    long key;
+    int row;
+} SpillRecord;
+
+// the records of one partition of a side, in a temporary file
+typedef struct SpillRun {
+    FILE* file;
+    size_t count;
+} SpillRun;
+
+// records read from a run at a time
+#define SPILL_READ_RECORDS 1024
+
+// every level partitions on the next bits of the hash, from the top
+static size_t spillPartition(long key, int depth) {
+    return (hashKey(key) >> (64 - JOIN_PARTITION_BITS * (depth + 1))) & (JOIN_PARTITIONS - 1);
+}
+
+static bool openRuns(SpillRun* runs) {
+    memset(runs, 0, sizeof(SpillRun) * JOIN_PARTITIONS);
+    for (size_t p = 0; p < JOIN_PARTITIONS; p++)
+        if ((runs[p].file = tmpfile()) == NULL)
+            return false;
+    return true;
+}
+
+// closing a temporary file deletes it
+static void closeRuns(SpillRun* runs) {
+    for (size_t p = 0; p < JOIN_PARTITIONS; p++)
+        if (runs[p].file != NULL)
+            fclose(runs[p].file);
+}
+
+static bool spillRecord(SpillRun* runs, long key, int row, int depth) {
+    SpillRun* run = &runs[spillPartition(key, depth)];
+    SpillRecord record = { .key = key, .row = row };
+    run->count++;
+    return fwrite(&record, sizeof(SpillRecord), 1, run->file) == 1;
+}
+
+// partitions an input held in memory
+static bool spillValues(DataType type, const void* values, const int* positions, size_t num_tuples, SpillRun* runs) {
+    long* keys = malloc(sizeof(long) * JOIN_MORSEL_ROWS);
+    if (keys == NULL)
+        return false;
+    bool success = true;
+    for (size_t from = 0; success && from < num_tuples; from += JOIN_MORSEL_ROWS) {
+        size_t count = (num_tuples - from < JOIN_MORSEL_ROWS) ? num_tuples - from : JOIN_MORSEL_ROWS;
+        widenValues(type, (const char*) values + from * typeWidth(type), count, keys);
+        for (size_t i = 0; success && i < count; i++)
+            success = spillRecord(runs, keys[i], positions[from + i], 0);
+    }
+    free(keys);
+    return success;
+}
+
+// reads the next records of a run, up to max of them, into keys and rows;
+// returns how many were read
+static size_t readRun(SpillRun* run, long* keys, int* rows, size_t max) {
+    SpillRecord records[SPILL_READ_RECORDS];
+    size_t total = 0;
+    while (total < max) {
+        size_t wanted = (max - total < SPILL_READ_RECORDS) ? max - total : SPILL_READ_RECORDS;
+        size_t count = fread(records, sizeof(SpillRecord), wanted, run->file);
+        for (size_t i = 0; i < count; i++) {
+            keys[total + i] = records[i].key;
+            rows[total + i] = records[i].row;
+        }
+        total += count;
+        if (count < wanted)
+            break;
+    }
+    return total;
+}
+
+// partitions a run on the bits of the given level
+static bool splitRun(SpillRun* run, SpillRun* runs, int depth) {
+    long keys[SPILL_READ_RECORDS];
+    int rows[SPILL_READ_RECORDS];
+    rewind(run->file);
+    size_t left = run->count;
+    while (left > 0) {
+        size_t count = readRun(run, keys, rows, left < SPILL_READ_RECORDS ? left : SPILL_READ_RECORDS);
+        if (count == 0)
+            return false;
+        for (size_t i = 0; i < count; i++)
+            if (!spillRecord(runs, keys[i], rows[i], depth))
+                return false;
+        left -= count;
+    }
+    return true;
+}
+
+static bool joinRuns(SpillRun* build, SpillRun* probe, bool swapped, int depth, JoinOutput* output) {
+    if (build->count == 0 || probe->count == 0)
+        return true;
+
+    // split a build side that doesn't fit, and its probe side with it
+    if (build->count * JOIN_TUPLE_BYTES > JOIN_MEMORY_BYTES && depth < GRACE_MAX_DEPTH) {
+        SpillRun build_runs[JOIN_PARTITIONS];
+        SpillRun probe_runs[JOIN_PARTITIONS];
+        bool success = openRuns(build_runs) && openRuns(probe_runs) &&
+            splitRun(build, build_runs, depth) && splitRun(probe, probe_runs, depth);
+        for (size_t p = 0; success && p < JOIN_PARTITIONS; p++)
+            success = joinRuns(&build_runs[p], &probe_runs[p], swapped, depth + 1, output);
+        closeRuns(build_runs);
+        closeRuns(probe_runs);
+        return success;
+    }
+
+    // otherwise build a table over it and stream the probe side past it
+    long* keys = malloc(sizeof(long) * build->count);
+    int* rows = malloc(sizeof(int) * build->count);
+    ChainedTable table = { .heads = NULL, .next = NULL };
+    rewind(build->file);
+    rewind(probe->file);
+    bool success = keys != NULL && rows != NULL &&
+        readRun(build, keys, rows, build->count) == build->count &&
+        buildChained(&table, keys, rows, build->count);
+    long probe_keys[SPILL_READ_RECORDS];
+    int probe_rows[SPILL_READ_RECORDS];
+    for (size_t left = probe->count; success && left > 0;) {
+        size_t count = readRun(probe, probe_keys, probe_rows, left < SPILL_READ_RECORDS ? left : SPILL_READ_RECORDS);
+        success = count > 0 && probeChained(&table, probe_keys, probe_rows, count, swapped, output);
+        left -= count;
+    }
+    freeChained(&table);
+    free(keys);
+    free(rows);
+    return success;
+}
+
+// builds on the smaller side, whose rows then have to be swapped back
+static bool graceJoin(DataType type1, const void* values1, const int* positions1, size_t num_tuples1,
+    DataType type2, const void* values2, const int* positions2, size_t num_tuples2,
+    int** result1, int** result2, size_t* count) {
+    bool swapped = num_tuples2 < num_tuples1;
+    SpillRun runs1[JOIN_PARTITIONS];
+    SpillRun runs2[JOIN_PARTITIONS];
+    JoinOutput output = { .rows1 = NULL, .rows2 = NULL, .count = 0, .capacity = 0 };
+    bool success = openRuns(runs1) && openRuns(runs2) &&
+        spillValues(type1, values1, positions1, num_tuples1, runs1) &&
+        spillValues(type2, values2, positions2, num_tuples2, runs2);
+    for (size_t p = 0; success && p < JOIN_PARTITIONS; p++) {
+        SpillRun* build = swapped ? &runs2[p] : &runs1[p];
+        SpillRun* probe = swapped ? &runs1[p] : &runs2[p];
+        success = joinRuns(build, probe, swapped, 1, &output);
+    }
+    closeRuns(runs1);
+    closeRuns(runs2);
+    if (!success) {
+        free(output.rows1);
+        free(output.rows2);
+        return false;
+    }
+    *result1 = output.rows1;
+    *result2 = output.rows2;
+    *count = output.count;
+    return true;
+}
+
+/*
+==========================================
+================= ENTRY ==================
+==========================================
+*/
+
+bool hashJoinSpills(size_t num_tuples1, size_t num_tuples2) {
+    return (num_tuples1 + num_tuples2) * JOIN_TUPLE_BYTES > JOIN_MEMORY_BYTES;
+}
+
+bool hashJoin(DataType type1, const void* values1, const int* positions1, size_t num_tuples1,
+    DataType type2, const void* values2, const int* positions2, size_t num_tuples2,
+    int** result1, int** result2, size_t* count) {
+    *result1 = NULL;
+    *result2 = NULL;
+    *count = 0;
+    if (num_tuples1 == 0 || num_tuples2 == 0)
+        return true;
+    if (hashJoinSpills(num_tuples1, num_tuples2))
+        return graceJoin(type1, values1, positions1, num_tuples1, type2, values2, positions2, num_tuples2,
+            result1, result2, count);
+
+    HashJoin* join = calloc(1, sizeof(HashJoin));
+    if (join == NULL)
+        return false;
+    size_t morsels1 = (num_tuples1 + JOIN_MORSEL_ROWS - 1) / JOIN_MORSEL_ROWS;
+    size_t morsels2 = (num_tuples2 + JOIN_MORSEL_ROWS - 1) / JOIN_MORSEL_ROWS;
+    join->sides[0] = (JoinSide) { .type = type1, .values = values1, .positions = positions1,
+        .num_tuples = num_tuples1, .first_morsel = 0 };
+    join->sides[1] = (JoinSide) { .type = type2, .values = values2, .positions = positions2,
+        .num_tuples = num_tuples2, .first_morsel = morsels1 };
+    join->num_morsels = morsels1 + morsels2;
+
+    // a morsel per thread at least; small joins run on the calling thread
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    join->num_threads = (cores > JOIN_MAX_THREADS) ? JOIN_MAX_THREADS : (cores < 1) ? 1 : (int) cores;
+    if ((size_t) join->num_threads > join->num_morsels)
+        join->num_threads = (int) join->num_morsels;
+
+    join->histograms = calloc(join->num_morsels * JOIN_PARTITIONS, sizeof(size_t));
+    for (int i = 0; i < 2; i++) {
+        join->sides[i].keys = malloc(sizeof(long) * join->sides[i].num_tuples);
+        join->sides[i].rows = malloc(sizeof(int) * join->sides[i].num_tuples);
+        if (join->sides[i].keys == NULL || join->sides[i].rows == NULL)
+            join->failed = true;
+    }
+    if (join->histograms == NULL || join->failed) {
+        freeHashJoin(join);
+        return false;
+    }
+
+    runPhase(join, countPartitions);
+    placePartitions(join, &join->sides[0], morsels1);
+    placePartitions(join, &join->sides[1], morsels2);
+    if (!join->failed)
+        runPhase(join, scatterPartitions);
+    if (!join->failed)
+        runPhase(join, joinPartitions);
+    if (join->failed) {
+        freeHashJoin(join);
+        return false;
+    }
+
+    // every partition copies its matches to its own slice of the result
+    size_t total = 0;
+    for (size_t p = 0; p < JOIN_PARTITIONS; p++) {
+        join->outputs[p].offset = total;
+        total += join->outputs[p].count;
+    }
+    if (total > 0) {
+        join->result1 = malloc(sizeof(int) * total);
+        join->result2 = malloc(sizeof(int) * total);
+        if (join->result1 == NULL || join->result2 == NULL) {
+            free(join->result1);
+            free(join->result2);
+            freeHashJoin(join);
+            return false;
+        }
+        runPhase(join, gatherPartitions);
+    }
+    *result1 = join->result1;
+    *result2 = join->result2;
+    *count = total;
+    freeHashJoin(join);
+    return true;
+}
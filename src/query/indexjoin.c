@@ -0,0 +1,267 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api/btree.h"
+#include "api/column.h"
+#include "query/indexjoin.h"
+#include "query/kernels.h"
+
+// an outer key and the position it came from
+typedef struct Probe {
+    long key;
+    int row;
+} Probe;
+
+// where a lookup stands in the index, and what the last one found: the
+// count rows from first on of a clustered column, or the count rows
+// listed in rows
+typedef struct JoinCursor {
+    Table* table;
+    Index* index;
+    // first row or entry the next lookup can match
+    size_t from;
+    // leaf the next btree lookup starts from; NULL descends from the root
+    BTreeULeaf* leaf;
+    // rows gathered from btree leaves
+    int* gathered;
+    size_t gathered_capacity;
+    bool found;
+    long key;
+    size_t first;
+    const int* rows;
+    size_t count;
+} JoinCursor;
+
+static int compareProbes(const void* a, const void* b) {
+    const Probe* x = (const Probe*) a;
+    const Probe* y = (const Probe*) b;
+    if (x->key != y->key)
+        return (x->key > y->key) - (x->key < y->key);
+    return (x->row > y->row) - (x->row < y->row);
+}
+
+// finds the first row from from on whose value is >= key. Steps double
+// until they pass it, so a key close to the last one costs a few
+// comparisons. Fails if a page of the column can't be read.
+static bool gallopColumn(Column* column, size_t from, size_t num_rows, long key, size_t* row) {
+    size_t low = from;
+    size_t high = from;
+    long value;
+    for (size_t step = 1; high < num_rows; step *= 2) {
+        if (!readValue(column, high, &value))
+            return false;
+        if (value >= key)
+            break;
+        low = high + 1;
+        high += step;
+    }
+    high = high < num_rows ? high : num_rows;
+    while (low < high) {
+        size_t current = (low + high) / 2;
+        if (!readValue(column, current, &value))
+            return false;
+        if (value < key)
+            low = current + 1;
+        else
+            high = current;
+    }
+    *row = low;
+    return true;
+}
+
+// gallopColumn() over the sorted values of an unclustered index
+static size_t gallopEntries(const int* values, size_t from, size_t num_values, long key) {
+    size_t low = from;
+    size_t high = from;
+    for (size_t step = 1; high < num_values && values[high] < key; step *= 2) {
+        low = high + 1;
+        high += step;
+    }
+    high = high < num_values ? high : num_values;
+    while (low < high) {
+        size_t current = (low + high) / 2;
+        if (values[current] < key)
+            low = current + 1;
+        else
+            high = current;
+    }
+    return low;
+}
+
+// the leftmost leaf that can hold key. Copies of a key can fill several
+// leaves on both sides of a divider equal to it, so the walk turns left at
+// such a divider and gathers forward from there.
+static BTreeULeaf* descendBTree(BTreeUNode* tree, int key) {
+    BTreeUNode* ptr = tree;
+    while (ptr->type != LEAF) {
+        size_t i;
+        for (i = 0; i < ptr->object.parent.num_children - 1; i++)
+            if (ptr->object.parent.dividers[i] >= key)
+                break;
+        ptr = ptr->object.parent.children[i];
+    }
+    return &ptr->object.leaf;
+}
+
+static bool gatherRow(JoinCursor* cursor, int row) {
+    if (cursor->count == cursor->gathered_capacity) {
+        size_t new_capacity = (cursor->gathered_capacity == 0) ? 16 : 2 * cursor->gathered_capacity;
+        int* gathered = realloc(cursor->gathered, sizeof(int) * new_capacity);
+        if (gathered == NULL)
+            return false;
+        cursor->gathered = gathered;
+        cursor->gathered_capacity = new_capacity;
+    }
+    cursor->gathered[cursor->count++] = row;
+    return true;
+}
+
+// gathers the rows of an unclustered btree holding key, starting from the
+// leaf the last lookup started from while it's a few leaves away
+static bool lookupBTree(JoinCursor* cursor, long key) {
+    cursor->count = 0;
+    if (key < INT_MIN || key > INT_MAX)
+        return true;
+
+    BTreeULeaf* leaf = cursor->leaf;
+    size_t walked = 0;
+    while (leaf != NULL && leaf->num_elements > 0 && leaf->values[leaf->num_elements - 1] < key)
+        leaf = (++walked <= INDEX_JOIN_LEAF_WALK) ? leaf->next : NULL;
+    if (leaf == NULL)
+        leaf = descendBTree(cursor->index->object->btreeu, (int) key);
+    cursor->leaf = leaf;
+
+    bool past = false;
+    for (; leaf != NULL && !past; leaf = leaf->next) {
+        for (size_t i = 0; i < leaf->num_elements && !past; i++) {
+            if (leaf->values[i] < key)
+                continue;
+            past = leaf->values[i] > key;
+            if (!past && !gatherRow(cursor, leaf->indexes[i]))
+                return false;
+        }
+    }
+    cursor->rows = cursor->gathered;
+    return true;
+}
+
+// finds the inner rows holding key, which is no smaller than the last one
+// looked up since the cursor was reset
+static bool lookupKey(JoinCursor* cursor, long key) {
+    if (cursor->found && cursor->key == key)
+        return true;
+    cursor->found = true;
+    cursor->key = key;
+    Index* index = cursor->index;
+    size_t num_rows = cursor->table->num_rows;
+
+    // a clustered index of either kind keeps the column itself sorted
+    if (index->clustered) {
+        size_t first;
+        size_t end = num_rows;
+        if (!gallopColumn(index->column, cursor->from, num_rows, key, &first))
+            return false;
+        if (key != LONG_MAX && !gallopColumn(index->column, first, num_rows, key + 1, &end))
+            return false;
+        cursor->first = first;
+        cursor->rows = NULL;
+        cursor->count = end - first;
+        cursor->from = end;
+        return true;
+    }
+    if (index->type == SORTED) {
+        ColumnIndex* cindex = index->object->column;
+        size_t first = gallopEntries(cindex->values, cursor->from, num_rows, key);
+        size_t end = (key == LONG_MAX) ? num_rows : gallopEntries(cindex->values, first, num_rows, key + 1);
+        cursor->rows = cindex->indexes + first;
+        cursor->count = end - first;
+        cursor->from = end;
+        return true;
+    }
+    return lookupBTree(cursor, key);
+}
+
+static void resetCursor(JoinCursor* cursor) {
+    cursor->from = 0;
+    cursor->leaf = NULL;
+    cursor->found = false;
+}
+
+static bool reserveMatches(int** result1, int** result2, size_t* capacity, size_t needed) {
+    if (needed <= *capacity)
+        return true;
+    size_t new_capacity = (*capacity == 0) ? 1024 : *capacity;
+    while (new_capacity < needed)
+        new_capacity *= 2;
+    int* rows1 = realloc(*result1, sizeof(int) * new_capacity);
+    if (rows1 == NULL)
+        return false;
+    *result1 = rows1;
+    int* rows2 = realloc(*result2, sizeof(int) * new_capacity);
+    if (rows2 == NULL)
+        return false;
+    *result2 = rows2;
+    *capacity = new_capacity;
+    return true;
+}
+
+// probes every outer tuple of a batch, in key order
+static bool probeBatch(JoinCursor* cursor, Probe* probes, size_t num_probes, int** result1, int** result2,
+    size_t* count, size_t* capacity) {
+    for (size_t i = 0; i < num_probes; i++) {
+        if (!lookupKey(cursor, probes[i].key))
+            return false;
+        if (!reserveMatches(result1, result2, capacity, *count + cursor->count))
+            return false;
+        for (size_t j = 0; j < cursor->count; j++) {
+            (*result1)[*count] = probes[i].row;
+            (*result2)[(*count)++] = (cursor->rows != NULL) ? cursor->rows[j] : (int) (cursor->first + j);
+        }
+    }
+    return true;
+}
+
+bool indexJoin(DataType type, const void* values, const int* positions, size_t num_tuples, bool sorted,
+    Table* table, Index* index, int** result1, int** result2, size_t* count) {
+    *result1 = NULL;
+    *result2 = NULL;
+    *count = 0;
+    if (num_tuples == 0)
+        return true;
+
+    size_t batch_size = num_tuples < INDEX_JOIN_BATCH ? num_tuples : INDEX_JOIN_BATCH;
+    long* keys = malloc(sizeof(long) * batch_size);
+    Probe* probes = malloc(sizeof(Probe) * batch_size);
+    JoinCursor cursor = { .table = table, .index = index };
+    resetCursor(&cursor);
+    size_t capacity = 0;
+    bool success = keys != NULL && probes != NULL;
+
+    // outer values in order are probed in one pass; otherwise every batch
+    // is sorted and starts from the top of the index again
+    size_t width = typeWidth(type);
+    for (size_t start = 0; success && start < num_tuples; start += batch_size) {
+        size_t num_probes = (num_tuples - start < batch_size) ? num_tuples - start : batch_size;
+        widenValues(type, (const char*) values + start * width, num_probes, keys);
+        for (size_t i = 0; i < num_probes; i++)
+            probes[i] = (Probe) { .key = keys[i], .row = positions[start + i] };
+        if (!sorted) {
+            qsort(probes, num_probes, sizeof(Probe), compareProbes);
+            resetCursor(&cursor);
+        }
+        success = probeBatch(&cursor, probes, num_probes, result1, result2, count, &capacity);
+    }
+
+    free(keys);
+    free(probes);
+    free(cursor.gathered);
+    if (!success) {
+        free(*result1);
+        free(*result2);
+        *result1 = NULL;
+        *result2 = NULL;
+        *count = 0;
+    }
+    return success;
+}
@@ -0,0 +1,532 @@
+#include <limits.h>
+#include <string.h>
+
+#include "query/kernels.h"
+#include "api/column.h"
+#include "api/bufferpool.h"
+
+/*
+==========================================
+=========== PER-WIDTH KERNELS ============
+==========================================
+*/
+
+// one loop per combination of aggregates, kept as plain reductions so that
+// -O3 vectorizes them; VALUE reads the i-th input
+#define AGGREGATE_LOOPS(VALUE) \
+    if (which == AGG_SUM) { \
+        for (size_t i = 0; i < num_tuples; i++) \
+            sum += VALUE; \
+    } else if (which == AGG_MINMAX) { \
+        for (size_t i = 0; i < num_tuples; i++) { \
+            min = VALUE < min ? VALUE : min; \
+            max = VALUE > max ? VALUE : max; \
+        } \
+    } else { \
+        for (size_t i = 0; i < num_tuples; i++) { \
+            sum += VALUE; \
+            min = VALUE < min ? VALUE : min; \
+            max = VALUE > max ? VALUE : max; \
+        } \
+    }
+
+// the bits of word that stand for rows in [first_row, end)
+static inline uint64_t rowMask(size_t word, size_t first_row, size_t end) {
+    uint64_t mask = ~(uint64_t) 0;
+    size_t low = word * 64;
+    if (first_row > low)
+        mask &= mask << (first_row - low);
+    if (end < low + 64)
+        mask &= ((uint64_t) 1 << (end - low)) - 1;
+    return mask;
+}
+
+// runs BODY for every row set in the bitmap among the rows [first_row,
+// first_row + num_rows), lowest first, with the row in ROW
+#define FOR_EACH_SET_ROW(words, first_row, num_rows, ROW, BODY) \
+    for (size_t word = (first_row) / 64; word * 64 < (first_row) + (num_rows); word++) { \
+        uint64_t bits = (words)[word] & rowMask(word, (first_row), (first_row) + (num_rows)); \
+        while (bits != 0) { \
+            size_t ROW = word * 64 + __builtin_ctzll(bits); \
+            BODY \
+            bits &= bits - 1; \
+        } \
+    }
+
+#define DEFINE_KERNELS(NAME, T) \
+static size_t selectRange_##NAME(const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, int* positions) { \
+    const T* values = (const T*) data; \
+    size_t count = 0; \
+    for (size_t i = 0; i < num_rows; i++) { \
+        if (values[i] >= minimum && values[i] < maximum) \
+            positions[count++] = first_row + i; \
+    } \
+    return count; \
+} \
+\
+static size_t selectRangeBitmap_##NAME(const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, uint64_t* words) { \
+    const T* values = (const T*) data; \
+    size_t count = 0; \
+    for (size_t i = 0; i < num_rows; i++) { \
+        size_t row = first_row + i; \
+        uint64_t match = values[i] >= minimum && values[i] < maximum; \
+        words[row / 64] |= match << (row % 64); \
+        count += match; \
+    } \
+    return count; \
+} \
+\
+static bool selectRangeBatch_##NAME(const void* data, size_t first_row, size_t num_rows, long* minimum, long* maximum, \
+    int num_queries, int** results, size_t* num_tuples) { \
+    const T* values = (const T*) data; \
+    size_t capacities[num_queries]; \
+    for (int j = 0; j < num_queries; j++) \
+        capacities[j] = num_tuples[j]; \
+    for (size_t i = 0; i < num_rows; i++) { \
+        for (int j = 0; j < num_queries; j++) { \
+            if (values[i] < minimum[j] || values[i] >= maximum[j]) \
+                continue; \
+            if (num_tuples[j] == capacities[j]) { \
+                size_t new_size = (capacities[j] == 0) ? 1 : 2 * capacities[j]; \
+                int* new_data = realloc(results[j], sizeof(int) * new_size); \
+                if (new_data == NULL) \
+                    return false; \
+                results[j] = new_data; \
+                capacities[j] = new_size; \
+            } \
+            results[j][num_tuples[j]++] = first_row + i; \
+        } \
+    } \
+    return true; \
+} \
+\
+static size_t selectValues_##NAME(const void* values, const int* src, size_t num_tuples, long minimum, long maximum, int* positions) { \
+    const T* data = (const T*) values; \
+    size_t count = 0; \
+    for (size_t i = 0; i < num_tuples; i++) { \
+        if (data[i] >= minimum && data[i] < maximum) \
+            positions[count++] = src[i]; \
+    } \
+    return count; \
+} \
+\
+static size_t selectValuesBitmap_##NAME(const void* values, const uint64_t* src, size_t num_rows, long minimum, long maximum, uint64_t* words) { \
+    const T* data = (const T*) values; \
+    size_t i = 0; \
+    size_t count = 0; \
+    FOR_EACH_SET_ROW(src, 0, num_rows, row, { \
+        if (data[i] >= minimum && data[i] < maximum) { \
+            words[row / 64] |= (uint64_t) 1 << (row % 64); \
+            count++; \
+        } \
+        i++; \
+    }) \
+    return count; \
+} \
+\
+static size_t refineBitmap_##NAME(const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, uint64_t* words) { \
+    const T* values = (const T*) data; \
+    size_t count = 0; \
+    FOR_EACH_SET_ROW(words, first_row, num_rows, row, { \
+        T value = values[row - first_row]; \
+        uint64_t miss = value < minimum || value >= maximum; \
+        words[row / 64] &= ~(miss << (row % 64)); \
+        count += !miss; \
+    }) \
+    return count; \
+} \
+\
+static size_t refinePositions_##NAME(const void* data, int* positions, size_t num_tuples, long minimum, long maximum) { \
+    const T* values = (const T*) data; \
+    size_t count = 0; \
+    for (size_t i = 0; i < num_tuples; i++) { \
+        int row = positions[i]; \
+        positions[count] = row; \
+        count += values[row] >= minimum && values[row] < maximum; \
+    } \
+    return count; \
+} \
+\
+static void fetchValues_##NAME(const void* data, const int* positions, size_t num_tuples, void* out) { \
+    const T* values = (const T*) data; \
+    T* target = (T*) out; \
+    for (size_t i = 0; i < num_tuples; i++) \
+        target[i] = values[positions[i]]; \
+} \
+\
+static size_t fetchBitmap_##NAME(const void* data, size_t first_row, size_t num_rows, const uint64_t* words, void* out) { \
+    const T* values = (const T*) data; \
+    T* target = (T*) out; \
+    size_t count = 0; \
+    FOR_EACH_SET_ROW(words, first_row, num_rows, row, { \
+        target[count++] = values[row - first_row]; \
+    }) \
+    return count; \
+} \
+\
+static bool valuesAscend_##NAME(const void* data, size_t num_tuples) { \
+    const T* values = (const T*) data; \
+    for (size_t i = 1; i < num_tuples; i++) \
+        if (values[i] < values[i - 1]) \
+            return false; \
+    return true; \
+} \
+\
+static void widenValues_##NAME(const void* data, size_t num_tuples, long* out) { \
+    const T* values = (const T*) data; \
+    for (size_t i = 0; i < num_tuples; i++) \
+        out[i] = values[i]; \
+} \
+\
+static void aggregateValues_##NAME(const void* data, const int* positions, size_t num_tuples, int which, Aggregates* out) { \
+    const T* values = (const T*) data; \
+    *out = (Aggregates) { .sum = 0, .min = 0, .max = 0, .count = num_tuples }; \
+    if (num_tuples == 0) \
+        return; \
+    long sum = 0; \
+    T min = (positions == NULL) ? values[0] : values[positions[0]]; \
+    T max = min; \
+    if (positions == NULL) { \
+        AGGREGATE_LOOPS(values[i]) \
+    } else { \
+        AGGREGATE_LOOPS(values[positions[i]]) \
+    } \
+    out->sum = sum; \
+    out->min = min; \
+    out->max = max; \
+} \
+\
+static void aggregateBitmap_##NAME(const void* data, size_t first_row, size_t num_rows, const uint64_t* words, \
+    int which, Aggregates* out) { \
+    const T* values = (const T*) data; \
+    long sum = 0; \
+    long min = LONG_MAX; \
+    long max = LONG_MIN; \
+    size_t count = 0; \
+    FOR_EACH_SET_ROW(words, first_row, num_rows, row, { \
+        long value = values[row - first_row]; \
+        if (which & AGG_SUM) \
+            sum += value; \
+        if (which & AGG_MINMAX) { \
+            min = value < min ? value : min; \
+            max = value > max ? value : max; \
+        } \
+        count++; \
+    }) \
+    *out = (Aggregates) { .sum = sum, .min = count ? min : 0, .max = count ? max : 0, .count = count }; \
+} \
+\
+static void aggregateGroups_##NAME(const void* data, const int* groups, size_t num_tuples, int which, \
+    long* sums, long* mins, long* maxs, size_t* counts) { \
+    const T* values = (const T*) data; \
+    for (size_t i = 0; i < num_tuples; i++) { \
+        int group = groups[i]; \
+        long value = values[i]; \
+        counts[group]++; \
+        if (which & AGG_SUM) \
+            sums[group] += value; \
+        if (which & AGG_MINMAX) { \
+            mins[group] = value < mins[group] ? value : mins[group]; \
+            maxs[group] = value > maxs[group] ? value : maxs[group]; \
+        } \
+    } \
+} \
+\
+static void combineValues_##NAME(MathType op, const void* data1, const void* data2, size_t num_tuples, void* out) { \
+    const T* values1 = (const T*) data1; \
+    const T* values2 = (const T*) data2; \
+    if (sizeof(T) > sizeof(int)) { \
+        long* target = (long*) out; \
+        if (op == ADD) { \
+            for (size_t i = 0; i < num_tuples; i++) \
+                target[i] = (long) values1[i] + values2[i]; \
+        } else { \
+            for (size_t i = 0; i < num_tuples; i++) \
+                target[i] = (long) values1[i] - values2[i]; \
+        } \
+    } else { \
+        int* target = (int*) out; \
+        if (op == ADD) { \
+            for (size_t i = 0; i < num_tuples; i++) \
+                target[i] = values1[i] + values2[i]; \
+        } else { \
+            for (size_t i = 0; i < num_tuples; i++) \
+                target[i] = values1[i] - values2[i]; \
+        } \
+    } \
+}
+
+FOR_EACH_INT_TYPE(DEFINE_KERNELS)
+
+/*
+==========================================
+============ TYPE DISPATCHERS ============
+==========================================
+*/
+
+// expands to a switch calling KERNEL_<type>(...) and storing its value in ret
+#define DISPATCH(ret, type, KERNEL, ...) \
+    switch (type) { \
+        case BYTE: ret = KERNEL##_BYTE(__VA_ARGS__); break; \
+        case SHORT: ret = KERNEL##_SHORT(__VA_ARGS__); break; \
+        case LONG: ret = KERNEL##_LONG(__VA_ARGS__); break; \
+        default: ret = KERNEL##_INT(__VA_ARGS__); break; \
+    }
+
+// same as DISPATCH for kernels without a return value
+#define DISPATCH_VOID(type, KERNEL, ...) \
+    switch (type) { \
+        case BYTE: KERNEL##_BYTE(__VA_ARGS__); break; \
+        case SHORT: KERNEL##_SHORT(__VA_ARGS__); break; \
+        case LONG: KERNEL##_LONG(__VA_ARGS__); break; \
+        default: KERNEL##_INT(__VA_ARGS__); break; \
+    }
+
+size_t selectRange(DataType type, const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, int* positions) {
+    size_t count = 0;
+    DISPATCH(count, type, selectRange, data, first_row, num_rows, minimum, maximum, positions);
+    return count;
+}
+
+size_t selectRangeBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, uint64_t* words) {
+    size_t count = 0;
+    DISPATCH(count, type, selectRangeBitmap, data, first_row, num_rows, minimum, maximum, words);
+    return count;
+}
+
+bool selectRangeBatch(DataType type, const void* data, size_t first_row, size_t num_rows,
+    long* minimum, long* maximum, int num_queries, int** results, size_t* num_tuples) {
+    bool success = true;
+    DISPATCH(success, type, selectRangeBatch, data, first_row, num_rows, minimum, maximum, num_queries, results, num_tuples);
+    return success;
+}
+
+size_t selectValues(DataType type, const void* values, const int* src, size_t num_tuples, long minimum, long maximum, int* positions) {
+    size_t count = 0;
+    DISPATCH(count, type, selectValues, values, src, num_tuples, minimum, maximum, positions);
+    return count;
+}
+
+size_t selectValuesBitmap(DataType type, const void* values, const uint64_t* src, size_t num_rows, long minimum, long maximum, uint64_t* words) {
+    size_t count = 0;
+    DISPATCH(count, type, selectValuesBitmap, values, src, num_rows, minimum, maximum, words);
+    return count;
+}
+
+size_t refineBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, long minimum, long maximum, uint64_t* words) {
+    size_t count = 0;
+    DISPATCH(count, type, refineBitmap, data, first_row, num_rows, minimum, maximum, words);
+    return count;
+}
+
+size_t refinePositions(DataType type, const void* data, int* positions, size_t num_tuples, long minimum, long maximum) {
+    size_t count = 0;
+    DISPATCH(count, type, refinePositions, data, positions, num_tuples, minimum, maximum);
+    return count;
+}
+
+void fetchValues(DataType type, const void* data, const int* positions, size_t num_tuples, void* out) {
+    DISPATCH_VOID(type, fetchValues, data, positions, num_tuples, out);
+}
+
+size_t fetchBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, const uint64_t* words, void* out) {
+    size_t count = 0;
+    DISPATCH(count, type, fetchBitmap, data, first_row, num_rows, words, out);
+    return count;
+}
+
+bool valuesAscend(DataType type, const void* data, size_t num_tuples) {
+    bool ascending = true;
+    DISPATCH(ascending, type, valuesAscend, data, num_tuples);
+    return ascending;
+}
+
+void widenValues(DataType type, const void* data, size_t num_tuples, long* out) {
+    DISPATCH_VOID(type, widenValues, data, num_tuples, out);
+}
+
+void aggregateValues(DataType type, const void* data, const int* positions, size_t num_tuples, int which, Aggregates* out) {
+    DISPATCH_VOID(type, aggregateValues, data, positions, num_tuples, which, out);
+}
+
+void aggregateBitmap(DataType type, const void* data, size_t first_row, size_t num_rows, const uint64_t* words,
+    int which, Aggregates* out) {
+    DISPATCH_VOID(type, aggregateBitmap, data, first_row, num_rows, words, which, out);
+}
+
+void aggregateGroups(DataType type, const void* data, const int* groups, size_t num_tuples, int which,
+    long* sums, long* mins, long* maxs, size_t* counts) {
+    DISPATCH_VOID(type, aggregateGroups, data, groups, num_tuples, which, sums, mins, maxs, counts);
+}
+
+DataType combinedType(DataType type) {
+    return type == LONG ? LONG : INT;
+}
+
+void combineValues(MathType op, DataType type, const void* data1, const void* data2, size_t num_tuples, void* out) {
+    DISPATCH_VOID(type, combineValues, op, data1, data2, num_tuples, out);
+}
+
+/*
+==========================================
+============== COLUMN SCANS ==============
+==========================================
+*/
+
+bool scanColumn(Column* column, size_t num_rows, long minimum, long maximum, int* positions, size_t* count) {
+    *count = 0;
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk))
+            return false;
+        *count += selectRange(column->type, chunk.data, chunk.first_row, chunk.num_rows, minimum, maximum, positions + *count);
+        releaseChunk(column, &chunk);
+    }
+    return true;
+}
+
+bool scanColumnBitmap(Column* column, size_t num_rows, long minimum, long maximum, uint64_t* words, size_t* count) {
+    *count = 0;
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk))
+            return false;
+        *count += selectRangeBitmap(column->type, chunk.data, chunk.first_row, chunk.num_rows, minimum, maximum, words);
+        releaseChunk(column, &chunk);
+    }
+    return true;
+}
+
+bool scanColumnBatch(Column* column, size_t num_rows,
+    long* minimum, long* maximum, int num_queries, int** results, size_t* num_tuples) {
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk))
+            return false;
+        bool success = selectRangeBatch(column->type, chunk.data, chunk.first_row, chunk.num_rows,
+            minimum, maximum, num_queries, results, num_tuples);
+        releaseChunk(column, &chunk);
+        if (!success)
+            return false;
+    }
+    return true;
+}
+
+bool fetchColumn(Column* column, const int* positions, size_t num_tuples, void* out) {
+    if (!column->paged) {
+        fetchValues(column->type, column->data, positions, num_tuples, out);
+        return true;
+    }
+    // positions usually come in order, so keep the current page pinned
+    // until a position falls outside of it
+    size_t width = typeWidth(column->type);
+    ColumnChunk chunk = { .pinned = false, .num_rows = 0, .first_row = 0 };
+    for (size_t i = 0; i < num_tuples; i++) {
+        size_t row = positions[i];
+        if (row < chunk.first_row || row >= chunk.first_row + chunk.num_rows) {
+            releaseChunk(column, &chunk);
+            // start the chunk at the beginning of the row's page
+            size_t start = (row < column->paged_rows) ? row - row % pageRows(column) : column->paged_rows;
+            if (!getChunk(column, start, (size_t) -1, &chunk))
+                return false;
+        }
+        memcpy((char*) out + i * width, (const char*) chunk.data + (row - chunk.first_row) * width, width);
+    }
+    releaseChunk(column, &chunk);
+    return true;
+}
+
+bool fetchColumnBitmap(Column* column, const uint64_t* words, size_t num_rows, void* out) {
+    size_t width = typeWidth(column->type);
+    size_t count = 0;
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk))
+            return false;
+        count += fetchBitmap(column->type, chunk.data, chunk.first_row, chunk.num_rows, words, (char*) out + count * width);
+        releaseChunk(column, &chunk);
+    }
+    return true;
+}
+
+bool refineColumnBitmap(Column* column, size_t num_rows, long minimum, long maximum, uint64_t* words, size_t* count) {
+    *count = 0;
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk))
+            return false;
+        *count += refineBitmap(column->type, chunk.data, chunk.first_row, chunk.num_rows, minimum, maximum, words);
+        releaseChunk(column, &chunk);
+    }
+    return true;
+}
+
+bool refineColumnPositions(Column* column, int* positions, size_t num_tuples, long minimum, long maximum, size_t* count) {
+    if (!column->paged) {
+        *count = refinePositions(column->type, column->data, positions, num_tuples, minimum, maximum);
+        return true;
+    }
+    // gather the values page by page first; selectValues may write the
+    // positions it keeps over the ones it read
+    void* values = malloc(typeWidth(column->type) * (num_tuples + 1));
+    if (values == NULL || !fetchColumn(column, positions, num_tuples, values)) {
+        free(values);
+        return false;
+    }
+    *count = selectValues(column->type, values, positions, num_tuples, minimum, maximum, positions);
+    free(values);
+    return true;
+}
+
+// folds the aggregates of a part of the input into those of the rest
+static void mergeAggregates(Aggregates* out, const Aggregates* partial) {
+    if (partial->count == 0)
+        return;
+    out->min = (out->count == 0 || partial->min < out->min) ? partial->min : out->min;
+    out->max = (out->count == 0 || partial->max > out->max) ? partial->max : out->max;
+    out->sum += partial->sum;
+    out->count += partial->count;
+}
+
+bool aggregateColumn(Column* column, size_t num_rows, const int* positions, size_t num_tuples, int which, Aggregates* out) {
+    if (!column->paged) {
+        aggregateValues(column->type, column->data, positions, positions == NULL ? num_rows : num_tuples, which, out);
+        return true;
+    }
+    if (positions != NULL) {
+        void* values = malloc(typeWidth(column->type) * (num_tuples + 1));
+        if (values == NULL || !fetchColumn(column, positions, num_tuples, values)) {
+            free(values);
+            return false;
+        }
+        aggregateValues(column->type, values, NULL, num_tuples, which, out);
+        free(values);
+        return true;
+    }
+    // merge the aggregates of every chunk
+    *out = (Aggregates) { .sum = 0, .min = 0, .max = 0, .count = 0 };
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk))
+            return false;
+        Aggregates partial;
+        aggregateValues(column->type, chunk.data, NULL, chunk.num_rows, which, &partial);
+        releaseChunk(column, &chunk);
+        mergeAggregates(out, &partial);
+    }
+    return true;
+}
+
+bool aggregateColumnBitmap(Column* column, const uint64_t* words, size_t num_rows, int which, Aggregates* out) {
+    *out = (Aggregates) { .sum = 0, .min = 0, .max = 0, .count = 0 };
+    ColumnChunk chunk;
+    for (size_t row = 0; row < num_rows; row += chunk.num_rows) {
+        if (!getChunk(column, row, num_rows, &chunk))
+            return false;
+        Aggregates partial;
+        aggregateBitmap(column->type, chunk.data, chunk.first_row, chunk.num_rows, words, which, &partial);
+        releaseChunk(column, &chunk);
+        mergeAggregates(out, &partial);
+    }
+    return true;
+}
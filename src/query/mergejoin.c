@@ -0,0 +1,167 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "query/kernels.h"
+#include "query/mergejoin.h"
+
+// the keys of an input widened to longs, and the position of each
+typedef struct MergeInput {
+    long* keys;
+    int* rows;
+    size_t num_tuples;
+} MergeInput;
+
+// flipping the sign bit orders signed keys like their unsigned bytes
+static inline size_t radixDigit(long key, int pass) {
+    return (((uint64_t) key ^ ((uint64_t) 1 << 63)) >> (8 * pass)) & 0xFF;
+}
+
+// sorts keys along with rows, one byte per pass from the lowest. A single
+// pass counts every byte position; those on which all keys agree are
+// skipped
+static bool radixSort(long* keys, int* rows, size_t num_tuples) {
+    size_t (*counts)[256] = calloc(8, sizeof(*counts));
+    long* other_keys = malloc(sizeof(long) * num_tuples);
+    int* other_rows = malloc(sizeof(int) * num_tuples);
+    if (counts == NULL || other_keys == NULL || other_rows == NULL) {
+        free(counts);
+        free(other_keys);
+        free(other_rows);
+        return false;
+    }
+    for (size_t i = 0; i < num_tuples; i++)
+        for (int pass = 0; pass < 8; pass++)
+            counts[pass][radixDigit(keys[i], pass)]++;
+
+    long* from_keys = keys;
+    int* from_rows = rows;
+    long* to_keys = other_keys;
+    int* to_rows = other_rows;
+    for (int pass = 0; pass < 8; pass++) {
+        if (counts[pass][radixDigit(keys[0], pass)] == num_tuples)
+            continue;
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 256; digit++) {
+            size_t count = counts[pass][digit];
+            counts[pass][digit] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < num_tuples; i++) {
+            size_t slot = counts[pass][radixDigit(from_keys[i], pass)]++;
+            to_keys[slot] = from_keys[i];
+            to_rows[slot] = from_rows[i];
+        }
+        long* swap_keys = from_keys;
+        from_keys = to_keys;
+        to_keys = swap_keys;
+        int* swap_rows = from_rows;
+        from_rows = to_rows;
+        to_rows = swap_rows;
+    }
+    if (from_keys != keys) {
+        memcpy(keys, from_keys, sizeof(long) * num_tuples);
+        memcpy(rows, from_rows, sizeof(int) * num_tuples);
+    }
+    free(counts);
+    free(other_keys);
+    free(other_rows);
+    return true;
+}
+
+// widens an input, sorting a copy of its positions along if it's out of
+// order; a sorted input keeps its own positions
+static bool prepareInput(DataType type, const void* values, const int* positions, size_t num_tuples, bool sorted,
+    MergeInput* input) {
+    input->num_tuples = num_tuples;
+    input->keys = malloc(sizeof(long) * (num_tuples + 1));
+    input->rows = sorted ? (int*) positions : malloc(sizeof(int) * (num_tuples + 1));
+    if (input->keys == NULL || input->rows == NULL)
+        return false;
+    widenValues(type, values, num_tuples, input->keys);
+    if (sorted)
+        return true;
+    memcpy(input->rows, positions, sizeof(int) * num_tuples);
+    return radixSort(input->keys, input->rows, num_tuples);
+}
+
+static bool appendMatch(int** result1, int** result2, size_t* count, size_t* capacity, int row1, int row2) {
+    if (*count == *capacity) {
+        size_t new_capacity = (*capacity == 0) ? 1024 : 2 * *capacity;
+        int* rows1 = realloc(*result1, sizeof(int) * new_capacity);
+        if (rows1 == NULL)
+            return false;
+        *result1 = rows1;
+        int* rows2 = realloc(*result2, sizeof(int) * new_capacity);
+        if (rows2 == NULL)
+            return false;
+        *result2 = rows2;
+        *capacity = new_capacity;
+    }
+    (*result1)[*count] = row1;
+    (*result2)[(*count)++] = row2;
+    return true;
+}
+
+// matches every run of equal keys on one side with the same run on the
+// other
+static bool mergeInputs(MergeInput* input1, MergeInput* input2, int** result1, int** result2, size_t* count) {
+    size_t capacity = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < input1->num_tuples && j < input2->num_tuples) {
+        long key = input1->keys[i];
+        if (key < input2->keys[j]) {
+            i++;
+            continue;
+        }
+        if (key > input2->keys[j]) {
+            j++;
+            continue;
+        }
+        size_t end1 = i;
+        while (end1 < input1->num_tuples && input1->keys[end1] == key)
+            end1++;
+        size_t end2 = j;
+        while (end2 < input2->num_tuples && input2->keys[end2] == key)
+            end2++;
+        for (size_t a = i; a < end1; a++)
+            for (size_t b = j; b < end2; b++)
+                if (!appendMatch(result1, result2, count, &capacity, input1->rows[a], input2->rows[b]))
+                    return false;
+        i = end1;
+        j = end2;
+    }
+    return true;
+}
+
+static void freeInput(MergeInput* input, bool sorted) {
+    free(input->keys);
+    if (!sorted)
+        free(input->rows);
+}
+
+bool mergeJoin(DataType type1, const void* values1, const int* positions1, size_t num_tuples1, bool sorted1,
+    DataType type2, const void* values2, const int* positions2, size_t num_tuples2, bool sorted2,
+    int** result1, int** result2, size_t* count) {
+    *result1 = NULL;
+    *result2 = NULL;
+    *count = 0;
+    if (num_tuples1 == 0 || num_tuples2 == 0)
+        return true;
+
+    MergeInput input1 = { .keys = NULL, .rows = NULL };
+    MergeInput input2 = { .keys = NULL, .rows = NULL };
+    bool success = prepareInput(type1, values1, positions1, num_tuples1, sorted1, &input1) &&
+        prepareInput(type2, values2, positions2, num_tuples2, sorted2, &input2) &&
+        mergeInputs(&input1, &input2, result1, result2, count);
+    freeInput(&input1, sorted1);
+    freeInput(&input2, sorted2);
+    if (!success) {
+        free(*result1);
+        free(*result2);
+        *result1 = NULL;
+        *result2 = NULL;
+        *count = 0;
+    }
+    return success;
+}
@@ -0,0 +1,107 @@
+#include <limits.h>
+
+#include "api/column.h"
+#include "api/statistics.h"
+#include "query/plan.h"
+
+const char* accessPathName(Index* index) {
+    if (index == NULL)
+        return "full scan";
+    if (index->type == BTREE)
+        return index->clustered ? "clustered btree index" : "unclustered btree index";
+    return index->clustered ? "clustered sorted index" : "unclustered sorted index";
+}
+
+// first entry of a sorted int array that is >= value
+static size_t lowerBoundInts(const int* values, size_t num_values, long value) {
+    size_t low = 0;
+    size_t high = num_values;
+    while (low < high) {
+        size_t current = (low + high) / 2;
+        if (values[current] < value)
+            low = current + 1;
+        else
+            high = current;
+    }
+    return low;
+}
+
+long estimateSelectRows(Table* table, Column* column, Index* index, long minimum, long maximum) {
+    size_t num_rows = table->num_rows;
+    if (minimum >= maximum || num_rows == 0)
+        return 0;
+
+    // a clustered index keeps the column itself sorted, an unclustered
+    // sorted index a sorted copy of it; either way two binary searches
+    // count the rows in range exactly
+    if (index != NULL && index->clustered) {
+        size_t low, high;
+        // a column that can't be read is as bad as a full scan
+        if (!lowerBound(column, num_rows, minimum, &low) || !lowerBound(column, num_rows, maximum, &high))
+            return (long) num_rows;
+        return (long) (high - low);
+    }
+    if (index != NULL && index->type == SORTED) {
+        const int* values = index->object->column->values;
+        size_t low = lowerBoundInts(values, num_rows, minimum);
+        size_t high = lowerBoundInts(values, num_rows, maximum);
+        return (long) (high - low);
+    }
+
+    // otherwise ask the column's statistics, or, while they don't cover
+    // every row, count the matches among evenly spaced rows
+    ColumnStats* stats = column->stats;
+    if (stats != NULL && stats->num_rows == num_rows)
+        return (long) (estimateRangeRows(stats, minimum, maximum) + 0.5);
+    size_t samples = num_rows < SELECTIVITY_SAMPLE_ROWS ? num_rows : SELECTIVITY_SAMPLE_ROWS;
+    size_t matches = 0;
+    for (size_t i = 0; i < samples; i++) {
+        long value;
+        if (!readValue(column, i * num_rows / samples, &value))
+            return (long) num_rows;
+        if (value >= minimum && value < maximum)
+            matches++;
+    }
+    return (long) (matches * num_rows / samples);
+}
+
+// true for an index that keeps copies of other columns in entry order
+static bool hasCopies(Index* index) {
+    return index->num_keys > 0 || index->num_included > 0;
+}
+
+// lower is better: sorted indexes answer a range with two binary searches
+// where a tree walks its leaves
+static int indexRank(Index* index) {
+    if (index->clustered)
+        return index->type == SORTED ? 0 : 1;
+    if (hasCopies(index))
+        return 2;
+    return index->type == SORTED ? 3 : 4;
+}
+
+Index* chooseSelectIndex(Table* table, Column* column, long minimum, long maximum, long* estimated_rows) {
+    Index* best = NULL;
+    for (size_t i = 0; i < table->num_indexes; i++) {
+        Index* index = table->indexes[i];
+        if (index->column == column && (best == NULL || indexRank(index) < indexRank(best)))
+            best = index;
+    }
+
+    *estimated_rows = estimateSelectRows(table, column, best, minimum, maximum);
+    if (best == NULL || best->clustered || hasCopies(best))
+        return best;
+    if ((size_t) *estimated_rows * UNCLUSTERED_MATCH_COST > table->num_rows)
+        return NULL;
+    return best;
+}
+
+Index* chooseJoinIndex(Table* table, Column* column) {
+    Index* best = NULL;
+    for (size_t i = 0; i < table->num_indexes; i++) {
+        Index* index = table->indexes[i];
+        if (index->column == column && (best == NULL || indexRank(index) < indexRank(best)))
+            best = index;
+    }
+    return best;
+}
@@ -0,0 +1,135 @@
+#include <stdlib.h>
+
+#include "api/context.h"
+#include "api/cracker.h"
+#include "query/bitmap.h"
+#include "query/execute.h"
+#include "query/kernels.h"
+#include "query/plan.h"
+#include "query/sharedscan.h"
+#include "util/metrics.h"
+
+typedef struct SharedSelect {
+    int client_fd;
+    Table* table;
+    Column* column;
+    long minimum;
+    long maximum;
+    Result* result;
+    uint64_t parse_ns;
+} SharedSelect;
+
+static SharedSelect* queued = NULL;
+static size_t num_queued = 0;
+static size_t queued_slots = 0;
+
+// true if the select reads a base column the way selectColumn() would scan
+// it: no index is worth reading and the column isn't cracked
+static bool scansColumn(DbOperator* query) {
+    SelectOperator* select = &query->fields.select;
+    ClientContext* context = query->context;
+    if (context == NULL || context->queries != NULL || select->src_is_var || select->num_conjuncts > 0)
+        return false;
+    message ignored;
+    if (resolveSelectColumn(select, &ignored) != NULL)
+        return false;
+    long estimated_rows;
+    return chooseSelectIndex(select->table, select->column, select->minimum, select->maximum, &estimated_rows) ==
+        NULL && !shouldCrack(select->table, select->column);
+}
+
+bool queueSharedSelect(DbOperator* query, uint64_t parse_ns) {
+    if (query->type != OP_SELECT || !scansColumn(query))
+        return false;
+    if (num_queued == queued_slots) {
+        size_t new_slots = (queued_slots == 0) ? 16 : 2 * queued_slots;
+        SharedSelect* new_queued = realloc(queued, sizeof(SharedSelect) * new_slots);
+        if (new_queued == NULL)
+            return false;
+        queued = new_queued;
+        queued_slots = new_slots;
+    }
+    Result* result = calloc(1, sizeof(Result));
+    if (result == NULL)
+        return false;
+    result->data_type = INT;
+    if (!addResultHandle(query->context, query->fields.select.handle, result)) {
+        free(result);
+        return false;
+    }
+
+    SelectOperator* select = &query->fields.select;
+    queued[num_queued++] = (SharedSelect) {
+        .client_fd = query->client_fd,
+        .table = select->table,
+        .column = select->column,
+        .minimum = select->minimum,
+        .maximum = select->maximum,
+        .result = result,
+        .parse_ns = parse_ns
+    };
+    return true;
+}
+
+size_t sharedSelectsQueued() {
+    return num_queued;
+}
+
+// answers the selects from first to first + count, which all read the same
+// column, with one scan of it
+static void scanShared(SharedSelect* first, size_t count, SharedScanReply reply) {
+    uint64_t start = statsNow();
+    long minimum[count];
+    long maximum[count];
+    int* results[count];
+    size_t num_tuples[count];
+    for (size_t i = 0; i < count; i++) {
+        minimum[i] = first[i].minimum;
+        maximum[i] = first[i].maximum;
+        results[i] = NULL;
+        num_tuples[i] = 0;
+    }
+    size_t num_rows = first->table->num_rows;
+    bool scanned = scanColumnBatch(first->column, num_rows, minimum, maximum, (int) count, results, num_tuples);
+    if (scanned) {
+        for (size_t i = 0; i < count; i++) {
+            storePositions(first[i].result, results[i], num_tuples[i], num_rows);
+            statsAddRows(OP_SELECT, 0, num_tuples[i]);
+        }
+        statsAddRows(OP_SELECT, num_rows, 0);
+    } else {
+        for (size_t i = 0; i < count; i++)
+            free(results[i]);
+    }
+
+    // every select waited for the whole scan
+    uint64_t execute_ns = statsNow() - start;
+    for (size_t i = 0; i < count; i++) {
+        message send_message = { .status = scanned ? OK_DONE : EXECUTION_ERROR, .length = 0, .payload = NULL };
+        char* result = scanned ? "Successfully selected data from column." : "-- Error calculating result array.";
+        reply(first[i].client_fd, &send_message, result, first[i].parse_ns, execute_ns);
+    }
+}
+
+void runSharedScans(SharedScanReply reply) {
+    // group the selects by column, keeping the order they arrived in
+    // within each group
+    for (size_t i = 1; i < num_queued; i++) {
+        SharedSelect current = queued[i];
+        size_t j = i;
+        while (j > 0 && queued[j - 1].column > current.column) {
+            queued[j] = queued[j - 1];
+            j--;
+        }
+        queued[j] = current;
+    }
+    size_t start = 0;
+    while (start < num_queued) {
+        size_t end = start + 1;
+        while (end < num_queued && queued[end].column == queued[start].column)
+            end++;
+        scanShared(queued + start, end - start, reply);
+        start = end;
+    }
+    num_queued = 0;
+}
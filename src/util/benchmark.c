@@ -0,0 +1,477 @@
+#define _XOPEN_SOURCE 600
+/**
+ * benchmark.c
+ *
+ * Workload runner for the benchmark harness. Replays a weighted mix of DSL
+ * statements against a running server from N concurrent clients and prints
+ * throughput and p50/p99 latency, overall and per kind of operation, as JSON.
+ * Given a previous result with -b it exits with status 2 when throughput
+ * dropped or p99 latency grew by more than the tolerance.
+ *
+ * A workload file has one operation per line:
+ *
+ *     <kind> <weight> <statement>[;<statement>...]
+ *
+ * An operation's statements run back to back on one connection and are
+ * timed together. {lo} and {hi} expand to a random range of the configured
+ * width and {v} to a random value. Lines starting with "--" are comments.
+ **/
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "util/const.h"
+#include "util/message.h"
+
+#define MAX_OPERATIONS 64
+#define MAX_KIND_LENGTH 32
+#define MAX_STATEMENT_LENGTH 1024
+#define DEFAULT_COUNT 1000
+#define DEFAULT_MAX 100000
+#define DEFAULT_TOLERANCE 10.0
+
+typedef struct Operation {
+    char kind[MAX_KIND_LENGTH];
+    int kind_index;
+    int weight;
+    char* text;
+} Operation;
+
+// one timed operation
+typedef struct Sample {
+    int kind;
+    unsigned long long nanoseconds;
+} Sample;
+
+typedef struct ClientRun {
+    pthread_t thread;
+    int id;
+    unsigned long long state;
+    Sample* samples;
+    size_t num_samples;
+    size_t capacity;
+    size_t* errors;
+    bool failed;
+} ClientRun;
+
+static Operation operations[MAX_OPERATIONS];
+static int num_operations;
+static int total_weight;
+static char kinds[MAX_OPERATIONS][MAX_KIND_LENGTH];
+static int num_kinds;
+
+static size_t count = DEFAULT_COUNT;
+static double duration;
+static long max_value = DEFAULT_MAX;
+static long range_width;
+static unsigned long long deadline;
+
+static unsigned long long now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static int findKind(const char* kind) {
+    for (int i = 0; i < num_kinds; i++)
+        if (strcmp(kinds[i], kind) == 0)
+            return i;
+    strcpy(kinds[num_kinds], kind);
+    return num_kinds++;
+}
+
+static bool readWorkload(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        perror("benchmark");
+        return false;
+    }
+    char line[MAX_STATEMENT_LENGTH];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || strncmp(line, "--", 2) == 0)
+            continue;
+        Operation* op = &operations[num_operations];
+        int offset = 0;
+        if (num_operations == MAX_OPERATIONS
+                || sscanf(line, "%31s %d %n", op->kind, &op->weight, &offset) != 2
+                || offset == 0 || op->weight <= 0) {
+            fprintf(stderr, "benchmark: bad workload line: %s\n", line);
+            fclose(fp);
+            return false;
+        }
+        op->text = strdup(line + offset);
+        total_weight += op->weight;
+        op->kind_index = findKind(op->kind);
+        num_operations++;
+    }
+    fclose(fp);
+    if (num_operations == 0)
+        fprintf(stderr, "benchmark: empty workload\n");
+    return num_operations > 0;
+}
+
+// expands the placeholders of one statement into out
+static void expand(const char* text, size_t length, char* out, unsigned long long* state) {
+    long low = (long) (nextRandom(state) % (unsigned long long) (max_value - range_width + 1));
+    char* end = out;
+    const char* p = text;
+    while (p < text + length) {
+        if (strncmp(p, "{lo}", 4) == 0) {
+            end += sprintf(end, "%ld", low);
+            p += 4;
+        } else if (strncmp(p, "{hi}", 4) == 0) {
+            end += sprintf(end, "%ld", low + range_width);
+            p += 4;
+        } else if (strncmp(p, "{v}", 3) == 0) {
+            end += sprintf(end, "%ld", (long) (nextRandom(state) % (unsigned long long) max_value));
+            p += 3;
+        } else
+            *end++ = *p++;
+    }
+    *end = '\0';
+}
+
+static int connectClient(void) {
+    int client_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client_socket == -1)
+        return -1;
+    struct sockaddr_un remote;
+    remote.sun_family = AF_UNIX;
+    strncpy(remote.sun_path, SOCK_PATH, sizeof(remote.sun_path) - 1);
+    remote.sun_path[sizeof(remote.sun_path) - 1] = '\0';
+    size_t len = strlen(remote.sun_path) + sizeof(remote.sun_family) + 1;
+    if (connect(client_socket, (struct sockaddr*) &remote, len) == -1) {
+        close(client_socket);
+        return -1;
+    }
+    return client_socket;
+}
+
+static bool receiveAll(int socket, void* buffer, size_t length) {
+    size_t received = 0;
+    while (received < length) {
+        ssize_t len = recv(socket, (char*) buffer + received, length - received, 0);
+        if (len <= 0)
+            return false;
+        received += len;
+    }
+    return true;
+}
+
+// sends one statement and drains its response; returns false if the
+// connection broke and sets *ok to whether the server accepted it
+static bool runStatement(int socket, char* statement, bool* ok) {
+    message send_message = { .status = OK_DONE, .length = strlen(statement), .payload = statement };
+    if (send(socket, &send_message, sizeof(message), 0) == -1
+            || send(socket, statement, send_message.length, 0) == -1)
+        return false;
+    message recv_message;
+    if (!receiveAll(socket, &recv_message, sizeof(message)))
+        return false;
+    if (recv_message.status == OK_WAIT_FOR_RESPONSE && recv_message.length > 0) {
+        char payload[4096];
+        size_t remaining = recv_message.length;
+        while (remaining > 0) {
+            size_t chunk = remaining < sizeof(payload) ? remaining : sizeof(payload);
+            if (!receiveAll(socket, payload, chunk))
+                return false;
+            remaining -= chunk;
+        }
+    }
+    *ok = recv_message.status == OK_DONE || recv_message.status == OK_WAIT_FOR_RESPONSE;
+    return true;
+}
+
+static Operation* pickOperation(unsigned long long* state) {
+    int pick = (int) (nextRandom(state) % (unsigned long long) total_weight);
+    for (int i = 0; i < num_operations; i++) {
+        pick -= operations[i].weight;
+        if (pick < 0)
+            return &operations[i];
+    }
+    return &operations[num_operations - 1];
+}
+
+static void* runClient(void* arg) {
+    ClientRun* run = (ClientRun*) arg;
+    int socket = connectClient();
+    if (socket == -1) {
+        fprintf(stderr, "benchmark: client %d could not connect\n", run->id);
+        run->failed = true;
+        return NULL;
+    }
+    char statement[2 * MAX_STATEMENT_LENGTH];
+    for (size_t i = 0; duration > 0 ? now() < deadline : i < count; i++) {
+        Operation* op = pickOperation(&run->state);
+        bool ok = true;
+        unsigned long long start = now();
+        for (const char* text = op->text; *text != '\0'; ) {
+            size_t length = strcspn(text, ";");
+            expand(text, length, statement, &run->state);
+            bool accepted;
+            if (!runStatement(socket, statement, &accepted)) {
+                fprintf(stderr, "benchmark: client %d lost its connection\n", run->id);
+                run->failed = true;
+                close(socket);
+                return NULL;
+            }
+            ok = ok && accepted;
+            text += length;
+            if (*text == ';')
+                text++;
+        }
+        if (run->num_samples == run->capacity) {
+            size_t capacity = run->capacity ? run->capacity * 2 : 1024;
+            Sample* samples = realloc(run->samples, capacity * sizeof(Sample));
+            if (samples == NULL)
+                break;
+            run->samples = samples;
+            run->capacity = capacity;
+        }
+        run->samples[run->num_samples].kind = op->kind_index;
+        run->samples[run->num_samples++].nanoseconds = now() - start;
+        if (!ok)
+            run->errors[op->kind_index]++;
+    }
+    close(socket);
+    return NULL;
+}
+
+static int compareSamples(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*) a;
+    unsigned long long y = *(const unsigned long long*) b;
+    return (x > y) - (x < y);
+}
+
+// percentile of sorted latencies, in microseconds
+static double percentile(const unsigned long long* sorted, size_t n, double p) {
+    if (n == 0)
+        return 0;
+    size_t index = (size_t) (p * (n - 1) + 0.5);
+    return sorted[index] / 1000.0;
+}
+
+typedef struct Summary {
+    size_t operations;
+    size_t errors;
+    double throughput;
+    double p50_us;
+    double p99_us;
+} Summary;
+
+// kind == -1 summarizes every sample
+static Summary summarize(ClientRun* runs, int clients, int kind, double seconds) {
+    Summary summary = { 0, 0, 0, 0, 0 };
+    size_t total = 0;
+    for (int c = 0; c < clients; c++)
+        total += runs[c].num_samples;
+    unsigned long long* latencies = malloc((total + 1) * sizeof(unsigned long long));
+    for (int c = 0; c < clients; c++) {
+        for (size_t i = 0; i < runs[c].num_samples; i++)
+            if (kind == -1 || runs[c].samples[i].kind == kind)
+                latencies[summary.operations++] = runs[c].samples[i].nanoseconds;
+        for (int k = 0; k < num_kinds; k++)
+            if (kind == -1 || k == kind)
+                summary.errors += runs[c].errors[k];
+    }
+    qsort(latencies, summary.operations, sizeof(unsigned long long), compareSamples);
+    summary.throughput = seconds > 0 ? summary.operations / seconds : 0;
+    summary.p50_us = percentile(latencies, summary.operations, 0.50);
+    summary.p99_us = percentile(latencies, summary.operations, 0.99);
+    free(latencies);
+    return summary;
+}
+
+static void printSummary(const Summary* summary, const char* indent) {
+    printf("%s\"operations\": %zu,\n", indent, summary->operations);
+    printf("%s\"errors\": %zu,\n", indent, summary->errors);
+    printf("%s\"throughput\": %.1f,\n", indent, summary->throughput);
+    printf("%s\"p50_us\": %.1f,\n", indent, summary->p50_us);
+    printf("%s\"p99_us\": %.1f", indent, summary->p99_us);
+}
+
+static char* readFile(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL)
+        return NULL;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char* text = malloc(size + 1);
+    if (text != NULL) {
+        size = fread(text, 1, size, fp);
+        text[size] = '\0';
+    }
+    fclose(fp);
+    return text;
+}
+
+// looks up "key" in the top level of a result (kind == NULL) or in the
+// object of one kind. Only understands the layout printed above.
+static bool baselineValue(const char* text, const char* kind, const char* key, double* value) {
+    const char* start = text;
+    const char* end = strstr(text, "\"kinds\"");
+    if (end == NULL)
+        return false;
+    if (kind != NULL) {
+        char name[MAX_KIND_LENGTH + 4];
+        sprintf(name, "\"%s\":", kind);
+        if ((start = strstr(end, name)) == NULL || (end = strchr(start, '}')) == NULL)
+            return false;
+    }
+    char name[32];
+    sprintf(name, "\"%s\":", key);
+    const char* found = strstr(start, name);
+    if (found == NULL || found > end)
+        return false;
+    *value = strtod(found + strlen(name), NULL);
+    return true;
+}
+
+// prints every regression beyond tolerance percent to stderr
+static int compareSummary(const char* baseline, const char* kind, const Summary* summary, double tolerance) {
+    const char* label = kind == NULL ? "total" : kind;
+    int regressions = 0;
+    double value;
+    if (baselineValue(baseline, kind, "throughput", &value)
+            && summary->throughput < value * (1 - tolerance / 100)) {
+        fprintf(stderr, "regression: %s throughput %.1f/s, baseline %.1f/s\n", label, summary->throughput, value);
+        regressions++;
+    }
+    if (baselineValue(baseline, kind, "p99_us", &value)
+            && summary->p99_us > value * (1 + tolerance / 100)) {
+        fprintf(stderr, "regression: %s p99 %.1fus, baseline %.1fus\n", label, summary->p99_us, value);
+        regressions++;
+    }
+    return regressions;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [options] workload\n"
+        "  -c clients     concurrent clients (default 1)\n"
+        "  -n count       operations per client (default %d)\n"
+        "  -t seconds     run for this long instead of a fixed count\n"
+        "  -m max         placeholder values are drawn from [0, max) (default %d)\n"
+        "  -w width       width of {lo}..{hi} ranges (default max / 100)\n"
+        "  -S seed        random seed (default 1)\n"
+        "  -b baseline    compare against a previous result\n"
+        "  -T tolerance   allowed regression against the baseline in percent (default %.0f)\n",
+        name, DEFAULT_COUNT, DEFAULT_MAX, DEFAULT_TOLERANCE);
+}
+
+int main(int argc, char** argv) {
+    int clients = 1;
+    unsigned long long seed = 1;
+    const char* baseline_path = NULL;
+    double tolerance = DEFAULT_TOLERANCE;
+    range_width = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:t:m:w:S:b:T:")) != -1) {
+        switch (opt) {
+            case 'c':
+                clients = atoi(optarg);
+                break;
+            case 'n':
+                count = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                duration = atof(optarg);
+                break;
+            case 'm':
+                max_value = atol(optarg);
+                break;
+            case 'w':
+                range_width = atol(optarg);
+                break;
+            case 'S':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'b':
+                baseline_path = optarg;
+                break;
+            case 'T':
+                tolerance = atof(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || clients < 1 || max_value < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (range_width < 0)
+        range_width = max_value / 100;
+    if (range_width > max_value)
+        range_width = max_value;
+    if (!readWorkload(argv[optind]))
+        return 1;
+
+    ClientRun* runs = calloc(clients, sizeof(ClientRun));
+    unsigned long long start = now();
+    deadline = start + (unsigned long long) (duration * 1e9);
+    for (int c = 0; c < clients; c++) {
+        runs[c].id = c;
+        runs[c].state = seed * 0x9E3779B97F4A7C15ULL + c + 1;
+        runs[c].errors = calloc(num_kinds, sizeof(size_t));
+        pthread_create(&runs[c].thread, NULL, runClient, &runs[c]);
+    }
+    bool failed = false;
+    for (int c = 0; c < clients; c++) {
+        pthread_join(runs[c].thread, NULL);
+        failed = failed || runs[c].failed;
+    }
+    double seconds = (now() - start) / 1e9;
+
+    char* baseline = NULL;
+    if (baseline_path != NULL && (baseline = readFile(baseline_path)) == NULL) {
+        perror("benchmark");
+        return 1;
+    }
+    int regressions = 0;
+    Summary total = summarize(runs, clients, -1, seconds);
+    printf("{\n");
+    printf("  \"clients\": %d,\n", clients);
+    printf("  \"seconds\": %.3f,\n", seconds);
+    printSummary(&total, "  ");
+    printf(",\n  \"kinds\": {\n");
+    if (baseline != NULL)
+        regressions += compareSummary(baseline, NULL, &total, tolerance);
+    for (int k = 0; k < num_kinds; k++) {
+        Summary summary = summarize(runs, clients, k, seconds);
+        printf("    \"%s\": {\n", kinds[k]);
+        printSummary(&summary, "      ");
+        printf("\n    }%s\n", k + 1 < num_kinds ? "," : "");
+        if (baseline != NULL)
+            regressions += compareSummary(baseline, kinds[k], &summary, tolerance);
+    }
+    printf("  }\n}\n");
+
+    for (int c = 0; c < clients; c++) {
+        free(runs[c].samples);
+        free(runs[c].errors);
+    }
+    free(runs);
+    free(baseline);
+    if (failed)
+        return 1;
+    return regressions > 0 ? 2 : 0;
+}
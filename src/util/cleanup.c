@@ -1,18 +1,51 @@
 #include <string.h>
 
+#include "api/btree.h"
 #include "api/cs165.h"
+#include "api/cracker.h"
 #include "api/db_io.h"
 #include "util/cleanup.h"
 #include "util/log.h"
 
 extern Db* current_db;
 
+// frees an index object and whatever of its structure was built
+void freeIndex(Index* index) {
+    if (index == NULL)
+        return;
+    if (index->object != NULL) {
+        if (index->type == BTREE && index->clustered && index->object->btreec != NULL)
+            destroyBTreeC(index->object->btreec);
+        else if (index->type == BTREE && !index->clustered && index->object->btreeu != NULL)
+            destroyBTreeU(index->object->btreeu);
+        else if (index->type == SORTED && index->object->column != NULL) {
+            ColumnIndex* cindex = index->object->column;
+            for (size_t k = 0; cindex->keys != NULL && k < index->num_keys; k++)
+                free(cindex->keys[k].data);
+            for (size_t k = 0; cindex->payloads != NULL && k < index->num_included; k++)
+                free(cindex->payloads[k].data);
+            free(cindex->keys);
+            free(cindex->payloads);
+            free(cindex->values);
+            free(cindex->indexes);
+            free(cindex);
+        }
+        free(index->object);
+    }
+    free(index->keys);
+    free(index->included);
+    free(index);
+}
+
 // frees a table object
 void freeTable(Table* tbl) {
     if (tbl == NULL)
         return;
-    for (size_t i = 0, count = tbl->col_count; i < count; i++)
+    for (size_t i = 0, count = tbl->col_count; i < count; i++) {
+        free(tbl->columns[i]->stats);
+        freeCracker(tbl->columns[i]->cracker);
         free(tbl->columns[i]);
+    }
     free(tbl);
 }
 
@@ -1,5 +1,7 @@
+#include <stdint.h>
 #include <string.h>
 
+#include "api/column.h"
 #include "util/debug.h"
 #include "util/log.h"
 
@@ -79,6 +81,10 @@ void printDbOperator(DbOperator* query) {
             }
             log_info("\t    MIN: %i\n", fields.select.minimum);
             log_info("\t    MAX: %i\n", fields.select.maximum);
+            for (size_t i = 0; i < fields.select.num_conjuncts; i++) {
+                SelectPredicate* conjunct = &fields.select.conjuncts[i];
+                log_info("\t    AND %s IN [%ld, %ld)\n", conjunct->col_name, conjunct->minimum, conjunct->maximum);
+            }
             break;
         case OP_PRINT:
             log_info("\tType: PRINT\n");
@@ -95,7 +101,10 @@ void printDbOperator(DbOperator* query) {
             log_info("\t    TARGET: %s\n", fields.fetch.target);
             break;
         case OP_BATCH:
-            log_info("\tType: BATCH %s\n", fields.batch.start ? "START" : "EXECUTE");
+            if (fields.batch.queued.statement != NULL)
+                log_info("\tType: BATCH QUEUE %s\n", fields.batch.queued.text);
+            else
+                log_info("\tType: BATCH %s\n", fields.batch.start ? "START" : "EXECUTE");
             break;
         case OP_MATH:
             log_info("\tType: MATH\n");
@@ -105,9 +114,63 @@ void printDbOperator(DbOperator* query) {
             }
             log_info("\t    First arg is var: %i\n", fields.math.is_var);
             break;
+        case OP_AGGREGATE:
+            log_info("\tType: AGGREGATE\n");
+            for (size_t i = 0; i < fields.aggregate.num_aggregates; i++) {
+                log_info("\t    %s: MathType %i\n", fields.aggregate.handles[i], fields.aggregate.types[i]);
+            }
+            for (size_t i = 0; i < fields.aggregate.num_params; i++) {
+                log_info("\t    PARAM%i:%s\n", i, fields.aggregate.params[i]);
+            }
+            if (fields.aggregate.selection != NULL)
+                log_info("\t    Selection: %s\n", fields.aggregate.selection);
+            break;
+        case OP_GROUP_BY:
+            log_info("\tType: GROUP BY\n");
+            log_info("\t    Keys: %s -> %s\n", fields.group_by.keys, fields.group_by.key_handle);
+            for (size_t i = 0; i < fields.group_by.num_aggregates; i++) {
+                log_info("\t    %s: MathType %i of %s\n", fields.group_by.handles[i],
+                    fields.group_by.types[i], fields.group_by.values[i]);
+            }
+            break;
+        case OP_PREPARE:
+            log_info("\tType: PREPARE\n");
+            log_info("\t    Name: %s\n", fields.prepare.name);
+            printDbOperator(fields.prepare.statement);
+            break;
+        case OP_EXECUTE:
+            log_info("\tType: EXECUTE\n");
+            log_info("\t    Name: %s\n", fields.execute.name);
+            for (size_t i = 0; i < fields.execute.num_args; i++) {
+                log_info("\t    ARG%i: %ld\n", i, fields.execute.args[i]);
+            }
+            break;
+        case OP_STATS:
+            log_info("\tType: STATS\n");
+            if (fields.stats.path != NULL)
+                log_info("\t    Path: %s\n", fields.stats.path);
+            break;
+        case OP_EXPLAIN:
+            log_info("\tType: EXPLAIN\n");
+            printDbOperator(fields.explain.statement);
+            break;
+        case OP_ANALYZE:
+            log_info("\tType: ANALYZE\n");
+            log_info("\t    Table: %s.%s\n", fields.analyze.db_name, fields.analyze.tbl_name);
+            break;
+        case OP_COMBINE:
+            log_info("\tType: %s\n", fields.combine.conjunctive ? "AND" : "OR");
+            log_info("\t    Selections: %s, %s\n", fields.combine.left, fields.combine.right);
+            log_info("\t    Handle: %s\n", fields.combine.handle);
+            break;
         case OP_JOIN:
             log_info("\tType: JOIN\n");
             log_info("\t    Handles: %s, %s\n", fields.join.handle1, fields.join.handle2);
+            if (fields.join.type == INDEX) {
+                log_info("\t    Outer: %s, %s\n", fields.join.fetch1, fields.join.select1);
+                log_info("\t    Index on: %s.%s.%s\n", fields.join.inner[0], fields.join.inner[1], fields.join.inner[2]);
+                break;
+            }
             log_info("\t    Fetches: %s, %s\n", fields.join.fetch1, fields.join.fetch2);
             log_info("\t    Selects: %s, %s\n", fields.join.select1, fields.join.select2);
             break;
@@ -162,12 +225,14 @@ void printTable(Table* tbl, char* prefix) {
 /* Prints a description of a Column object. */
 void printColumn(Column* col, char* prefix, size_t nvals) {
     log_info("%sName: %s\n", prefix, col->name);
+    log_info("%sType: %s\n", prefix, dataTypeName(col->type));
     if (nvals == 0) {
         log_info("%sNo values\n", prefix);
     }
     log_info("%sValues at %p: [ ", prefix, col->data);
-    for (size_t i = 0; i < nvals; i++) {
-        log_info("%i ", col->data[i]);
+    long value;
+    for (size_t i = 0; i < nvals && readValue(col, i, &value); i++) {
+        log_info("%ld ", value);
     }
     log_info("]\n");
 }
@@ -215,16 +280,9 @@ void printContext(ClientContext* context) {
     log_info("    Batched queries: %s\n", context->queries == NULL ? "none" : "exist");
     if (context->queries != NULL) {
         BatchedQueries* queries = context->queries;
-        log_info("    # queries: %i\n", queries->num_queries);
-        log_info("    Column: %s\n", queries->column->name);
-        log_info("    Mins: [ ");
-        for (int i = 0; i < queries->num_queries; i++)
-            log_info("%i ", queries->minimum[i]);
-        log_info("]\n");
-        log_info("    Maxs: [ ");
-        for (int i = 0; i < queries->num_queries; i++)
-            log_info("%i ", queries->maximum[i]);
-        log_info("]\n");
+        log_info("    # queued statements: %zu\n", queries->num_statements);
+        for (size_t i = 0; i < queries->num_statements; i++)
+            log_info("    -> %s\n", queries->statements[i].text);
     }
     log_info("    # handles: %i\n", context->chandles_in_use);
     log_info("    capacity:  %i\n", context->chandle_slots);
@@ -239,6 +297,17 @@ void printContext(ClientContext* context) {
                 log_info("         Type: RESULT\n");
                 log_info("         # tuples: %i\n", result->num_tuples);
                 switch (result->data_type) {
+                    case BYTE:
+                    case SHORT: {
+                        log_info("         Data type: %s\n", dataTypeName(result->data_type));
+                        log_info("         Values: [ ");
+                        for (size_t j = 0; j < result->num_tuples; j++) {
+                            long value = (result->data_type == BYTE) ? ((int8_t*) result->payload)[j] : ((int16_t*) result->payload)[j];
+                            log_info("%ld ", value);
+                        }
+                        log_info("]\n");
+                        break;
+                    }
                     case INT: {
                         log_info("         Data type: INT\n");
                         log_info("         Values: [ ");
@@ -0,0 +1,261 @@
+#define _XOPEN_SOURCE 600
+/**
+ * generate.c
+ *
+ * Synthetic data generator for the benchmark harness. Writes a table in the
+ * format load() reads: a header naming every column, then one row of
+ * comma-separated values per line. Values are drawn from [0, max) using a
+ * uniform, zipf, normal or sequential distribution; the first column can be
+ * made partially sorted to exercise sorted indexes and clustering.
+ *
+ * With -f the table goes to a file and the DSL that creates and loads it is
+ * printed instead, so the output can be piped straight into ./client.
+ **/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#define DEFAULT_ROWS 100000
+#define DEFAULT_COLUMNS 4
+// the zipf cdf is tabulated over at most this many ranks; larger domains
+// spread each rank evenly over the values it covers
+#define ZIPF_MAX_RANKS (1 << 22)
+
+typedef enum Distribution {
+    UNIFORM,
+    ZIPF,
+    NORMAL,
+    SEQUENTIAL
+} Distribution;
+
+typedef struct Generator {
+    Distribution distribution;
+    long max;
+    double skew;
+    unsigned long long state;
+    double* zipf_cdf;
+    long zipf_ranks;
+} Generator;
+
+// xorshift64*: cheap and identical on every platform, so a seed always
+// produces the same table
+static unsigned long long nextRandom(Generator* gen) {
+    gen->state ^= gen->state >> 12;
+    gen->state ^= gen->state << 25;
+    gen->state ^= gen->state >> 27;
+    return gen->state * 2685821657736338717ULL;
+}
+
+// uniform double in [0, 1)
+static double nextUniform(Generator* gen) {
+    return (nextRandom(gen) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int setupZipf(Generator* gen) {
+    gen->zipf_ranks = gen->max < ZIPF_MAX_RANKS ? gen->max : ZIPF_MAX_RANKS;
+    gen->zipf_cdf = malloc(gen->zipf_ranks * sizeof(double));
+    if (gen->zipf_cdf == NULL)
+        return -1;
+    double total = 0;
+    for (long i = 0; i < gen->zipf_ranks; i++) {
+        total += 1.0 / pow((double) (i + 1), gen->skew);
+        gen->zipf_cdf[i] = total;
+    }
+    for (long i = 0; i < gen->zipf_ranks; i++)
+        gen->zipf_cdf[i] /= total;
+    return 0;
+}
+
+static long nextZipf(Generator* gen) {
+    double u = nextUniform(gen);
+    long low = 0;
+    long high = gen->zipf_ranks - 1;
+    while (low < high) {
+        long mid = (low + high) / 2;
+        if (gen->zipf_cdf[mid] < u)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    long span = gen->max / gen->zipf_ranks;
+    if (span <= 1)
+        return low;
+    return low * span + (long) (nextRandom(gen) % span);
+}
+
+static long nextValue(Generator* gen, size_t row) {
+    switch (gen->distribution) {
+        case ZIPF:
+            return nextZipf(gen);
+        case NORMAL: {
+            // Box-Muller, centered on the domain with 99.7% of it within 3 sigma
+            double u1 = nextUniform(gen);
+            double u2 = nextUniform(gen);
+            double z = sqrt(-2.0 * log(1.0 - u1)) * cos(2.0 * M_PI * u2);
+            long value = (long) (gen->max / 2.0 + z * gen->max / 6.0);
+            if (value < 0)
+                return 0;
+            return value >= gen->max ? gen->max - 1 : value;
+        }
+        case SEQUENTIAL:
+            return (long) (row % gen->max);
+        default:
+            return (long) (nextRandom(gen) % gen->max);
+    }
+}
+
+static int compareLongs(const void* a, const void* b) {
+    long x = *(const long*) a;
+    long y = *(const long*) b;
+    return (x > y) - (x < y);
+}
+
+// sorts the column, then swaps random pairs until roughly (1 - sortedness)
+// of the rows are out of place
+static void applySortedness(Generator* gen, long* values, size_t rows, double sortedness) {
+    if (sortedness <= 0 || rows < 2)
+        return;
+    qsort(values, rows, sizeof(long), compareLongs);
+    size_t swaps = (size_t) (rows * (1.0 - sortedness) / 2);
+    for (size_t i = 0; i < swaps; i++) {
+        size_t a = nextRandom(gen) % rows;
+        size_t b = nextRandom(gen) % rows;
+        long tmp = values[a];
+        values[a] = values[b];
+        values[b] = tmp;
+    }
+}
+
+static void writeTable(FILE* out, Generator* gen, const char* table, long* first, size_t rows, int columns) {
+    for (int c = 1; c <= columns; c++)
+        fprintf(out, "%s%s.col%d", c > 1 ? "," : "", table, c);
+    fputc('\n', out);
+    // only the first column is materialized; the rest are drawn as rows go out
+    for (size_t row = 0; row < rows; row++) {
+        fprintf(out, "%ld", first[row]);
+        for (int c = 2; c <= columns; c++)
+            fprintf(out, ",%ld", nextValue(gen, row));
+        fputc('\n', out);
+    }
+}
+
+// prints the DSL creating the table and loading file into it
+static void writeSetup(const char* table, int columns, const char* index, const char* file) {
+    const char* dot = strchr(table, '.');
+    printf("create(tbl,\"%s\",%.*s,%d)\n", dot + 1, (int) (dot - table), table, columns);
+    for (int c = 1; c <= columns; c++)
+        printf("create(col,\"col%d\",%s)\n", c, table);
+    if (index != NULL)
+        printf("create(idx,%s.col1,%s)\n", table, index);
+    printf("load(\"%s\")\n", file);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [options] db.tbl\n"
+        "  -r rows        number of rows (default %d)\n"
+        "  -c columns     number of columns (default %d)\n"
+        "  -d dist        uniform, zipf, normal or sequential (default uniform)\n"
+        "  -s skew        zipf exponent (default 1.0)\n"
+        "  -m max         values are drawn from [0, max) (default rows)\n"
+        "  -o sorted      fraction of col1 in sorted order, 0 to 1 (default 0)\n"
+        "  -x index       index on col1, e.g. btree,clustered (needs -f)\n"
+        "  -S seed        random seed (default 1)\n"
+        "  -f file        write the table to file and print the DSL loading it\n",
+        name, DEFAULT_ROWS, DEFAULT_COLUMNS);
+}
+
+int main(int argc, char** argv) {
+    size_t rows = DEFAULT_ROWS;
+    int columns = DEFAULT_COLUMNS;
+    double sortedness = 0;
+    const char* index = NULL;
+    const char* file = NULL;
+    Generator gen = { .distribution = UNIFORM, .max = 0, .skew = 1.0, .state = 1 };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:c:d:s:m:o:x:S:f:")) != -1) {
+        switch (opt) {
+            case 'r':
+                rows = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                columns = atoi(optarg);
+                break;
+            case 'd':
+                if (strcmp(optarg, "uniform") == 0)
+                    gen.distribution = UNIFORM;
+                else if (strcmp(optarg, "zipf") == 0)
+                    gen.distribution = ZIPF;
+                else if (strcmp(optarg, "normal") == 0)
+                    gen.distribution = NORMAL;
+                else if (strcmp(optarg, "sequential") == 0)
+                    gen.distribution = SEQUENTIAL;
+                else {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 's':
+                gen.skew = atof(optarg);
+                break;
+            case 'm':
+                gen.max = atol(optarg);
+                break;
+            case 'o':
+                sortedness = atof(optarg);
+                break;
+            case 'x':
+                index = optarg;
+                break;
+            case 'S':
+                gen.state = strtoull(optarg, NULL, 10);
+                break;
+            case 'f':
+                file = optarg;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || strchr(argv[optind], '.') == NULL || columns < 1 || rows == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* table = argv[optind];
+    if (gen.max <= 0)
+        gen.max = (long) rows;
+    // xorshift never leaves the all-zero state
+    if (gen.state == 0)
+        gen.state = 1;
+    if (gen.distribution == ZIPF && setupZipf(&gen) != 0) {
+        fprintf(stderr, "generate: out of memory\n");
+        return 1;
+    }
+
+    long* first = malloc(rows * sizeof(long));
+    if (first == NULL) {
+        fprintf(stderr, "generate: out of memory\n");
+        return 1;
+    }
+    for (size_t row = 0; row < rows; row++)
+        first[row] = nextValue(&gen, row);
+    applySortedness(&gen, first, rows, sortedness);
+
+    FILE* out = stdout;
+    if (file != NULL && (out = fopen(file, "w")) == NULL) {
+        perror("generate");
+        return 1;
+    }
+    writeTable(out, &gen, table, first, rows, columns);
+    if (file != NULL) {
+        fclose(out);
+        writeSetup(table, columns, index, file);
+    }
+    free(first);
+    free(gen.zipf_cdf);
+    return 0;
+}
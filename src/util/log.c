@@ -1,47 +1,45 @@
-#include <stdio.h>
-#include <stdarg.h>
-
-#include "util/log.h"
-
-#define ANSI_COLOR_RED     "\x1b[31m"
-#define ANSI_COLOR_GREEN   "\x1b[32m"
-#define ANSI_COLOR_RESET   "\x1b[0m"
-
-void cs165_log(FILE* out, const char *format, ...) {
-#ifdef LOG
-    va_list v;
-    va_start(v, format);
-    vfprintf(out, format, v);
-    va_end(v);
-#else
-    (void) out;
-    (void) format;
-#endif
-}
-
-void log_err(const char *format, ...) {
-#ifdef LOG_ERR
-    va_list v;
-    va_start(v, format);
-    fprintf(stderr, ANSI_COLOR_RED);
-    vfprintf(stderr, format, v);
-    fprintf(stderr, ANSI_COLOR_RESET);
-    va_end(v);
-#else
-    (void) format;
-#endif
-}
-
-void log_info(const char *format, ...) {
-#ifdef LOG_INFO
-    va_list v;
-    va_start(v, format);
-    // fprintf(stdout, ANSI_COLOR_GREEN);
-    vfprintf(stdout, format, v);
-    // fprintf(stdout, ANSI_COLOR_RESET);
-    fflush(stdout);
-    va_end(v);
-#else
-    (void) format;
-#endif
-}
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "util/log.h"
+
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+void cs165_log(FILE* out, const char *format, ...) {
+#ifdef LOG
+    va_list v;
+    va_start(v, format);
+    vfprintf(out, format, v);
+    va_end(v);
+#else
+    (void) out;
+    (void) format;
+#endif
+}
+
+void log_err(const char *format, ...) {
+#ifdef LOG_ERR
+    va_list v;
+    va_start(v, format);
+    fprintf(stderr, ANSI_COLOR_RED);
+    vfprintf(stderr, format, v);
+    fprintf(stderr, ANSI_COLOR_RESET);
+    va_end(v);
+#else
+    (void) format;
+#endif
+}
+
+#ifdef LOG_INFO
+void log_info(const char *format, ...) {
+    va_list v;
+    va_start(v, format);
+    // fprintf(stdout, ANSI_COLOR_GREEN);
+    vfprintf(stdout, format, v);
+    // fprintf(stdout, ANSI_COLOR_RESET);
+    fflush(stdout);
+    va_end(v);
+}
+#endif
@@ -0,0 +1,224 @@
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "util/metrics.h"
+
+typedef struct OperatorStats {
+    uint64_t statements;
+    uint64_t total_ns[NUM_PHASES];
+    uint64_t histogram[NUM_PHASES][LATENCY_BUCKETS];
+    uint64_t rows_scanned;
+    uint64_t rows_produced;
+} OperatorStats;
+
+typedef struct StatsBuffer {
+    OperatorStats operators[NUM_STATS_OPERATORS];
+    struct StatsBuffer* next;
+} StatsBuffer;
+
+// every buffer ever registered; buffers are never freed, so the counts of
+// threads that exited stay in the report
+static StatsBuffer* buffers = NULL;
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread StatsBuffer* local_buffer = NULL;
+static __thread StatsTrace* trace = NULL;
+
+static StatsBuffer* localBuffer() {
+    if (local_buffer == NULL) {
+        local_buffer = calloc(1, sizeof(StatsBuffer));
+        if (local_buffer == NULL)
+            return NULL;
+        pthread_mutex_lock(&buffers_lock);
+        local_buffer->next = buffers;
+        buffers = local_buffer;
+        pthread_mutex_unlock(&buffers_lock);
+    }
+    return local_buffer;
+}
+
+const char* statsOperatorName(int type) {
+    switch (type) {
+        case OP_CREATE: return "create";
+        case OP_INSERT: return "relational_insert";
+        case OP_SELECT: return "select";
+        case OP_PRINT: return "print";
+        case OP_FETCH: return "fetch";
+        case OP_BATCH: return "batch";
+        case OP_MATH: return "math";
+        case OP_JOIN: return "join";
+        case OP_AGGREGATE: return "aggregate";
+        case OP_GROUP_BY: return "group_by";
+        case OP_PREPARE: return "prepare";
+        case OP_EXECUTE: return "execute";
+        case OP_STATS: return "stats";
+        case OP_EXPLAIN: return "explain";
+        case OP_ANALYZE: return "analyze";
+        case OP_COMBINE: return "combine";
+        default: return "unparsed";
+    }
+}
+
+uint64_t statsNow() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static size_t latencyBucket(uint64_t nanoseconds) {
+    uint64_t microseconds = nanoseconds / 1000;
+    size_t bucket = 0;
+    while (microseconds > 0 && bucket < LATENCY_BUCKETS - 1) {
+        microseconds >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void statsRecordStatement(int type, uint64_t parse_ns, uint64_t execute_ns, uint64_t send_ns) {
+    StatsBuffer* buffer = localBuffer();
+    if (buffer == NULL || type < 0 || type >= NUM_STATS_OPERATORS)
+        return;
+    OperatorStats* stats = &buffer->operators[type];
+    uint64_t latencies[NUM_PHASES] = { parse_ns, execute_ns, send_ns };
+    stats->statements++;
+    for (int phase = 0; phase < NUM_PHASES; phase++) {
+        stats->total_ns[phase] += latencies[phase];
+        stats->histogram[phase][latencyBucket(latencies[phase])]++;
+    }
+}
+
+void statsAddRows(int type, size_t scanned, size_t produced) {
+    StatsBuffer* buffer = localBuffer();
+    if (buffer == NULL || type < 0 || type >= NUM_STATS_OPERATORS)
+        return;
+    buffer->operators[type].rows_scanned += scanned;
+    buffer->operators[type].rows_produced += produced;
+    if (trace != NULL) {
+        trace->rows_scanned += scanned;
+        trace->rows_produced += produced;
+    }
+}
+
+void statsTraceStart(StatsTrace* new_trace) {
+    memset(new_trace, 0, sizeof(StatsTrace));
+    new_trace->estimated_rows = -1;
+    new_trace->phase_start = statsNow();
+    trace = new_trace;
+}
+
+void statsTraceStop() {
+    trace = NULL;
+}
+
+void statsTraceAccess(const char* access_path, long estimated_rows) {
+    if (trace == NULL)
+        return;
+    trace->access_path = access_path;
+    trace->estimated_rows = estimated_rows;
+}
+
+void statsTracePhase(const char* name) {
+    if (trace == NULL || trace->num_phases == MAX_TRACE_PHASES)
+        return;
+    uint64_t now = statsNow();
+    trace->phase_names[trace->num_phases] = name;
+    trace->phase_ns[trace->num_phases++] = now - trace->phase_start;
+    trace->phase_start = now;
+}
+
+// upper bound, in microseconds, of the bucket holding the given quantile
+static uint64_t quantile(const uint64_t* histogram, uint64_t count, double q) {
+    uint64_t rank = (uint64_t) (q * count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen > rank)
+            return (uint64_t) 1 << i;
+    }
+    return (uint64_t) 1 << (LATENCY_BUCKETS - 1);
+}
+
+// the report is formatted into a buffer that grows as needed
+static char* report = NULL;
+static size_t report_capacity = 0;
+static size_t report_length = 0;
+
+static void appendReport(const char* format, ...) {
+    while (true) {
+        va_list args;
+        va_start(args, format);
+        size_t space = report_capacity - report_length;
+        int written = vsnprintf(report + report_length, space, format, args);
+        va_end(args);
+        if (written < 0)
+            return;
+        if ((size_t) written < space) {
+            report_length += written;
+            return;
+        }
+        size_t new_capacity = (report_capacity == 0) ? 1024 : 2 * report_capacity;
+        while (new_capacity - report_length <= (size_t) written)
+            new_capacity *= 2;
+        char* new_report = realloc(report, new_capacity);
+        if (new_report == NULL)
+            return;
+        report = new_report;
+        report_capacity = new_capacity;
+    }
+}
+
+const char* statsReport() {
+    // merge the buffers of every thread
+    OperatorStats merged[NUM_STATS_OPERATORS];
+    memset(merged, 0, sizeof(merged));
+    pthread_mutex_lock(&buffers_lock);
+    for (StatsBuffer* buffer = buffers; buffer != NULL; buffer = buffer->next) {
+        for (int type = 0; type < NUM_STATS_OPERATORS; type++) {
+            OperatorStats* from = &buffer->operators[type];
+            OperatorStats* to = &merged[type];
+            to->statements += from->statements;
+            to->rows_scanned += from->rows_scanned;
+            to->rows_produced += from->rows_produced;
+            for (int phase = 0; phase < NUM_PHASES; phase++) {
+                to->total_ns[phase] += from->total_ns[phase];
+                for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+                    to->histogram[phase][i] += from->histogram[phase][i];
+            }
+        }
+    }
+    pthread_mutex_unlock(&buffers_lock);
+
+    static const char* phase_names[NUM_PHASES] = { "parse", "execute", "send" };
+    report_length = 0;
+    appendReport("%-18s %10s %14s %14s", "operator", "statements", "rows_scanned", "rows_produced");
+    for (int phase = 0; phase < NUM_PHASES; phase++)
+        appendReport(" %10s_us %8s %8s", phase_names[phase], "p50<", "p99<");
+    appendReport("\n");
+    for (int type = 0; type < NUM_STATS_OPERATORS; type++) {
+        OperatorStats* stats = &merged[type];
+        if (stats->statements == 0)
+            continue;
+        appendReport("%-18s %10lu %14lu %14lu", statsOperatorName(type), (unsigned long) stats->statements,
+            (unsigned long) stats->rows_scanned, (unsigned long) stats->rows_produced);
+        for (int phase = 0; phase < NUM_PHASES; phase++) {
+            appendReport(" %13lu %8lu %8lu", (unsigned long) (stats->total_ns[phase] / 1000),
+                (unsigned long) quantile(stats->histogram[phase], stats->statements, 0.5),
+                (unsigned long) quantile(stats->histogram[phase], stats->statements, 0.99));
+        }
+        appendReport("\n");
+    }
+    return report;
+}
+
+bool statsDump(const char* path) {
+    const char* text = statsReport();
+    if (text == NULL)
+        return false;
+    FILE* fp = fopen(path, "w");
+    if (fp == NULL)
+        return false;
+    bool written = fputs(text, fp) >= 0;
+    return (fclose(fp) == 0) && written;
+}
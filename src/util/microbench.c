@@ -0,0 +1,351 @@
+#define _GNU_SOURCE
+/**
+ * microbench.c
+ *
+ * Microbenchmarks for the index and hashtable APIs, run in isolation from
+ * the server. For every size and key distribution it times the unclustered
+ * and clustered B+ trees, the sorted column index and the hashtable and
+ * prints one line per operation with the time per operation, the heap bytes
+ * per entry of the structure and, where perf_event_open is permitted, the
+ * hardware cache misses per operation.
+ *
+ * Inserting into a clustered tree or a sorted index shifts every later
+ * entry, so those two are built in key order and then timed on a fixed
+ * number of inserts into a structure of the given size.
+ **/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#endif
+
+#include "api/btree.h"
+#include "api/sorted.h"
+#include "api/hashtable.h"
+
+#define DEFAULT_SIZES "1000,10000,100000"
+#define DEFAULT_DISTRIBUTIONS "sequential,uniform,skewed"
+#define DEFAULT_QUERIES 10000
+#define SHIFTING_INSERTS 1000
+#define MAX_MATCHES 64
+
+typedef enum Distribution {
+    SEQUENTIAL,
+    UNIFORM,
+    SKEWED
+} Distribution;
+
+static const char* distribution_names[] = { "sequential", "uniform", "skewed" };
+
+static unsigned long long state = 1;
+static int cache_counter = -1;
+static size_t queries = DEFAULT_QUERIES;
+static double selectivity = 0.001;
+
+static unsigned long long nextRandom(void) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+// keys in [0, n); skewed keys crowd towards 0, with about half of them in
+// the lowest tenth of the domain
+static int* makeKeys(Distribution distribution, size_t n) {
+    int* keys = malloc(n * sizeof(int));
+    for (size_t i = 0; i < n; i++) {
+        switch (distribution) {
+            case SEQUENTIAL:
+                keys[i] = (int) i;
+                break;
+            case UNIFORM:
+                keys[i] = (int) (nextRandom() % n);
+                break;
+            case SKEWED: {
+                double u = (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+                keys[i] = (int) (n * pow(u, 3.3));
+                break;
+            }
+        }
+    }
+    return keys;
+}
+
+static int compareInts(const void* a, const void* b) {
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+static unsigned long long now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// bytes currently allocated from the heap
+static size_t heapBytes(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+static void openCacheCounter(void) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    cache_counter = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+// a measurement in progress
+typedef struct Measure {
+    unsigned long long start;
+    size_t heap;
+} Measure;
+
+static Measure begin(void) {
+#ifdef __linux__
+    if (cache_counter >= 0) {
+        ioctl(cache_counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(cache_counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    return (Measure) { .start = now(), .heap = heapBytes() };
+}
+
+// prints a result line; entries is the size of the structure the heap
+// growth is spread over, 0 when the operation doesn't grow it
+static void report(Measure* measure, const char* name, Distribution distribution,
+        size_t size, size_t ops, size_t entries) {
+    unsigned long long elapsed = now() - measure->start;
+    long long misses = -1;
+#ifdef __linux__
+    if (cache_counter >= 0) {
+        ioctl(cache_counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(cache_counter, &misses, sizeof(misses)) != sizeof(misses))
+            misses = -1;
+    }
+#endif
+    printf("%-16s %-10s %10zu %10zu %10.1f", name, distribution_names[distribution], size, ops,
+        (double) elapsed / ops);
+    size_t heap = heapBytes();
+    if (entries > 0 && heap >= measure->heap && measure->heap > 0)
+        printf(" %12.1f", (double) (heap - measure->heap) / entries);
+    else
+        printf(" %12s", "-");
+    if (misses >= 0)
+        printf(" %10.2f\n", (double) misses / ops);
+    else
+        printf(" %10s\n", "-");
+}
+
+// prints the heap footprint of a structure that was built untimed
+static void reportMemory(const char* name, Distribution distribution, size_t size, size_t bytes, size_t entries) {
+    if (heapBytes() == 0)
+        return;
+    printf("%-16s %-10s %10zu %10s %10s %12.1f %10s\n", name, distribution_names[distribution],
+        size, "-", "-", (double) bytes / entries, "-");
+}
+
+// random [min, max) ranges covering the selectivity of the key domain
+static void nextRange(size_t n, int* min, int* max) {
+    size_t width = (size_t) (n * selectivity) + 1;
+    *min = (int) (nextRandom() % n);
+    *max = *min + (int) width;
+}
+
+static void benchUnclustered(Distribution distribution, size_t n, const int* keys) {
+    BTreeUNode* tree = createBTreeU();
+    Measure measure = begin();
+    for (size_t i = 0; i < n; i++)
+        insertValueU(&tree, keys[i], (int) i);
+    report(&measure, "insertValueU", distribution, n, n, n);
+
+    measure = begin();
+    for (size_t q = 0; q < queries; q++) {
+        int min, max;
+        int* data = NULL;
+        nextRange(n, &min, &max);
+        findRangeU(&data, tree, min, max);
+        free(data);
+    }
+    report(&measure, "findRangeU", distribution, n, queries, 0);
+
+    measure = begin();
+    for (size_t i = 0; i < n; i++)
+        deleteValueU(&tree, keys[i], (int) i);
+    report(&measure, "deleteValueU", distribution, n, n, 0);
+    destroyBTreeU(tree);
+}
+
+static void benchClustered(Distribution distribution, size_t n, const int* keys, const int* sorted) {
+    size_t base = n > SHIFTING_INSERTS ? n - SHIFTING_INSERTS : 0;
+    BTreeCNode* tree = createBTreeC();
+    Measure measure = begin();
+    for (size_t i = 0; i < base; i++)
+        insertValueC(&tree, sorted[i]);
+    size_t heap = heapBytes();
+    measure.start = now();
+    for (size_t i = base; i < n; i++)
+        insertValueC(&tree, keys[i]);
+    report(&measure, "insertValueC", distribution, n, n - base, 0);
+    if (base > 0)
+        reportMemory("  (built)", distribution, n, heap - measure.heap, base);
+
+    measure = begin();
+    for (size_t q = 0; q < queries; q++) {
+        int min, max;
+        int* data = NULL;
+        nextRange(n, &min, &max);
+        findRangeC(&data, tree, min, max);
+        free(data);
+    }
+    report(&measure, "findRangeC", distribution, n, queries, 0);
+    destroyBTreeC(tree);
+}
+
+static void benchSorted(Distribution distribution, size_t n, const int* keys, const int* sorted) {
+    size_t base = n > SHIFTING_INSERTS ? n - SHIFTING_INSERTS : 0;
+    ColumnIndex* index;
+    Measure measure = begin();
+    initializeColumnIndex(&index, n * sizeof(int));
+    memcpy(index->values, sorted, base * sizeof(int));
+    for (size_t i = 0; i < base; i++)
+        index->indexes[i] = (int) i;
+    size_t heap = heapBytes();
+    measure.start = now();
+    for (size_t i = base; i < n; i++)
+        insertIndex(index, keys[i], (int) i, (int) i);
+    report(&measure, "insertIndex", distribution, n, n - base, 0);
+    reportMemory("  (built)", distribution, n, heap - measure.heap, n);
+
+    measure = begin();
+    for (size_t q = 0; q < queries; q++) {
+        int min, max;
+        int* data = NULL;
+        nextRange(n, &min, &max);
+        findRangeS(&data, index, (int) n, min, max);
+        free(data);
+    }
+    report(&measure, "findRangeS", distribution, n, queries, 0);
+    free(index->values);
+    free(index->indexes);
+    free(index);
+}
+
+static void benchHashTable(Distribution distribution, size_t n, const int* keys) {
+    HashTable* ht;
+    Measure measure = begin();
+    init(&ht);
+    for (size_t i = 0; i < n; i++)
+        put(ht, keys[i], (int) i);
+    report(&measure, "put", distribution, n, n, n);
+
+    int values[MAX_MATCHES];
+    measure = begin();
+    for (size_t i = 0; i < n; i++)
+        get(ht, keys[(i * 7919) % n], values, MAX_MATCHES);
+    report(&measure, "get", distribution, n, n, 0);
+    destroy(ht);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -n sizes       comma-separated structure sizes (default %s)\n"
+        "  -d dists       comma-separated key distributions: sequential, uniform, skewed\n"
+        "  -q queries     range lookups per size (default %d)\n"
+        "  -s fraction    fraction of the key domain a range covers (default 0.001)\n"
+        "  -S seed        random seed (default 1)\n",
+        name, DEFAULT_SIZES, DEFAULT_QUERIES);
+}
+
+int main(int argc, char** argv) {
+    char sizes[256] = DEFAULT_SIZES;
+    char distributions[256] = DEFAULT_DISTRIBUTIONS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:q:s:S:")) != -1) {
+        switch (opt) {
+            case 'n':
+                snprintf(sizes, sizeof(sizes), "%s", optarg);
+                break;
+            case 'd':
+                snprintf(distributions, sizeof(distributions), "%s", optarg);
+                break;
+            case 'q':
+                queries = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                selectivity = atof(optarg);
+                break;
+            case 'S':
+                state = strtoull(optarg, NULL, 10) | 1;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (queries == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    openCacheCounter();
+    if (cache_counter < 0)
+        fprintf(stderr, "microbench: perf_event_open unavailable, cache misses not counted\n");
+    printf("%-16s %-10s %10s %10s %10s %12s %10s\n",
+        "operation", "keys", "size", "ops", "ns/op", "bytes/entry", "misses/op");
+    char* size_list = sizes;
+    for (char* size_arg = strsep(&size_list, ","); size_arg != NULL; size_arg = strsep(&size_list, ",")) {
+        size_t n = strtoul(size_arg, NULL, 10);
+        if (n == 0)
+            continue;
+        char dist_copy[256];
+        strcpy(dist_copy, distributions);
+        char* dist_list = dist_copy;
+        for (char* dist = strsep(&dist_list, ","); dist != NULL; dist = strsep(&dist_list, ",")) {
+            Distribution distribution;
+            if (strcmp(dist, "sequential") == 0)
+                distribution = SEQUENTIAL;
+            else if (strcmp(dist, "uniform") == 0)
+                distribution = UNIFORM;
+            else if (strcmp(dist, "skewed") == 0)
+                distribution = SKEWED;
+            else {
+                fprintf(stderr, "microbench: unknown distribution %s\n", dist);
+                return 1;
+            }
+            int* keys = makeKeys(distribution, n);
+            int* sorted = malloc(n * sizeof(int));
+            memcpy(sorted, keys, n * sizeof(int));
+            qsort(sorted, n, sizeof(int), compareInts);
+
+            benchUnclustered(distribution, n, keys);
+            benchClustered(distribution, n, keys, sorted);
+            benchSorted(distribution, n, keys, sorted);
+            benchHashTable(distribution, n, keys);
+            free(sorted);
+            free(keys);
+        }
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -12,122 +13,233 @@
 #include "api/cs165.h"
 #include "api/context.h"
 #include "api/persist.h"
+#include "api/wal.h"
 #include "parse/parse.h"
 #include "query/execute.h"
+#include "query/sharedscan.h"
 #include "util/const.h"
 #include "util/message.h"
 #include "util/log.h"
 #include "util/debug.h"
-#include "api/btree.h"
+#include "util/metrics.h"
 
 #define DEFAULT_QUERY_BUFFER_SIZE 1024
 
-/**
- * handle_client(client_socket)
- * This is the execution routine after a client has connected.
- * It will continually listen for messages from the client and execute queries.
- **/
-void handle_client(int client_socket) {
-    int done = 0;
-    int length = 0;
-    bool shutdown = false;
+// a connected client; one waiting on a shared scan sends nothing until
+// the scan answers it
+typedef struct Session {
+    int socket;
+    ClientContext* context;
+    bool waiting;
+} Session;
 
-    log_info("Connected to socket: %d.\n", client_socket);
+static Session* sessions = NULL;
+static size_t num_sessions = 0;
+static size_t session_slots = 0;
+static bool shutting_down = false;
 
-    // Create two messages, one from which to read and one from which to receive
-    message send_message;
-    message recv_message;
+static bool openSession(int client_socket) {
+    log_info("Connected to socket: %d.\n", client_socket);
+    if (num_sessions == session_slots) {
+        size_t new_slots = (session_slots == 0) ? 8 : 2 * session_slots;
+        Session* new_sessions = realloc(sessions, sizeof(Session) * new_slots);
+        if (new_sessions == NULL)
+            return false;
+        sessions = new_sessions;
+        session_slots = new_slots;
+    }
 
     // create the client context here
     ClientContext* new_context = malloc(sizeof(ClientContext));
+    if (new_context == NULL)
+        return false;
     new_context->queries = NULL;
     new_context->chandle_table = NULL;
     new_context->chandles_in_use = 0;
     new_context->chandle_slots = 0;
     new_context->client_fd = client_socket;
+    new_context->statements = NULL;
+    new_context->statements_in_use = 0;
+    new_context->statement_slots = 0;
     insertContext(new_context);
+    sessions[num_sessions++] = (Session) { .socket = client_socket, .context = new_context, .waiting = false };
+    return true;
+}
 
-    do {
-        // receive query metadata
-        length = recv(client_socket, &recv_message, sizeof(message), 0);
-        if (length < 0) {
-            log_err("-- Client connection closed!\n");
-            break;
-        } else if (length == 0)
-            done = true;
+static Session* findSession(int client_socket) {
+    for (size_t i = 0; i < num_sessions; i++)
+        if (sessions[i].socket == client_socket)
+            return &sessions[i];
+    return NULL;
+}
 
-        // while not done
-        if (done)
-            break;
+static void closeSession(int client_socket) {
+    Session* session = findSession(client_socket);
+    if (session == NULL)
+        return;
+    log_info("Connection closed at socket %d!\n", client_socket);
+    close(client_socket);
+    // delete context; everything it changed is already in the log
+    deleteContext(session->context);
+    *session = sessions[--num_sessions];
+}
 
-        // initialize receiving buffer
-        char recv_buffer[recv_message.length];
-        length = recv(client_socket, recv_buffer, recv_message.length,0);
-        recv_message.payload = recv_buffer;
-        recv_message.payload[recv_message.length] = '\0';
-        recv_message.status = OK_DONE;
-        recv_message.length = 0;
-
-        // check for shutdown
-        if (strncmp(recv_message.payload, "shutdown", 8) == 0) {
-            log_info("-- Shutting down!\n");
-            shutdown = true;
-            break;
-        }
+/**
+ * sendResponse(client_socket, send_message, result)
+ * Sends the status and, if there is one, the payload of a response.
+ * Returns false if the client can't be reached anymore.
+ **/
+static bool sendResponse(int client_socket, message* send_message, char* result) {
+    send_message->length = strlen(result);
+#ifdef LOG_INFO
+    // print server response to send during every query
+    char* copy = malloc((strlen(result) + 1) * sizeof(char));
+    strcpy(copy, result);
+    char* ptr = copy;
+    while (*ptr != '\0') {
+        if (*ptr == '\n')
+            *ptr = ' ';
+        ptr++;
+    }
+    log_info("-- Server response: \"%s\", length %i, status %i\n", copy, send_message->length, send_message->status);
+    free(copy);
+#endif
+
+    // send status and meta of response message
+    if (send(client_socket, send_message, sizeof(message), 0) == -1) {
+        log_err("Failed to send message metadata, error %i.\n", errno);
+        return false;
+    }
 
-        log_info("-- Received query from client: %s\n", recv_message.payload);
-
-        // parse command for content
-        send_message.status = OK_DONE;
-        send_message.length = 0;
-        send_message.payload = NULL;
-        DbOperator* query = parse_command(recv_message.payload, &send_message, client_socket, new_context);
-
-        // handle query and execute
-        char* result = executeDbOperator(query, &send_message);
-        send_message.length = strlen(result);
-        // print server response to send during every query
-        char* copy = malloc((strlen(result) + 1) * sizeof(char));
-        strcpy(copy, result);
-        char* ptr = copy;
-        while (*ptr != '\0') {
-            if (*ptr == '\n')
-                *ptr = ' ';
-            ptr++;
+    // send message payload if necessary
+    if (send_message->status == OK_WAIT_FOR_RESPONSE && (int) send_message->length > 0) {
+        if (send(client_socket, result, send_message->length, 0) == -1) {
+            log_err("Failed to send message payload, error %i.\n", errno);
+            return false;
         }
-        log_info("-- Server response: \"%s\", length %i, status %i\n", copy, send_message.length, send_message.status);
+    }
+    return true;
+}
 
-        // send status and meta of response message
-        if (send(client_socket, &(send_message), sizeof(message), 0) == -1) {
-            log_err("Failed to send message metadata, error %i.\n", errno);
-            writeDb();
-            exit(1);
-        }
+// true if a client other than this one has sent something not read yet,
+// which might be a select that could share a scan
+static bool othersPending(Session* session) {
+    struct pollfd fds[num_sessions];
+    nfds_t num_fds = 0;
+    for (size_t i = 0; i < num_sessions; i++)
+        if (&sessions[i] != session && !sessions[i].waiting)
+            fds[num_fds++] = (struct pollfd) { .fd = sessions[i].socket, .events = POLLIN };
+    return num_fds > 0 && poll(fds, num_fds, 0) > 0;
+}
 
-        // send message payload if necessary
-        if (send_message.status == OK_WAIT_FOR_RESPONSE && (int) send_message.length > 0) {
-            if (send(client_socket, result, send_message.length, 0) == -1) {
-                log_err("Failed to send message payload, error %i.\n", errno);
-                writeDb();
-                exit(1);
-            }
-        }
-        
-        // print context every call
-        printContext(new_context);
+// answers a select once the shared scan it joined is done
+static void replyShared(int client_fd, message* send_message, char* result, uint64_t parse_ns, uint64_t execute_ns) {
+    Session* session = findSession(client_fd);
+    if (session == NULL)
+        return;
+    session->waiting = false;
+    uint64_t executed = statsNow();
+    bool sent = sendResponse(client_fd, send_message, result);
+    statsRecordStatement(OP_SELECT, parse_ns, execute_ns, statsNow() - executed);
+    if (!sent)
+        closeSession(client_fd);
+}
+
+/**
+ * handle_command(session)
+ * Reads one message from a client and executes it, or queues it for a
+ * shared scan. Returns false once the client is done.
+ **/
+bool handle_command(Session* session) {
+    int client_socket = session->socket;
+    int length = 0;
 
-        log_info("==============================================================");
-        log_info("==================== DONE WITH THIS QUERY ====================");
-        log_info("==============================================================\n");
-    } while (!done);
+    // Create two messages, one from which to read and one from which to receive
+    message send_message;
+    message recv_message;
 
-    log_info("Connection closed at socket %d!\n", client_socket);
-    close(client_socket);
-    // delete context and write db to file
-    deleteContext(new_context);
-    writeDb();
-    if (shutdown == true)
-        exit(0);
+    // receive query metadata
+    length = recv(client_socket, &recv_message, sizeof(message), 0);
+    if (length < 0) {
+        log_err("-- Client connection closed!\n");
+        return false;
+    } else if (length == 0)
+        return false;
+
+    // initialize receiving buffer
+    char recv_buffer[recv_message.length + 1];
+    length = recv(client_socket, recv_buffer, recv_message.length,0);
+    recv_message.payload = recv_buffer;
+    recv_message.payload[recv_message.length] = '\0';
+    recv_message.status = OK_DONE;
+    recv_message.length = 0;
+
+    // check for shutdown
+    if (strncmp(recv_message.payload, "shutdown", 8) == 0) {
+        log_info("-- Shutting down!\n");
+        shutting_down = true;
+        return false;
+    }
+
+    log_info("-- Received query from client: %s\n", recv_message.payload);
+
+    // keep the text of modifying statements, parsing consumes it; those
+    // queued in a batch are logged once batch_execute() runs them
+    bool logged = session->context->queries == NULL && walShouldLog(recv_message.payload);
+    size_t statement_size = logged ? strlen(recv_message.payload) + 1 : 1;
+    char statement[statement_size];
+    if (logged)
+        memcpy(statement, recv_message.payload, statement_size);
+
+    // parse command for content
+    uint64_t start = statsNow();
+    send_message.status = OK_DONE;
+    send_message.length = 0;
+    send_message.payload = NULL;
+    DbOperator* query = parse_command(recv_message.payload, &send_message, client_socket, session->context);
+    // the operator stays valid until the next command is parsed
+    int type = (query == NULL) ? STATS_UNPARSED : (int) query->type;
+    uint64_t parsed = statsNow();
+
+    // queued selects hold the tables and columns they read; a statement
+    // that could change or free those runs after them. A client that
+    // can't be answered is closed, which may move this one's session.
+    if (query != NULL && !readsOnly(query) && sharedSelectsQueued() > 0) {
+        runSharedScans(replyShared);
+        session = findSession(client_socket);
+    }
+
+    // a scan can wait for those of other clients while there are some to
+    // join it, or already is one; idle clients don't hold it up. The
+    // client hears back once it ran.
+    bool shareable = query != NULL && query->type == OP_SELECT && num_sessions > 1
+        && (sharedSelectsQueued() > 0 || othersPending(session));
+    if (shareable && queueSharedSelect(query, parsed - start)) {
+        session->waiting = true;
+        return true;
+    }
+
+    // handle query and execute
+    char* result = executeDbOperator(query, &send_message);
+    if (logged) {
+        if (send_message.status == OK_DONE)
+            walAppend(statement);
+        walCheckpointIfDue();
+    }
+    uint64_t executed = statsNow();
+    if (!sendResponse(client_socket, &send_message, result))
+        return false;
+    statsRecordStatement(type, parsed - start, executed - parsed, statsNow() - executed);
+
+#ifdef LOG_INFO
+    // print context every call
+    printContext(session->context);
+#endif
+
+    log_info("==============================================================");
+    log_info("==================== DONE WITH THIS QUERY ====================");
+    log_info("==============================================================\n");
+    return true;
 }
 
 int setup_server() {
@@ -173,17 +285,6 @@ int setup_server() {
 }
 
 int main(void) {
-    // BTreeUNode* node = createBTreeU();
-    // for (int i = 500; i > 0; i--) {
-    //     insertValueU(&node, i, 0);
-    //     printTreeU(node, "");
-    // }
-    // for (int i = 500; i > 0; i--) {
-    //     deleteValueU(&node, i, i - 1);
-    //     printTreeU(node, "");
-    // }
-    // exit(0);
-
     signal(SIGPIPE, SIG_IGN);
 
     // set up socket
@@ -191,8 +292,14 @@ int main(void) {
     if (server_socket < 0)
         exit(1);
 
-    // load database files
-    startupDb();
+    // load database files and replay the log on top of them; a checkpoint
+    // after a failed startup would overwrite what couldn't be read
+    if (startupDb() == false) {
+        log_err("-- Unable to load the database.\n");
+        exit(1);
+    }
+    if (walStart() == false)
+        log_err("-- Unable to open the write-ahead log.\n");
 
     // wait for a connection
     log_info("==============================================================");
@@ -201,14 +308,69 @@ int main(void) {
 
     struct sockaddr_un remote;
     socklen_t t = sizeof(remote);
-    int client_socket = 0;
+    struct pollfd* fds = NULL;
+    size_t fd_slots = 0;
+    uint64_t scan_deadline = 0;
+
+    // serve every connected client, one statement at a time
+    while (!shutting_down) {
+        if (num_sessions + 1 > fd_slots) {
+            fd_slots = 2 * (num_sessions + 1);
+            fds = realloc(fds, sizeof(struct pollfd) * fd_slots);
+            if (fds == NULL)
+                exit(1);
+        }
+        size_t num_fds = 0;
+        fds[num_fds++] = (struct pollfd) { .fd = server_socket, .events = POLLIN };
+        for (size_t i = 0; i < num_sessions; i++)
+            if (!sessions[i].waiting)
+                fds[num_fds++] = (struct pollfd) { .fd = sessions[i].socket, .events = POLLIN };
+
+        // queued selects wait out their window for more to join
+        int timeout = -1;
+        if (sharedSelectsQueued() > 0) {
+            uint64_t now = statsNow();
+            timeout = (now < scan_deadline) ? (int) ((scan_deadline - now + 999999) / 1000000) : 0;
+        }
+        if (poll(fds, num_fds, timeout) < 0) {
+            if (errno == EINTR)
+                continue;
+            log_err("Failed to wait for clients, error %i.\n", errno);
+            break;
+        }
+
+        for (size_t i = 1; i < num_fds && !shutting_down; i++) {
+            if (fds[i].revents == 0)
+                continue;
+            // a shared scan run for an earlier client may have closed it
+            Session* session = findSession(fds[i].fd);
+            if (session == NULL)
+                continue;
+            size_t queued = sharedSelectsQueued();
+            if (!handle_command(session))
+                closeSession(fds[i].fd);
+            else if (queued == 0 && sharedSelectsQueued() > 0)
+                scan_deadline = statsNow() + (uint64_t) SHARED_SCAN_WINDOW_MS * 1000000;
+        }
+        if ((fds[0].revents & POLLIN) && !shutting_down) {
+            int client_socket = accept(server_socket, (struct sockaddr *)&remote, &t);
+            if (client_socket != -1 && !openSession(client_socket))
+                close(client_socket);
+        }
 
-    // block until we get a connection
-    while ((client_socket = accept(server_socket, (struct sockaddr *)&remote, &t)) != -1) {
-        // handle incoming connection
-        handle_client(client_socket);
+        // run the scans once their window closes, or as soon as no client
+        // could join them anymore
+        size_t num_waiting = 0;
+        for (size_t i = 0; i < num_sessions; i++)
+            num_waiting += sessions[i].waiting;
+        if (sharedSelectsQueued() > 0 && (shutting_down || statsNow() >= scan_deadline || num_waiting == num_sessions))
+            runSharedScans(replyShared);
     }
 
-    return 0;
+    // the client that asked for the shutdown is gone already
+    while (num_sessions > 0)
+        closeSession(sessions[0].socket);
+    walCheckpoint();
+    exit(0);
 }
 